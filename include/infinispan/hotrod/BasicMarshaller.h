@@ -6,7 +6,8 @@
 #include <cstring>
 #include <iostream>
 #include <type_traits>
-#include "infinispan/hotrod/Marshaller.h"
+#include "infinispan/hotrod/BufferMarshaller.h"
+#include "infinispan/hotrod/exceptions.h"
 
 namespace infinispan {
 namespace hotrod {
@@ -15,41 +16,42 @@ namespace hotrod {
  * A marshaller that works with very simple object types: all the trivially copiable object,
  * plus a specialization for std::string.
  */
-template <class T> class BasicMarshaller : public infinispan::hotrod::Marshaller<T>
+template <class T> class BasicMarshaller : public infinispan::hotrod::BufferMarshaller<T>
 {
       public:
-        void marshall(const T& s, std::vector<char>& b) {
+        void marshallInto(const T& s, std::vector<char>& b) {
 #if __GNUG__ && __GNUC__ < 5
             static_assert(std::is_fundamental<T>::value, "Type is not fundamental. A marshaller specialization is needed");
 #else
             static_assert(std::is_trivially_copyable<T>::value, "Type is not trivially_copyable. A marshaller specialization is needed");
 #endif
-            b.resize(sizeof(s));
-            std::memcpy(b.data(), &s, sizeof(s));
+            const char* p = reinterpret_cast<const char*>(&s);
+            b.insert(b.end(), p, p + sizeof(s));
         }
-        T* unmarshall(const std::vector<char>& b) {
+        void unmarshallInto(const char* data, size_t size, T& s) {
 #if __GNUG__ && __GNUC__ < 5
             static_assert(std::is_fundamental<T>::value, "Type is not trivially_copyable. A marshaller specialization is needed");
 #else
             static_assert(std::is_trivially_copyable<T>::value, "Type is not trivially_copyable. A marshaller specialization is needed");
 #endif
-            T* s = new T();
-            std::memcpy(s, b.data(), sizeof(*s));
-            return s;
+            if (size != sizeof(T)) {
+                throw HotRodClientException("BasicMarshaller: " + std::to_string(size) + " bytes can't be unmarshalled into a "
+                        + std::to_string(sizeof(T)) + " bytes type");
+            }
+            std::memcpy(&s, data, sizeof(s));
         }
 };
 
 // Specialization for std::string:
 
 template <>
-class BasicMarshaller<std::string> : public infinispan::hotrod::Marshaller<std::string> {
+class BasicMarshaller<std::string> : public infinispan::hotrod::BufferMarshaller<std::string> {
   public:
-    void marshall(const std::string& s, std::vector<char>& b) {
-        b.assign(s.data(), s.data()+s.size());
+    void marshallInto(const std::string& s, std::vector<char>& b) {
+        b.insert(b.end(), s.data(), s.data()+s.size());
     }
-    std::string* unmarshall(const std::vector<char>& b) {
-        std::string* s = new std::string(b.data(), b.size());
-        return s;
+    void unmarshallInto(const char* data, size_t size, std::string& s) {
+        s.assign(data, size);
     }
 };
 
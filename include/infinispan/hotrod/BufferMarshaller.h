@@ -0,0 +1,173 @@
+#ifndef ISPN_HOTROD_BUFFERMARSHALLER_H
+#define ISPN_HOTROD_BUFFERMARSHALLER_H
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "infinispan/hotrod/Marshaller.h"
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * ScratchBuffer leases a byte buffer from a per thread pool and gives it back on destruction.
+ * Buffers keep their capacity between leases, so a steady state of leases doesn't allocate.
+ * Leases can be nested, every active lease owns a distinct buffer.
+ */
+class ScratchBuffer
+{
+  public:
+    ScratchBuffer() : buffer(acquire()) {}
+    ~ScratchBuffer() { release(buffer); }
+
+    std::vector<char>& get() { return buffer; }
+
+  private:
+    ScratchBuffer(const ScratchBuffer&);
+    ScratchBuffer& operator=(const ScratchBuffer&);
+
+    // Pooling stops at these limits, beyond them buffers are simply freed
+    static const size_t MaxPooledBuffers = 8;
+    static const size_t MaxPooledCapacity = 1024 * 1024;
+
+    static std::vector<std::vector<char> >& pool() {
+        static thread_local std::vector<std::vector<char> > buffers;
+        return buffers;
+    }
+
+    static std::vector<char> acquire() {
+        std::vector<std::vector<char> >& buffers = pool();
+        if (buffers.empty()) {
+            return std::vector<char>();
+        }
+        std::vector<char> b(std::move(buffers.back()));
+        buffers.pop_back();
+        b.clear();
+        return b;
+    }
+
+    static void release(std::vector<char>& b) {
+        std::vector<std::vector<char> >& buffers = pool();
+        if (buffers.size() < MaxPooledBuffers && b.capacity() <= MaxPooledCapacity) {
+            buffers.push_back(std::move(b));
+        }
+    }
+
+    std::vector<char> buffer;
+};
+
+/**
+ * BufferMarshaller is the second generation marshaller interface. It appends the marshalled
+ * form to a caller provided buffer and unmarshalls from a (data, size) view into existing storage,
+ * so no vector and no heap object is needed per call.
+ *
+ * A BufferMarshaller is also a Marshaller, so it can be used anywhere a Marshaller is expected.
+ */
+template <class T> class BufferMarshaller : public Marshaller<T>
+{
+  public:
+    /**
+     * Append the representation of obj to buff. The existing content of buff is preserved.
+     *
+     * \param obj the object to marshall
+     * \param buff the buffer to append to
+     */
+    virtual void marshallInto(const T& obj, std::vector<char>& buff) = 0;
+    /**
+     * Rebuild an object from its representation, overwriting obj.
+     *
+     * \param data the first byte of the representation
+     * \param size the length of the representation
+     * \param obj the object to be overwritten
+     */
+    virtual void unmarshallInto(const char* data, size_t size, T& obj) = 0;
+
+    /**
+     * Rebuild an object from its representation and return it by value.
+     */
+    T unmarshallValue(const char* data, size_t size) {
+        T obj;
+        unmarshallInto(data, size, obj);
+        return obj;
+    }
+
+    void marshall(const T& obj, std::vector<char>& buff) {
+        buff.clear();
+        marshallInto(obj, buff);
+    }
+
+    T* unmarshall(const std::vector<char>& buff) {
+        std::unique_ptr<T> obj(new T());
+        unmarshallInto(buff.data(), buff.size(), *obj);
+        return obj.release();
+    }
+
+    virtual ~BufferMarshaller() {}
+};
+
+/**
+ * Append the representation of obj to buff with any marshaller. First generation
+ * marshallers go through a pooled scratch buffer.
+ */
+template <class T> void marshallInto(Marshaller<T>& marshaller, const T& obj, std::vector<char>& buff)
+{
+    BufferMarshaller<T>* bm = dynamic_cast<BufferMarshaller<T>*>(&marshaller);
+    if (bm != nullptr) {
+        bm->marshallInto(obj, buff);
+    } else if (buff.empty()) {
+        marshaller.marshall(obj, buff);
+    } else {
+        ScratchBuffer scratch;
+        marshaller.marshall(obj, scratch.get());
+        buff.insert(buff.end(), scratch.get().begin(), scratch.get().end());
+    }
+}
+
+/**
+ * Overwrite obj with the object represented by buff with any marshaller. First generation
+ * marshallers still create a heap object, which is moved into obj and freed.
+ *
+ * \return false if the marshaller didn't produce an object, in which case obj is untouched
+ */
+template <class T> bool unmarshallInto(Marshaller<T>& marshaller, const std::vector<char>& buff, T& obj)
+{
+    BufferMarshaller<T>* bm = dynamic_cast<BufferMarshaller<T>*>(&marshaller);
+    if (bm != nullptr) {
+        bm->unmarshallInto(buff.data(), buff.size(), obj);
+        return true;
+    }
+    std::unique_ptr<T> p(marshaller.unmarshall(buff));
+    if (!p) {
+        return false;
+    }
+    obj = std::move(*p);
+    return true;
+}
+
+/**
+ * BufferMarshallerAdapter exposes a first generation Marshaller through the BufferMarshaller
+ * interface. The adapted marshaller must outlive the adapter.
+ */
+template <class T> class BufferMarshallerAdapter : public BufferMarshaller<T>
+{
+  public:
+    explicit BufferMarshallerAdapter(Marshaller<T>& m) : marshaller(m) {}
+
+    void marshallInto(const T& obj, std::vector<char>& buff) {
+        infinispan::hotrod::marshallInto(marshaller, obj, buff);
+    }
+
+    void unmarshallInto(const char* data, size_t size, T& obj) {
+        ScratchBuffer scratch;
+        scratch.get().assign(data, data + size);
+        infinispan::hotrod::unmarshallInto(marshaller, scratch.get(), obj);
+    }
+
+  private:
+    Marshaller<T>& marshaller;
+};
+
+}} // namespace
+
+#endif  /* ISPN_HOTROD_BUFFERMARSHALLER_H */
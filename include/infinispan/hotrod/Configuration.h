@@ -18,6 +18,16 @@
 namespace infinispan {
 namespace hotrod {
 
+/**
+ * Enumeration of the policies choosing which owner of a key serves a read. Writes always go to
+ * the primary owner.
+ */
+enum ReadRoutingPolicy {
+    PRIMARY_OWNER=0,           /*!< Reads go to the primary owner, as writes do. */
+    RANDOM_OWNER=1,            /*!< Reads go to a random owner, spreading hot segments over their backups. */
+    LEAST_OUTSTANDING_OWNER=2  /*!< Reads go to the owner with the fewest requests in progress from this client. */
+};
+
 /**
  * Configuration object along with its builder represent
  * the preferred approach of configuring RemoteCacheManager. Usually applications configure
@@ -53,7 +63,8 @@ class Configuration
             int _maxRetries,
             NearCacheConfiguration _nearCacheConfiguration,
             FailOverRequestBalancingStrategy::ProducerFn bsp=0,
-			const event::EventMarshaller &eventMarshaller = event::JBasicEventMarshaller(), bool transactional=false):
+			const event::EventMarshaller &eventMarshaller = event::JBasicEventMarshaller(), bool transactional=false,
+            ReadRoutingPolicy _readRoutingPolicy=PRIMARY_OWNER):
                 protocolVersion(_protocolVersion), protocolVersionPtr(),
                 connectionPoolConfiguration(_connectionPoolConfiguration),
                 connectionTimeout(_connectionTimeout), forceReturnValue(_forceReturnValue),
@@ -61,7 +72,7 @@ class Configuration
                 serversMap(_serversConfiguration),
                 socketTimeout(_socketTimeout), securityConfiguration(_sslConfiguration),tcpNoDelay(_tcpNoDelay),
                 valueSizeEstimate(_valueSizeEstimate), maxRetries(_maxRetries), nearCacheConfiguration(_nearCacheConfiguration), balancingStrategyProducer(bsp),
-				eventMarshaller(eventMarshaller), transactional(transactional)
+				eventMarshaller(eventMarshaller), transactional(transactional), readRoutingPolicy(_readRoutingPolicy)
     {}
 
     Configuration(const std::string &_protocolVersion,
@@ -77,7 +88,8 @@ class Configuration
             int _maxRetries,
             NearCacheConfiguration _nearCacheConfiguration,
             FailOverRequestBalancingStrategy::ProducerFn bsp=0,
-            const event::EventMarshaller &eventMarshaller = event::JBasicEventMarshaller(), bool transactional=false):
+            const event::EventMarshaller &eventMarshaller = event::JBasicEventMarshaller(), bool transactional=false,
+            ReadRoutingPolicy _readRoutingPolicy=PRIMARY_OWNER):
                 protocolVersion(_protocolVersion), protocolVersionPtr(),
                 connectionPoolConfiguration(_connectionPoolConfiguration),
                 connectionTimeout(_connectionTimeout), forceReturnValue(_forceReturnValue),
@@ -85,7 +97,7 @@ class Configuration
                 serversMap(_serversConfiguration),
                 socketTimeout(_socketTimeout), securityConfiguration(_securityConfiguration),tcpNoDelay(_tcpNoDelay),
                 valueSizeEstimate(_valueSizeEstimate), maxRetries(_maxRetries), nearCacheConfiguration(_nearCacheConfiguration), balancingStrategyProducer(bsp),
-                eventMarshaller(eventMarshaller), transactional(transactional)
+                eventMarshaller(eventMarshaller), transactional(transactional), readRoutingPolicy(_readRoutingPolicy)
     {}
 
 
@@ -198,6 +210,8 @@ class Configuration
 
     void setTransactional(bool transactional) { this->transactional = transactional; }
 
+    ReadRoutingPolicy getReadRoutingPolicy() const { return readRoutingPolicy; }
+
 private:
     std::string protocolVersion;
     std::shared_ptr<std::string> protocolVersionPtr;
@@ -215,6 +229,7 @@ private:
     FailOverRequestBalancingStrategy::ProducerFn balancingStrategyProducer;
     const event::EventMarshaller &eventMarshaller;
     bool transactional;
+    ReadRoutingPolicy readRoutingPolicy;
 
     static void deleteString(std::string *str) { delete str; }
 };
@@ -126,7 +126,8 @@ class ConfigurationBuilder
         __pragma(warning(suppress:4355))
         securityConfigurationBuilder(*this),
         nearCacheConfigurationBuilder(*this),
-        m_transactional(false)
+        m_transactional(false),
+        m_readRoutingPolicy(PRIMARY_OWNER)
         {}
 
      void validate() {}
@@ -300,6 +301,17 @@ class ConfigurationBuilder
         return *this;
     }
 
+    /**
+     * Sets which owner of a key serves the reads of the key. Writes always go to the primary owner.
+     * Default is PRIMARY_OWNER.
+     *
+     *\return ConfigurationBuilder instance to be used for further configuration
+     */
+    ConfigurationBuilder& readRoutingPolicy(ReadRoutingPolicy readRoutingPolicy_) {
+        m_readRoutingPolicy = readRoutingPolicy_;
+        return *this;
+    }
+
     /**
      * Build and returns an actual Configuration instance to be used for configuration of
      * RemoteCacheManager.
@@ -347,7 +359,7 @@ class ConfigurationBuilder
             m_maxRetries,
             nearCacheConfigurationBuilder.create(),
             m_balancingStrategyProducer,
-            m_eventMarshaller, m_transactional);
+            m_eventMarshaller, m_transactional, m_readRoutingPolicy);
 
     }
 
@@ -369,6 +381,7 @@ class ConfigurationBuilder
         m_maxRetries = configuration.getMaxRetries();
         m_eventMarshaller = configuration.getEventMarshaller();
         m_transactional = configuration.isTransactional();
+        m_readRoutingPolicy = configuration.getReadRoutingPolicy();
         return *this;
     }
     /**
@@ -408,6 +421,7 @@ class ConfigurationBuilder
     JBasicEventMarshaller m_defaultEventMarshaller;
     NearCacheConfigurationBuilder nearCacheConfigurationBuilder;
     bool m_transactional;
+    ReadRoutingPolicy m_readRoutingPolicy;
 
     EventMarshaller &m_eventMarshaller=m_defaultEventMarshaller;
 };
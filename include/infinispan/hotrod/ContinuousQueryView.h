@@ -0,0 +1,218 @@
+#ifndef ISPN_HOTROD_CONTINUOUSQUERYVIEW_H
+#define ISPN_HOTROD_CONTINUOUSQUERYVIEW_H
+
+#include "infinispan/hotrod/RemoteCache.h"
+#include "infinispan/hotrod/CacheClientListener.h"
+#include "infinispan/hotrod/ContinuousQueryListener.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * ContinuousQueryView keeps the current result set of a continuous query in memory. It registers
+ * its own ContinuousQueryListener, asking the server for the current state first, then applies the
+ * joining, updated and leaving events as they come.
+ *
+ * Reads never go to the server. snapshot() returns an immutable, sorted copy of the result set that
+ * is shared by all the readers until the next change. Values are shared between the view and its
+ * snapshots, never copied.
+ *
+ * On failover the view clears itself, drops the failed listener and registers it again, the server
+ * replays the current state as joining events. This is done by a thread of the view, not by the
+ * event thread of the failed listener. Reads during the replay can see a partial result set,
+ * getResyncCount() tells how many times this happened.
+ *
+ * The view must not outlive the RemoteCache it was created on. Entities views use
+ * ContinuousQueryView<K, V>, projection views ContinuousQueryView<K, V, Params...>
+ */
+template <class K, class V, typename... Params>
+class ContinuousQueryView
+{
+  public:
+    /** The type of the values: the entity, or the tuple of the projection */
+    typedef typename std::conditional<sizeof...(Params) == 0, V, std::tuple<Params...> >::type Value;
+    typedef std::pair<K, std::shared_ptr<const Value> > Entry;
+
+    /**
+     * An immutable copy of the result set, sorted by key
+     */
+    class Snapshot
+    {
+      public:
+        typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        const_iterator begin() const { return entries.begin(); }
+        const_iterator end() const { return entries.end(); }
+
+        /**
+         * \return the value of key, nullptr if key isn't in the result set
+         */
+        const Value* get(const K& key) const {
+            const_iterator it = std::lower_bound(entries.begin(), entries.end(), key,
+                    [](const Entry& e, const K& k) { return e.first < k; });
+            return it != entries.end() && !(key < it->first) ? it->second.get() : nullptr;
+        }
+
+      private:
+        std::vector<Entry> entries;
+        friend class ContinuousQueryView;
+    };
+
+    /**
+     * Register a continuous query and start following its result set
+     * \param cache the cache to be queried
+     * \param query the continuous query
+     */
+    ContinuousQueryView(RemoteCache<K, V>& cache, const std::string& query) :
+        cache(cache), cql(cache, query), published(std::make_shared<Snapshot>()), dirty(false), closed(false),
+        resyncPending(false), resyncs(0)
+    {
+        cql.cl.includeCurrentState = true;
+        std::function<void(K, Value)> upsert = [this](K k, Value v) { this->upsert(k, v); };
+        cql.setJoiningListener(upsert);
+        cql.setUpdatedListener(upsert);
+        cql.setLeavingListener([this](K k, Value) { this->erase(k); });
+        cql.setFailoverListener([this]() { this->requestResync(); });
+        cache.addContinuousQueryListener(cql);
+        resyncThread = std::thread(&ContinuousQueryView::resyncLoop, this);
+    }
+
+    ~ContinuousQueryView() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+        }
+        resyncNeeded.notify_one();
+        // No resync can run past this point, the listener to remove is the last one added
+        resyncThread.join();
+        try {
+            cache.removeContinuousQueryListener(cql);
+        } catch (...) {
+            // Can't rise any exception here
+        }
+    }
+
+    /**
+     * \return the current result set, shared with the other readers and never modified
+     */
+    std::shared_ptr<const Snapshot> snapshot() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (dirty) {
+            std::shared_ptr<Snapshot> s = std::make_shared<Snapshot>();
+            s->entries.assign(live.begin(), live.end());
+            published = s;
+            dirty = false;
+        }
+        return published;
+    }
+
+    /**
+     * \return the current value of key, nullptr if key isn't in the result set
+     */
+    std::shared_ptr<const Value> get(const K& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = live.find(key);
+        return it != live.end() ? it->second : std::shared_ptr<const Value>();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return live.size();
+    }
+
+    /**
+     * \return how many times the view has been rebuilt after a failover
+     */
+    uint64_t getResyncCount() const { return resyncs; }
+
+  private:
+    ContinuousQueryView(const ContinuousQueryView&);
+    ContinuousQueryView& operator=(const ContinuousQueryView&);
+
+    void upsert(const K& key, const Value& value) {
+        std::shared_ptr<const Value> v = std::make_shared<const Value>(value);
+        std::lock_guard<std::mutex> guard(lock);
+        live[key] = v;
+        dirty = true;
+    }
+
+    void erase(const K& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (live.erase(key) > 0) {
+            dirty = true;
+        }
+    }
+
+    // Called by the event thread of the failed listener, which exits right after
+    void requestResync() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (closed) {
+                return;
+            }
+            resyncPending = true;
+        }
+        resyncNeeded.notify_one();
+    }
+
+    void resyncLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            resyncNeeded.wait(guard, [this] { return closed || resyncPending; });
+            if (closed) {
+                return;
+            }
+            resyncPending = false;
+            live.clear();
+            dirty = true;
+            guard.unlock();
+            resync();
+            guard.lock();
+        }
+    }
+
+    void resync() {
+        ++resyncs;
+        // Forget the failed listener and its connection first, then register it with a new id
+        try {
+            cache.removeContinuousQueryListener(cql);
+        } catch (...) {
+            // The server may be gone, the listener is released anyway
+        }
+        try {
+            cache.addContinuousQueryListener(cql);
+        } catch (...) {
+            // Nothing to retry on, the view stays empty
+        }
+    }
+
+    RemoteCache<K, V>& cache;
+    ContinuousQueryListener<K, V, Params...> cql;
+    std::mutex lock;
+    std::map<K, std::shared_ptr<const Value> > live;
+    std::shared_ptr<const Snapshot> published;
+    bool dirty;
+    bool closed;
+    bool resyncPending;
+    std::condition_variable resyncNeeded;
+    std::thread resyncThread;
+    std::atomic<uint64_t> resyncs;
+};
+
+}} // namespace
+
+#endif  /* ISPN_HOTROD_CONTINUOUSQUERYVIEW_H */
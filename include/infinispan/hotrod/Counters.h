@@ -9,6 +9,7 @@
 #define INCLUDE_INFINISPAN_HOTROD_COUNTERS_H_
 
 #include <string>
+#include <future>
 #include "infinispan/hotrod/CounterConfiguration.h"
 #include "infinispan/hotrod/CounterEvent.h"
 
@@ -109,6 +110,31 @@ public:
      */
     virtual bool compareAndSet(long expect, long update) = 0;
 
+    /**
+     * Asynchronous version of getValue(). The asynchronous operations of all the counters of a
+     * manager are pipelined on a single connection.
+     *
+     * @return a future that will contain the current value.
+     */
+    virtual std::future<long> getValueAsync() = 0;
+
+    /**
+     * Asynchronous version of addAndGet(long).
+     *
+     * @param delta The non-zero value to add. It can be negative.
+     * @return a future that will contain the new value.
+     */
+    virtual std::future<long> addAndGetAsync(long delta) = 0;
+
+    /**
+     * Asynchronous version of compareAndSwap(long, long).
+     *
+     * @param expect the expected value.
+     * @param update the new value.
+     * @return a future that will contain the previous counter's value.
+     */
+    virtual std::future<long> compareAndSwapAsync(long expect, long update) = 0;
+
     virtual ~StrongCounter() {
     }
 };
@@ -141,6 +167,13 @@ public:
      */
     virtual void add(long delta) = 0;
 
+    /**
+     * Asynchronous version of getValue(), pipelined like the operations of StrongCounter.
+     *
+     * @return a future that will contain the counter's value.
+     */
+    virtual std::future<long> getValueAsync() = 0;
+
     virtual ~WeakCounter() {
     }
 };
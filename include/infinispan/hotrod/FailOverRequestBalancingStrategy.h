@@ -2,6 +2,7 @@
 #define ISPN_HOTROD_TRANSPORT_FAILOVERREQUESTBALANCINGSTRATEGY_H
 
 #include <infinispan/hotrod/InetSocketAddress.h>
+#include <cstdint>
 #include <vector>
 #include <set>
 
@@ -27,6 +28,19 @@ class FailOverRequestBalancingStrategy
      * \return the next target server
      */
     virtual const transport::InetSocketAddress& nextServer(const std::set<transport::InetSocketAddress>& failedServers) = 0;
+    /**
+     * Called when a request is sent to a server, whatever the way the server was chosen.
+     * Strategies that don't look at the load of the servers can ignore it.
+     * \param server the target server
+     */
+    virtual void requestStarted(const transport::InetSocketAddress& /*server*/) {}
+    /**
+     * Called when a request started with requestStarted() completes
+     * \param server the target server
+     * \param latencyNanos the time spent waiting for the response
+     * \param failed true if the request failed because of the connection with the server
+     */
+    virtual void requestCompleted(const transport::InetSocketAddress& /*server*/, uint64_t /*latencyNanos*/, bool /*failed*/) {}
 
     virtual ~FailOverRequestBalancingStrategy() {};
   private:
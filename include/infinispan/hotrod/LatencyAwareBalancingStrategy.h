@@ -0,0 +1,79 @@
+#ifndef ISPN_HOTROD_LATENCYAWAREBALANCINGSTRATEGY_H
+#define ISPN_HOTROD_LATENCYAWAREBALANCINGSTRATEGY_H
+
+#include "infinispan/hotrod/ImportExport.h"
+#include "infinispan/hotrod/FailOverRequestBalancingStrategy.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * LatencyAwareBalancingStrategy sends the requests to the servers that answer faster. It keeps, for
+ * every server, an exponentially weighted moving average (EWMA) of the latency and the number of
+ * requests in flight. nextServer() picks two random servers and returns the one with the lower
+ * cost, that is the average latency times the requests in flight plus one (power of two choices).
+ *
+ * A failed request counts as a request lasting at least failurePenaltyNanos. The average of a
+ * server that isn't used decays towards zero, with decayNanos as time constant, so that a server
+ * that was slow gets tried again later.
+ *
+ * Use it with ConfigurationBuilder::balancingStrategyProducer(LatencyAwareBalancingStrategy::newInstance)
+ */
+class HR_EXTERN LatencyAwareBalancingStrategy : public FailOverRequestBalancingStrategy
+{
+  public:
+    /**
+     * \param smoothing the weight of a new sample in the average, between 0 and 1
+     * \param failurePenaltyNanos the latency charged to a failed request
+     * \param decayNanos the time constant of the decay of the average of an idle server
+     */
+    LatencyAwareBalancingStrategy(double smoothing = 0.3, uint64_t failurePenaltyNanos = 1000000000ULL,
+            uint64_t decayNanos = 10000000000ULL);
+
+    void setServers(const std::vector<transport::InetSocketAddress>& servers);
+    const transport::InetSocketAddress& nextServer(const std::set<transport::InetSocketAddress>& failedServers);
+    void requestStarted(const transport::InetSocketAddress& server);
+    void requestCompleted(const transport::InetSocketAddress& server, uint64_t latencyNanos, bool failed);
+
+    /**
+     * \return the average latency of server in nanoseconds, 0 if the server is unknown
+     */
+    uint64_t getAverageLatency(const transport::InetSocketAddress& server);
+    /**
+     * \return the number of requests in flight to server
+     */
+    int getInFlight(const transport::InetSocketAddress& server);
+
+    static FailOverRequestBalancingStrategy* newInstance();
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct ServerStats {
+        double average;
+        Clock::time_point lastSample;
+        int inFlight;
+    };
+
+    std::mutex lock;
+    std::vector<transport::InetSocketAddress> servers;
+    std::vector<ServerStats> stats;
+    std::minstd_rand random;
+    double smoothing;
+    double failurePenalty;
+    double decay;
+
+    int indexOf(const transport::InetSocketAddress& server) const;
+    double decayedAverage(const ServerStats& s, Clock::time_point now) const;
+    double cost(const ServerStats& s, Clock::time_point now) const;
+};
+
+}} // namespace infinispan::hotrod
+
+#endif  /* ISPN_HOTROD_LATENCYAWAREBALANCINGSTRATEGY_H */
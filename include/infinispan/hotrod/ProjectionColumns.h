@@ -0,0 +1,201 @@
+#ifndef ISPN_HOTROD_PROJECTIONCOLUMNS_H
+#define ISPN_HOTROD_PROJECTIONCOLUMNS_H
+
+#include "infinispan/hotrod/Query.h"
+#include "infinispan/hotrod/exceptions.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * StringColumn stores all the strings of a projection column back to back in a single buffer
+ */
+class StringColumn
+{
+  public:
+    StringColumn() : offsets(1, 0) {}
+
+    size_t size() const { return offsets.size() - 1; }
+    const char* data(size_t row) const { return bytes.data() + offsets[row]; }
+    size_t length(size_t row) const { return offsets[row + 1] - offsets[row]; }
+    std::string get(size_t row) const { return std::string(data(row), length(row)); }
+
+    void clear() { bytes.clear(); offsets.resize(1); }
+    void reserve(size_t rows) { offsets.reserve(rows + 1); }
+    void append(const std::string& s) {
+        bytes.insert(bytes.end(), s.begin(), s.end());
+        offsets.push_back(bytes.size());
+    }
+
+  private:
+    std::vector<char> bytes;
+    std::vector<size_t> offsets;
+};
+
+/**
+ * ProjectionColumns decodes the rows of a projection query column by column into typed
+ * contiguous arrays. Integral and boolean values go to an int64_t column, floating point values
+ * to a double column, strings and bytes to a StringColumn. The type of a column is taken from
+ * its first non null value.
+ *
+ * Null values are stored as 0 or as an empty string and flagged, see isNull().
+ */
+class ProjectionColumns
+{
+  public:
+    enum Type { INTEGER, FLOATING, STRING };
+
+    ProjectionColumns() : rows(0) {}
+
+    /**
+     * Decode the projections of a QueryResponse, replacing the current content
+     *
+     * \return false if the query has no projection
+     */
+    bool unwrap(const org::infinispan::query::remote::client::QueryResponse& resp) {
+        int width = resp.projectionsize();
+        if (width <= 0) {
+            return false;
+        }
+        const google::protobuf::RepeatedPtrField<org::infinispan::protostream::WrappedMessage>& results = resp.results();
+        rows = results.size() / width;
+        columns.resize(width);
+        for (int c = 0; c < width; c++) {
+            Column& col = columns[c];
+            col.clear();
+            col.type = columnType(results, c, width);
+            col.nulls.assign(rows, false);
+            switch (col.type) {
+            case INTEGER:
+                col.integers.resize(rows);
+                for (size_t r = 0; r < rows; r++) {
+                    const org::infinispan::protostream::WrappedMessage& wm = results.Get((int) (r * width + c));
+                    if (!integerValue(wm, col.integers[r])) {
+                        col.integers[r] = 0;
+                        col.nulls[r] = checkNull(wm, c);
+                    }
+                }
+                break;
+            case FLOATING:
+                col.doubles.resize(rows);
+                for (size_t r = 0; r < rows; r++) {
+                    const org::infinispan::protostream::WrappedMessage& wm = results.Get((int) (r * width + c));
+                    if (wm.has_wrappeddouble()) {
+                        col.doubles[r] = wm.wrappeddouble();
+                    } else if (wm.has_wrappedfloat()) {
+                        col.doubles[r] = wm.wrappedfloat();
+                    } else {
+                        col.doubles[r] = 0;
+                        col.nulls[r] = checkNull(wm, c);
+                    }
+                }
+                break;
+            case STRING:
+                col.strings.reserve(rows);
+                for (size_t r = 0; r < rows; r++) {
+                    const org::infinispan::protostream::WrappedMessage& wm = results.Get((int) (r * width + c));
+                    if (wm.has_wrappedstring()) {
+                        col.strings.append(wm.wrappedstring());
+                    } else if (wm.has_wrappedbytes()) {
+                        col.strings.append(wm.wrappedbytes());
+                    } else {
+                        col.strings.append(std::string());
+                        col.nulls[r] = checkNull(wm, c);
+                    }
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+    int getColumnCount() const { return (int) columns.size(); }
+    size_t getRowCount() const { return rows; }
+    Type getType(int column) const { return columns.at(column).type; }
+    bool isNull(int column, size_t row) const { return columns.at(column).nulls.at(row); }
+
+    const std::vector<int64_t>& getIntegers(int column) const { return typed(column, INTEGER).integers; }
+    const std::vector<double>& getDoubles(int column) const { return typed(column, FLOATING).doubles; }
+    const StringColumn& getStrings(int column) const { return typed(column, STRING).strings; }
+
+  private:
+    struct Column {
+        Type type;
+        std::vector<int64_t> integers;
+        std::vector<double> doubles;
+        StringColumn strings;
+        std::vector<bool> nulls;
+
+        Column() : type(INTEGER) {}
+        void clear() { integers.clear(); doubles.clear(); strings.clear(); }
+    };
+
+    static bool integerValue(const org::infinispan::protostream::WrappedMessage& wm, int64_t& v) {
+        if (wm.has_wrappedint32()) { v = wm.wrappedint32(); }
+        else if (wm.has_wrappedint64()) { v = wm.wrappedint64(); }
+        else if (wm.has_wrappedsint32()) { v = wm.wrappedsint32(); }
+        else if (wm.has_wrappedsint64()) { v = wm.wrappedsint64(); }
+        else if (wm.has_wrappeduint32()) { v = wm.wrappeduint32(); }
+        else if (wm.has_wrappeduint64()) { v = (int64_t) wm.wrappeduint64(); }
+        else if (wm.has_wrappedfixed32()) { v = wm.wrappedfixed32(); }
+        else if (wm.has_wrappedfixed64()) { v = (int64_t) wm.wrappedfixed64(); }
+        else if (wm.has_wrappedsfixed32()) { v = wm.wrappedsfixed32(); }
+        else if (wm.has_wrappedsfixed64()) { v = wm.wrappedsfixed64(); }
+        else if (wm.has_wrappedbool()) { v = wm.wrappedbool() ? 1 : 0; }
+        else if (wm.has_wrappedenum()) { v = wm.wrappedenum(); }
+        else { return false; }
+        return true;
+    }
+
+    static bool hasValue(const org::infinispan::protostream::WrappedMessage& wm) {
+#if GOOGLE_PROTOBUF_VERSION < 3004001
+        return wm.ByteSize() != 0;
+#else
+        return wm.ByteSizeLong() != 0;
+#endif
+    }
+
+    // A value that doesn't fit the column type is an error, not a null
+    static bool checkNull(const org::infinispan::protostream::WrappedMessage& wm, int column) {
+        if (hasValue(wm)) {
+            throw HotRodClientException("Projection column " + std::to_string(column) + " mixes values of different types");
+        }
+        return true;
+    }
+
+    static Type columnType(const google::protobuf::RepeatedPtrField<org::infinispan::protostream::WrappedMessage>& results,
+            int column, int width) {
+        for (int i = column; i < results.size(); i += width) {
+            const org::infinispan::protostream::WrappedMessage& wm = results.Get(i);
+            int64_t ignored;
+            if (integerValue(wm, ignored)) {
+                return INTEGER;
+            }
+            if (wm.has_wrappeddouble() || wm.has_wrappedfloat()) {
+                return FLOATING;
+            }
+            if (wm.has_wrappedstring() || wm.has_wrappedbytes()) {
+                return STRING;
+            }
+        }
+        return INTEGER;
+    }
+
+    const Column& typed(int column, Type type) const {
+        const Column& col = columns.at(column);
+        if (col.type != type) {
+            throw HotRodClientException("Projection column " + std::to_string(column) + " has a different type");
+        }
+        return col;
+    }
+
+    std::vector<Column> columns;
+    size_t rows;
+};
+
+}} // namespace
+
+#endif  /* ISPN_HOTROD_PROJECTIONCOLUMNS_H */
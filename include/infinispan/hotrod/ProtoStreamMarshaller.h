@@ -4,13 +4,17 @@
 
 #include <string>
 #include <iostream>
-#include "infinispan/hotrod/Marshaller.h"
+#include <cstdint>
+#include <vector>
+#include "infinispan/hotrod/BufferMarshaller.h"
 #include "infinispan/hotrod/exceptions.h"
 #if _MSC_VER
 #pragma warning(push)
 #pragma warning(disable:4267 4244)
 #endif
 #include "infinispan/hotrod/message-wrapping.pb.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 #if _MSC_VER
 #pragma warning(pop)
 #endif
@@ -21,38 +25,95 @@ namespace infinispan {
 namespace hotrod {
 
 /**
- * A Marshaller based on Google Protobuf and on the WrappedMessage .proto specification
+ * Encodes and decodes the WrappedMessage envelope around a user message in a single pass.
+ * The output is the same as serializing a WrappedMessage with the wrappedMessageBytes
+ * and wrappedDescriptorId fields set, but the inner message is written and parsed in place.
  */
-template <class T, unsigned int TypeId = 1000042> class ProtoStreamMarshaller : public infinispan::hotrod::Marshaller<T> {
-    void marshall(const T& obj, std::vector<char>& b) {
-#if GOOGLE_PROTOBUF_VERSION < 3004001
-        std::vector<char> msg(obj.ByteSize());
-        obj.SerializeToArray(msg.data(),obj.ByteSize());
-#else
-        std::vector<char> msg(obj.ByteSizeLong());
-        obj.SerializeToArray(msg.data(),obj.ByteSizeLong());
-#endif
-        WrappedMessage wm;
-        wm.set_wrappedmessagebytes(msg.data(), msg.size());
-        wm.set_wrappeddescriptorid(TypeId);
+class WrappedMessageEnvelope {
+public:
+    // Tags of the WrappedMessage fields, see message-wrapping.proto
+    static const uint32_t MessageBytesTag = (17 << 3) | 2;
+    static const uint32_t DescriptorIdTag = (19 << 3) | 0;
+
+    /**
+     * Append the envelope of msg to b
+     */
+    template <class M> static void wrap(const M& msg, int32_t typeId, std::vector<char>& b) {
+        using google::protobuf::io::CodedOutputStream;
 #if GOOGLE_PROTOBUF_VERSION < 3004001
-        b.resize(wm.ByteSize());
-        wm.SerializeToArray(b.data(),wm.ByteSize());
+        uint32_t size = (uint32_t) msg.ByteSize();
 #else
-        b.resize(wm.ByteSizeLong());
-        wm.SerializeToArray(b.data(),wm.ByteSizeLong());
+        uint32_t size = (uint32_t) msg.ByteSizeLong();
 #endif
+        size_t start = b.size();
+        b.resize(start + CodedOutputStream::VarintSize32(MessageBytesTag) + CodedOutputStream::VarintSize32(size) + size
+                + CodedOutputStream::VarintSize32(DescriptorIdTag) + CodedOutputStream::VarintSize32SignExtended(typeId));
+        uint8_t* p = reinterpret_cast<uint8_t*>(b.data() + start);
+        p = CodedOutputStream::WriteVarint32ToArray(MessageBytesTag, p);
+        p = CodedOutputStream::WriteVarint32ToArray(size, p);
+        p = msg.SerializeWithCachedSizesToArray(p);
+        p = CodedOutputStream::WriteVarint32ToArray(DescriptorIdTag, p);
+        CodedOutputStream::WriteVarint32SignExtendedToArray(typeId, p);
     }
 
-    T* unmarshall(const std::vector<char>& b) {
-        WrappedMessage wm;
-        wm.ParseFromArray(b.data(),b.size());
-        const std::string &wmb=wm.wrappedmessagebytes();
-        auto *bt = new T();
-        bt->ParseFromArray(wmb.data(),wmb.size());
-        return bt;
+    /**
+     * Locate the wrapped message bytes inside an envelope, without copying them.
+     * msg is set to nullptr if the envelope doesn't wrap a message
+     *
+     * \return false if the envelope is malformed
+     */
+    static bool unwrap(const char* data, size_t size, const char*& msg, size_t& msgSize) {
+        using google::protobuf::io::CodedInputStream;
+        using google::protobuf::internal::WireFormatLite;
+        CodedInputStream in(reinterpret_cast<const uint8_t*>(data), (int) size);
+        msg = nullptr;
+        msgSize = 0;
+        uint32_t tag;
+        while ((tag = in.ReadTag()) != 0) {
+            if (tag == MessageBytesTag) {
+                uint32_t len;
+                if (!in.ReadVarint32(&len)) {
+                    return false;
+                }
+                int offset = in.CurrentPosition();
+                if (!in.Skip((int) len)) {
+                    return false;
+                }
+                msg = data + offset;
+                msgSize = len;
+            } else if (!WireFormatLite::SkipField(&in, tag)) {
+                return false;
+            }
+        }
+        return true;
     }
 
+    /**
+     * Parse the message wrapped by an envelope into obj
+     */
+    template <class M> static void unwrapInto(const char* data, size_t size, M& obj) {
+        const char* msg;
+        size_t msgSize;
+        if (unwrap(data, size, msg, msgSize) && msg != nullptr) {
+            obj.ParseFromArray(msg, (int) msgSize);
+        } else {
+            obj.Clear();
+        }
+    }
+};
+
+/**
+ * A Marshaller based on Google Protobuf and on the WrappedMessage .proto specification
+ */
+template <class T, unsigned int TypeId = 1000042> class ProtoStreamMarshaller : public infinispan::hotrod::BufferMarshaller<T> {
+public:
+    void marshallInto(const T& obj, std::vector<char>& b) {
+        WrappedMessageEnvelope::wrap(obj, (int32_t) TypeId, b);
+    }
+
+    void unmarshallInto(const char* data, size_t size, T& obj) {
+        WrappedMessageEnvelope::unwrapInto(data, size, obj);
+    }
 };
 
 template <class T> class ProtoStreamMarshallerHelper {
@@ -63,11 +124,8 @@ public:
         delete buf->data();
     }
     static T unmarshall(char *b, size_t size) {
-        WrappedMessage wm;
-        wm.ParseFromArray(b, size);
-        const std::string &wmb=wm.wrappedmessagebytes();
         T bt;
-        bt.ParseFromArray(wmb.data(),wmb.size());
+        WrappedMessageEnvelope::unwrapInto(b, size, bt);
         return bt;
     }};
 
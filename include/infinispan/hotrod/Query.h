@@ -62,6 +62,18 @@ public:
   bool local() const { return qrp.local(); }
   void set_local(bool value) { qrp.set_local(value); }
 
+  /**
+   * Paging of the result set: index of the first result and maximum number of results returned
+   */
+  inline bool has_startoffset() const { return qrp.has_startoffset(); }
+  inline void clear_startoffset() { qrp.clear_startoffset(); }
+  inline int64_t startoffset() const { return qrp.startoffset(); }
+  inline void set_startoffset(int64_t value) { qrp.set_startoffset(value); }
+  inline bool has_maxresults() const { return qrp.has_maxresults(); }
+  inline void clear_maxresults() { qrp.clear_maxresults(); }
+  inline int32_t maxresults() const { return qrp.maxresults(); }
+  inline void set_maxresults(int32_t value) { qrp.set_maxresults(value); }
+
   /**
    * Deprecated, use set_querystring() instead
    * set the query string
@@ -86,6 +98,7 @@ public:
   inline int ByteSize() const { return qrp.ByteSize(); }
 #else
   inline int ByteSize() const { return qrp.ByteSizeLong(); }
+  inline size_t ByteSizeLong() const { return qrp.ByteSizeLong(); }
 #endif
 };
 
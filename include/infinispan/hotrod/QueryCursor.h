@@ -0,0 +1,212 @@
+#ifndef ISPN_HOTROD_QUERYCURSOR_H
+#define ISPN_HOTROD_QUERYCURSOR_H
+
+#include "infinispan/hotrod/Query.h"
+#include "infinispan/hotrod/QueryResultSet.h"
+#include "infinispan/hotrod/exceptions.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * QueryCursor iterates over the entities returned by a query one page at a time. Every page is
+ * a separate query with startOffset and maxResults set by the cursor, and the next page is fetched
+ * in background, by a thread owned by the cursor, while the current one is consumed. Only the current
+ * and the next page are held in memory, whatever the size of the result set.
+ *
+ * A failed fetch is thrown by hasNext() and next(), and keeps being thrown by any later call.
+ *
+ * startOffset and maxResults of the original request, if set, bound the iteration. Projections
+ * are not supported.
+ */
+template <class T> class QueryCursor
+{
+  public:
+    typedef std::function<const org::infinispan::query::remote::client::QueryResponse*
+        (const org::infinispan::query::remote::client::QueryRequest&, google::protobuf::Arena&)> Fetcher;
+
+    /**
+     * \param fetcher runs one query, parsing the response on the given arena
+     * \param qr the query to iterate
+     * \param pageSize the number of entities fetched per page
+     */
+    QueryCursor(Fetcher fetcher, const org::infinispan::query::remote::client::QueryRequest& qr, int pageSize)
+      : request(qr), pageSize(pageSize), nextOffset(qr.startoffset()),
+        remaining(qr.has_maxresults() ? qr.maxresults() : -1), pendingCount(0), pending(false), index(0) {
+        if (pageSize <= 0) {
+            throw HotRodClientException("QueryCursor page size must be positive");
+        }
+        prefetcher.reset(new Prefetcher(fetcher));
+        prefetch();
+    }
+
+    /**
+     * \return true if there are more entities, may wait for the next page
+     * \throw the exception of a failed fetch
+     */
+    bool hasNext() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        while (!page || index >= page->size()) {
+            if (!pending) {
+                return false;
+            }
+            int requested = pendingCount;
+            pending = false;
+            try {
+                page = prefetcher->take();
+            } catch (...) {
+                error = std::current_exception();
+                throw;
+            }
+            index = 0;
+            // A short page or the total count tell that this was the last one
+            if (page->size() >= requested && nextOffset < page->getTotalResults()) {
+                prefetch();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * \return the next entity, valid until the cursor moves past its page
+     */
+    const T& next() {
+        if (!hasNext()) {
+            throw NoSuchElementException("QueryCursor has no more results");
+        }
+        return (*page)[index++];
+    }
+
+    /**
+     * \return the page holding the last entity returned by next(), nullptr before the first page
+     */
+    const QueryResultSet<T>* currentPage() const { return page.get(); }
+
+    /**
+     * \return the total number of results matching the query, 0 before the first page
+     */
+    int64_t getTotalResults() const { return page ? page->getTotalResults() : 0; }
+
+  private:
+    void prefetch() {
+        if (remaining == 0) {
+            return;
+        }
+        int count = remaining < 0 || remaining > pageSize ? pageSize : remaining;
+        org::infinispan::query::remote::client::QueryRequest pageRequest(request);
+        pageRequest.set_startoffset(nextOffset);
+        pageRequest.set_maxresults(count);
+        nextOffset += count;
+        if (remaining > 0) {
+            remaining -= count;
+        }
+        pendingCount = count;
+        pending = true;
+        prefetcher->fetch(pageRequest);
+    }
+
+    // Fetches one page at a time on its own thread, which lives as long as the cursor
+    class Prefetcher
+    {
+      public:
+        explicit Prefetcher(const Fetcher& fetcher)
+          : fetcher(fetcher), requested(false), ready(false), stopped(false), thread(&Prefetcher::run, this) {
+        }
+
+        ~Prefetcher() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopped = true;
+            }
+            changed.notify_all();
+            thread.join();
+        }
+
+        void fetch(const org::infinispan::query::remote::client::QueryRequest& pageRequest) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                request = pageRequest;
+                requested = true;
+            }
+            changed.notify_all();
+        }
+
+        // Waits for the page asked by the last fetch()
+        std::unique_ptr<QueryResultSet<T> > take() {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [this] { return ready; });
+            ready = false;
+            if (error) {
+                std::exception_ptr e = error;
+                error = nullptr;
+                std::rethrow_exception(e);
+            }
+            return std::move(result);
+        }
+
+      private:
+        void run() {
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;) {
+                changed.wait(guard, [this] { return requested || stopped; });
+                if (stopped) {
+                    return;
+                }
+                requested = false;
+                org::infinispan::query::remote::client::QueryRequest pageRequest(request);
+                guard.unlock();
+                std::unique_ptr<QueryResultSet<T> > rs;
+                std::exception_ptr failure;
+                try {
+                    rs.reset(new QueryResultSet<T>());
+                    if (!rs->unwrap(fetcher(pageRequest, rs->getArena()))) {
+                        throw HotRodClientException("QueryCursor doesn't support projections");
+                    }
+                } catch (...) {
+                    rs.reset();
+                    failure = std::current_exception();
+                }
+                guard.lock();
+                result = std::move(rs);
+                error = failure;
+                ready = true;
+                changed.notify_all();
+            }
+        }
+
+        Fetcher fetcher;
+        std::mutex lock;
+        std::condition_variable changed;
+        org::infinispan::query::remote::client::QueryRequest request;
+        bool requested;
+        std::unique_ptr<QueryResultSet<T> > result;
+        std::exception_ptr error;
+        bool ready;
+        bool stopped;
+        // Last, so it starts once the rest is initialized
+        std::thread thread;
+    };
+
+    org::infinispan::query::remote::client::QueryRequest request;
+    int pageSize;
+    int64_t nextOffset;
+    int remaining;
+    int pendingCount;
+    bool pending;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::exception_ptr error;
+    std::unique_ptr<QueryResultSet<T> > page;
+    int index;
+};
+
+}} // namespace
+
+#endif  /* ISPN_HOTROD_QUERYCURSOR_H */
@@ -0,0 +1,98 @@
+#ifndef ISPN_HOTROD_QUERYRESULTSET_H
+#define ISPN_HOTROD_QUERYRESULTSET_H
+
+#include "infinispan/hotrod/Query.h"
+#include "infinispan/hotrod/ProtoStreamMarshaller.h"
+#include <google/protobuf/arena.h>
+#include <google/protobuf/repeated_field.h>
+#include <memory>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * QueryResultSet holds the entities returned by a query. The QueryResponse, the entities and
+ * their fields are all allocated on a single protobuf arena owned by the result set, so building
+ * the result set doesn't go through the heap per row and destroying it releases everything at once.
+ *
+ * Entities are returned by reference and live as long as the result set.
+ */
+template <class T> class QueryResultSet
+{
+  public:
+    typedef typename google::protobuf::RepeatedPtrField<T>::const_iterator const_iterator;
+
+    /**
+     * \param initialBlockSize size of the first arena block, use roughly the expected result size
+     */
+    explicit QueryResultSet(size_t initialBlockSize = 64 * 1024) : arena(createArena(initialBlockSize)),
+        response(nullptr), rows(createRows(*arena)) {}
+
+    /**
+     * \return the arena owning the response and the entities
+     */
+    google::protobuf::Arena& getArena() { return *arena; }
+
+    /**
+     * \return the response the entities were unwrapped from, nullptr if unwrap() wasn't called
+     */
+    const org::infinispan::query::remote::client::QueryResponse* getResponse() const { return response; }
+
+    /**
+     * Unwrap the entities of a response allocated on getArena() and append them to the result set.
+     *
+     * \return false if the query has a projection, in which case there are no entities to unwrap
+     */
+    bool unwrap(const org::infinispan::query::remote::client::QueryResponse* resp) {
+        response = resp;
+        if (resp->projectionsize() > 0) {
+            return false;
+        }
+        rows->Reserve(rows->size() + resp->results_size());
+        for (int i = 0; i < resp->results_size(); i++) {
+            const org::infinispan::protostream::WrappedMessage& wm = resp->results(i);
+            if (!wm.has_wrappedbytes()) {
+                continue;
+            }
+            const std::string& bytes = wm.wrappedbytes();
+            const char* msg;
+            size_t msgSize;
+            if (WrappedMessageEnvelope::unwrap(bytes.data(), bytes.size(), msg, msgSize) && msg != nullptr) {
+                rows->Add()->ParseFromArray(msg, (int) msgSize);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * \return the total number of results matching the query, not only the returned ones
+     */
+    int64_t getTotalResults() const { return response != nullptr ? response->totalresults() : 0; }
+
+    int size() const { return rows->size(); }
+    bool empty() const { return rows->empty(); }
+    const T& operator[](int i) const { return rows->Get(i); }
+    const_iterator begin() const { return rows->begin(); }
+    const_iterator end() const { return rows->end(); }
+
+  private:
+    static google::protobuf::Arena* createArena(size_t initialBlockSize) {
+        google::protobuf::ArenaOptions options;
+        options.start_block_size = initialBlockSize;
+        // Big result sets grow in few large blocks rather than many small ones
+        options.max_block_size = initialBlockSize > 1024 * 1024 ? initialBlockSize : 1024 * 1024;
+        return new google::protobuf::Arena(options);
+    }
+
+    static google::protobuf::RepeatedPtrField<T>* createRows(google::protobuf::Arena& a) {
+        return google::protobuf::Arena::CreateMessage<google::protobuf::RepeatedPtrField<T> >(&a);
+    }
+
+    std::unique_ptr<google::protobuf::Arena> arena;
+    const org::infinispan::query::remote::client::QueryResponse* response;
+    google::protobuf::RepeatedPtrField<T>* rows;
+};
+
+}} // namespace
+
+#endif  /* ISPN_HOTROD_QUERYRESULTSET_H */
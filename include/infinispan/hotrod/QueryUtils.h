@@ -9,6 +9,7 @@
 #define INCLUDE_INFINISPAN_HOTROD_QUERYUTILS_H_
 
 #include "infinispan/hotrod/Query.h"
+#include "infinispan/hotrod/ProtoStreamMarshaller.h"
 #include <tuple>
 using namespace org::infinispan::protostream;
 using namespace google::protobuf;
@@ -16,7 +17,7 @@ using namespace org::infinispan::query::remote::client;
 
 
 // extract a resultset of entities from a QueryResponse obj
-template <class T> bool unwrapResults(QueryResponse resp, std::vector<T> &res)
+template <class T> bool unwrapResults(const QueryResponse &resp, std::vector<T> &res)
 {
     if (resp.projectionsize()>0)
     {  // Query has select
@@ -27,12 +28,12 @@ template <class T> bool unwrapResults(QueryResponse resp, std::vector<T> &res)
         const WrappedMessage &wm =resp.results(i);
         if ( wm.has_wrappedbytes() )
         {
-            WrappedMessage wmn;
-            wmn.ParseFromString(wm.wrappedbytes());
-            if (wmn.has_wrappedmessagebytes()) {
-                T u1;
-                u1.ParseFromString(wmn.wrappedmessagebytes());
-                res.push_back(u1);
+            const std::string &bytes = wm.wrappedbytes();
+            const char* msg;
+            size_t msgSize;
+            if (infinispan::hotrod::WrappedMessageEnvelope::unwrap(bytes.data(), bytes.size(), msg, msgSize) && msg != nullptr) {
+                res.emplace_back();
+                res.back().ParseFromArray(msg, (int) msgSize);
             }
         }
     }
@@ -3,6 +3,7 @@
 
 #include "infinispan/hotrod/RemoteCacheBase.h"
 #include "infinispan/hotrod/Marshaller.h"
+#include "infinispan/hotrod/BufferMarshaller.h"
 #include "infinispan/hotrod/Flag.h"
 #include "infinispan/hotrod/MetadataValue.h"
 #include "infinispan/hotrod/TimeUnit.h"
@@ -12,6 +13,9 @@
 #include "infinispan/hotrod/ClientListener.h"
 #include "infinispan/hotrod/Query.h"
 #include "infinispan/hotrod/QueryUtils.h"
+#include "infinispan/hotrod/QueryResultSet.h"
+#include "infinispan/hotrod/QueryCursor.h"
+#include "infinispan/hotrod/ProjectionColumns.h"
 #include "infinispan/hotrod/ContinuousQueryListener.h"
 #include "infinispan/hotrod/BasicTypesProtoStreamMarshaller.h"
 #include "infinispan/hotrod/JBossMarshaller.h"
@@ -70,8 +74,11 @@ private:
             std::function<typename std::result_of<Function()>::type(typename std::result_of<Function()>::type)> success,
             std::function<typename std::result_of<Function()>::type(std::exception&)> fail)
     {
+        // Flags are kept per thread, hand them over to the async one
+        Flag flags = base_takeFlags();
         auto fq = [=]
-        {   try
+        {   if (flags) this->base_withFlags(flags);
+            try
             {   return success==0 ? f() : success(f());}
             catch (std::exception& ex)
             {   if (fail!=0)
@@ -86,8 +93,10 @@ private:
     inline std::future<void> goAsync(Function&& f, std::function<void()> success,
             std::function<void(std::exception&)> fail)
     {
+        Flag flags = base_takeFlags();
         auto fq = [=]
-        {   try
+        {   if (flags) this->base_withFlags(flags);
+            try
             {   if (success==0) f();
                 else success();}
             catch (std::exception& ex)
@@ -145,6 +154,38 @@ public:
         return (V *) base_get(&key);
     }
 
+    /**
+     * Reads the marshalled value mapped to the key into a caller-owned buffer. The buffer is resized
+     * to the value length and its capacity is reused, so a steady state of calls on the same buffer
+     * doesn't allocate. Useful for caches of byte blobs, where the value is consumed as bytes.
+     *
+     * \param key the key whose associated value is to be read
+     * \param value the buffer receiving the marshalled value, cleared if there's no mapping
+     * \return true if the key has a mapping, false otherwise
+     */
+    bool getInto(const K& key, std::vector<char>& value)
+    {
+        return base_getInto(&key, value);
+    }
+
+    /**
+     * Reads the value mapped to the key into existing storage. The marshalled bytes go through a
+     * pooled scratch buffer and, with a BufferMarshaller, are decoded straight into value, so no
+     * heap copy of the value is created.
+     *
+     * \param key the key whose associated value is to be read
+     * \param value the object overwritten with the mapped value, untouched if there's no mapping
+     * \return true if the key has a mapping, false otherwise
+     */
+    bool get(const K& key, V& value)
+    {
+        ScratchBuffer scratch;
+        if (!base_getInto(&key, scratch.get())) {
+            return false;
+        }
+        return unmarshallInto(*valueMarshaller, scratch.get(), value);
+    }
+
 private:
     V* get_async(const K& key)
     {
@@ -169,12 +210,12 @@ public:
             this->keyMarshaller->marshall(*item, v);
             keySetMarshalled.insert(v);
         }
-        auto marshalledResult = base_getAll(keySetMarshalled);
+        auto marshalledResult = base_getAll(keySetMarshalled, transactionManager.getCurrentTransaction());
         std::map<std::shared_ptr<K>, std::shared_ptr<V> > result;
         for (auto item : marshalledResult)
         {
             std::shared_ptr<K> rk(this->keyMarshaller->unmarshall(item.first));
-            std::shared_ptr<V> rv(this->keyMarshaller->unmarshall(item.second));
+            std::shared_ptr<V> rv(this->valueMarshaller->unmarshall(item.second));
             result[rk] = rv;
         }
         return result;
@@ -1010,6 +1051,82 @@ public:
         return base_query(qr);
     }
 
+    /**
+     * Execute a query on server and unwrap the resulting entities into an arena backed result set
+     * \param qr the QueryRequest oject
+     * \param results the result set receiving the entities
+     * \return false if the query has a projection, true otherwise
+     */
+    template <class T> bool query(const QueryRequest &qr, QueryResultSet<T>& results)
+    {
+        return results.unwrap(base_query_arena(qr, results.getArena()));
+    }
+
+    /**
+     * Enable the client side cache of query results. Queries equal to a recent one, including paging
+     * and parameters, are answered from the cache without contacting the server. Results can be stale
+     * up to the lifespan, see also invalidateQueryCacheOn(). Hits and misses are reported by stats()
+     * \param lifespan how long a result is reused
+     * \param lifespanUnit TimeUnit for the lifespan param
+     * \param maxEntries the maximum number of results kept
+     */
+    void enableQueryCache(uint64_t lifespan, TimeUnit lifespanUnit, size_t maxEntries = 1000)
+    {
+        base_enableQueryCache(toMilliseconds(lifespan, lifespanUnit), maxEntries);
+    }
+
+    /**
+     * Disable the client side cache of query results and drop its content
+     */
+    void disableQueryCache()
+    {
+        base_disableQueryCache();
+    }
+
+    /**
+     * Drop all the cached query results
+     */
+    void clearQueryCache()
+    {
+        base_clearQueryCache();
+    }
+
+    /**
+     * Drop the cached query results whenever the result set of a continuous query changes or
+     * the listener fails over. Listeners already set on cql keep being called. Use it before
+     * addContinuousQueryListener()
+     * \param cql the continuous query listener
+     */
+    template <typename... Params> void invalidateQueryCacheOn(ContinuousQueryListener<K, V, Params...>& cql)
+    {
+        RemoteCache<K, V> cache(*this);
+        cql.setJoiningListener(invalidating(cache, cql.getJoiningListener()));
+        cql.setLeavingListener(invalidating(cache, cql.getLeavingListener()));
+        cql.setUpdatedListener(invalidating(cache, cql.getUpdatedListener()));
+        std::function<void()> failover = cql.getFailoverListener();
+        cql.setFailoverListener([cache, failover]() mutable {
+            cache.clearQueryCache();
+            if (failover) {
+                failover();
+            }
+        });
+    }
+
+    /**
+     * Execute a query on server one page at a time. The next page is fetched while the current one
+     * is consumed, so only two pages are held in memory at any time
+     * \param qr the QueryRequest oject
+     * \param pageSize the number of entities fetched per page
+     * \return a cursor over the entities matching the query
+     */
+    template <class T> QueryCursor<T> queryCursor(const QueryRequest &qr, int pageSize)
+    {
+        RemoteCache<K, V> cache(*this);
+        return QueryCursor<T>([cache](const QueryRequest& pageRequest, google::protobuf::Arena& arena) mutable {
+            return cache.base_query_arena(pageRequest, arena);
+        }, qr, pageSize);
+    }
+
     /**
      * Execute a query on server
      * \param qr the query string
@@ -1190,6 +1307,8 @@ public:
     }
     /**
      * Applies one or more Flag enums to the scope of a single invocation.
+     * The flags are bound to the calling thread and apply to its next invocation
+     * on this cache, so concurrent threads don't see each other's flags.
      *
      * \param flags the flags to apply to an invocation
      * \return the current RemoteCache instance
@@ -1267,6 +1386,31 @@ protected:
     }
 
 private:
+    template <class E> static std::function<void(K, E)> invalidating(RemoteCache<K, V> cache, std::function<void(K, E)> listener)
+    {
+        return [cache, listener](K k, E e) mutable {
+            cache.clearQueryCache();
+            if (listener) {
+                listener(k, e);
+            }
+        };
+    }
+
+    uint64_t toMilliseconds(uint64_t time, TimeUnit unit)
+    {
+        switch (unit)
+        {
+        case NANOSECONDS:
+            return (uint64_t) ceil(time / 1000000.0);
+        case MICROSECONDS:
+            return (uint64_t) ceil(time / 1000.0);
+        case MILLISECONDS:
+            return time;
+        default:
+            return toSeconds(time, unit) * 1000;
+        }
+    }
+
     uint64_t toSeconds(uint64_t time, TimeUnit unit)
     {
         uint64_t result;
@@ -53,13 +53,16 @@ public:
     HR_EXTERN uint32_t base_prepareCommit(XID xid, TransactionContext& tctx);
     HR_EXTERN uint32_t base_commit(XID xid, TransactionContext& tctx);
     HR_EXTERN uint32_t base_rollback(XID xid, TransactionContext& tctx);
+    // Prepares and commits in a single round trip, for a transaction that touches only this cache
+    HR_EXTERN uint32_t base_onePhaseCommit(XID xid, TransactionContext& tctx);
 
 
 protected:
     HR_EXTERN const char *base_getName();
     HR_EXTERN const std::string& base_getNameAsString();
     HR_EXTERN void *base_get(const void *key, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
-    HR_EXTERN std::map<std::vector<char>,std::vector<char> > base_getAll(const std::set<std::vector<char> >& keySet);
+    HR_EXTERN bool  base_getInto(const void *key, std::vector<char>& value, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
+    HR_EXTERN std::map<std::vector<char>,std::vector<char> > base_getAll(const std::set<std::vector<char> >& keySet, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
     HR_EXTERN void *base_put(const void *key, const void *value, int64_t life, int64_t idle, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
     HR_EXTERN void  base_putAll(const std::map<const void*, const void*>& map,  int64_t life, int64_t idle, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
     HR_EXTERN void *base_putIfAbsent(const void *key, const void *value, int64_t life, int64_t idle, std::shared_ptr<Transaction> currentTxPtr = std::shared_ptr<Transaction>());
@@ -77,6 +80,7 @@ protected:
     HR_EXTERN void  base_clear();
     HR_EXTERN uint64_t  base_size();
     HR_EXTERN void  base_withFlags(Flag flag);
+    HR_EXTERN Flag  base_takeFlags();
     HR_EXTERN std::vector<unsigned char> base_execute(const std::string &cmdName,  const std::map<std::string,std::string>& args);
     HR_EXTERN std::vector<unsigned char> base_execute(const std::string &cmdName, const std::map<std::vector<char> ,std::vector<char> >& args);
     HR_EXTERN std::vector<char> base_execute(const std::vector<char> &cmdName, const std::map<std::vector<char> ,std::vector<char> >& args);
@@ -85,6 +89,10 @@ protected:
     HR_EXTERN std::vector<char> base_execute(const void* key, const std::vector<char> &cmdName, const std::map<std::vector<char> ,std::vector<char> >& args);
     HR_EXTERN CacheTopologyInfo base_getCacheTopologyInfo();
     HR_EXTERN QueryResponse base_query(const QueryRequest &qr);
+    HR_EXTERN QueryResponse* base_query_arena(const QueryRequest &qr, google::protobuf::Arena& arena);
+    HR_EXTERN void base_enableQueryCache(uint64_t lifespanMillis, size_t maxEntries);
+    HR_EXTERN void base_disableQueryCache();
+    HR_EXTERN void base_clearQueryCache();
     HR_EXTERN std::vector<unsigned char> base_query_char(std::vector<unsigned char> qr, size_t size);
 
 	HR_EXTERN void base_addClientListener(ClientListener &clientListener, const std::vector<std::vector<char> > filterFactoryParam, const std::vector<std::vector<char> > converterFactoryParams, const std::function<void()> &recoveryCallback);
@@ -117,6 +125,8 @@ protected:
 		filterFactoryParams.push_back(param);
 		std::vector<std::vector<char> > converterFactoryParams;
 		cql.cl.useRawData = true;
+		// A listener added again, e.g. by its failover listener, keeps its first callback
+		bool callbackAdded = static_cast<bool>(cql.listenerCustomEvent);
 		cql.listenerCustomEvent =
 				[this, &cql](ClientCacheEntryCustomEvent e) {
 					ContinuousQueryResult r;
@@ -142,7 +152,9 @@ protected:
 						break;
 					}
 				};
-		cql.cl.add_listener(cql.listenerCustomEvent);
+		if (!callbackAdded) {
+			cql.cl.add_listener(cql.listenerCustomEvent);
+		}
 		this->base_addClientListener(cql.cl, filterFactoryParams,
 				converterFactoryParams, cql.getFailoverListener());
     }
@@ -165,6 +177,8 @@ protected:
 		filterFactoryParams.push_back(param);
 		std::vector<std::vector<char> > converterFactoryParams;
 		cql.cl.useRawData = true;
+		// A listener added again, e.g. by its failover listener, keeps its first callback
+		bool callbackAdded = static_cast<bool>(cql.listenerCustomEvent);
 		cql.listenerCustomEvent =
 				[this, &cql](ClientCacheEntryCustomEvent e) {
 					ContinuousQueryResult r;
@@ -189,7 +203,9 @@ protected:
 						break;
 					}
 				};
-		cql.cl.add_listener(cql.listenerCustomEvent);
+		if (!callbackAdded) {
+			cql.cl.add_listener(cql.listenerCustomEvent);
+		}
 		this->base_addClientListener(cql.cl, filterFactoryParams,
 				converterFactoryParams, cql.getFailoverListener());
 	}
@@ -231,6 +247,8 @@ private:
     HR_EXTERN void* baseKeyUnmarshall(const std::vector<char> &buf);
     HR_EXTERN void* baseValueUnmarshall(const std::vector<char> &buf);
     void* transactional_base_get(Transaction& currentTransaction, const void* key);
+    std::map<std::vector<char>, std::vector<char> > transactional_base_getAll(Transaction& currentTransaction,
+            const std::set<std::vector<char> >& keySet);
     void* transactional_base_put(Transaction& currentTransaction, const void* key, const void* val, int64_t life,
             int64_t idle, bool forceRV);
 
@@ -13,6 +13,9 @@
 
 #include <string>
 #include <set>
+#include <map>
+#include <memory>
+#include <cstdint>
 
 namespace infinispan {
 namespace hotrod {
@@ -53,6 +56,31 @@ public:
      */
     virtual std::shared_ptr<WeakCounter> getWeakCounter(std::string name) = 0;
 
+    /**
+     * Returns an accumulating {@link WeakCounter} with that specific name.
+     * <p>
+     * Updates are summed locally in striped cells and sent to the server as a single aggregated delta
+     * every {@code flushIntervalMillis}, as soon as {@code flushThreshold} updates are pending or before
+     * WeakCounter::getValue() is evaluated. Pending updates are also flushed when the manager is stopped,
+     * but they are lost if the process terminates abruptly.
+     * <p>
+     * This method only supports CounterType::WEAK counters. All the calls for a counter return the same
+     * instance, so they must use the same flush settings. Once the manager is stopped the instance throws
+     * on any update or read.
+     * <p>
+     * The default implementation doesn't accumulate and returns getWeakCounter(name).
+     *
+     * @param name the counter name.
+     * @param flushIntervalMillis the period of the background flush, 0 disables it.
+     * @param flushThreshold the number of pending updates that triggers a flush, 0 flushes every update.
+     * @return the WeakCounter instance.
+     * @throws HotRodClientException if the counter is already accumulated with other flush settings.
+     */
+    virtual std::shared_ptr<WeakCounter> getAccumulatingWeakCounter(std::string name,
+            uint32_t /*flushIntervalMillis*/ = 1000, uint32_t /*flushThreshold*/ = 10000) {
+        return getWeakCounter(name);
+    }
+
     /**
      * Defines a counter with the specific {@code name} and {@link CounterConfiguration}.
      * <p>
@@ -94,6 +122,18 @@ public:
      */
     virtual std::set<std::string> getCounterNames() = 0;
 
+    /**
+     * Returns the current values of a set of counters.
+     * <p>
+     * No counter configuration is retrieved and no counter instance is created, and the reads are
+     * pipelined on a single connection, so this is faster than calling getValue() on each counter in turn.
+     *
+     * @param counterNames the names of the counters to read.
+     * @return a map from counter name to its current value.
+     * @throws HotRodClientException if one of the counters cannot be read.
+     */
+    virtual std::map<std::string, long> getValues(const std::set<std::string>& counterNames) = 0;
+
     virtual ~RemoteCounterManager() {
     }
     ;
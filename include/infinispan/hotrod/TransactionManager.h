@@ -57,6 +57,8 @@ private:
 
     std::vector<char> generateV4UUID();
     void throwExceptionOnIllegalState(const std::string& state, const std::string& action);
+    bool isOnePhase(Transaction& t);
+    void remoteOnePhaseCommit(Transaction& t);
     HR_EXTERN TransactionRemoteStatus remotePrepareCommit(Transaction& t);
     HR_EXTERN void cleanUpCurrentTransaction();
     HR_EXTERN void remoteCommit(Transaction& t);
@@ -11,6 +11,7 @@
 #include "infinispan/hotrod/MetadataValue.h"
 #include "infinispan/hotrod/ImportExport.h"
 #include <map>
+#include <unordered_map>
 #include <thread>
 #include <vector>
 #include <functional>
@@ -66,6 +67,20 @@ enum class TransactionRemoteStatus : unsigned int {
     XA_RBROLLBACK = 0x64
 };
 
+/**
+ * FNV-1a hash of a marshalled key
+ */
+struct ByteVectorHash {
+    size_t operator()(const std::vector<char>& v) const {
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : v) {
+            h ^= (unsigned char) c;
+            h *= 1099511628211ULL;
+        }
+        return (size_t) h;
+    }
+};
+
 /**
  * A transaction context for the RemoteCacheBase class
  */
@@ -83,6 +98,8 @@ public:
         std::function<void (const void *)> deleter;
         std::function<void (const void *, std::vector<char>&)> valueMarshaller;
         unsigned char controlByte = NONE;
+        // The value marshalled when it entered the context, written as is at prepare time
+        std::vector<char> marshalledValue;
         ContextEntry() : action(SET), value(nullptr), changed(false) {}
         ContextEntry(Action action, const void* value, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller) : action(action), value(value), changed(false), deleter(deleter), valueMarshaller(valueMarshaller) {}
         ContextEntry(Action action, const void* value, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller) : action(action), value(value), origMeta(meta), meta(meta), changed(false), deleter(deleter), valueMarshaller(valueMarshaller) {}
@@ -101,14 +118,18 @@ public:
     const void* getValue(const std::vector<char>& key);
     ContextEntry& getEntry(std::vector<char>& key);
     void addValue(std::vector<char>& key, const void* value, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller, ControlBit cb = NONE);
+    // As above, for a value that is already marshalled in marshalledValue
+    void addValue(std::vector<char>& key, const void* value, std::vector<char>&& marshalledValue, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller, ControlBit cb = NONE);
     void setValue(std::vector<char>& key, const void* value, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller);
     void setValueAsDeleted(std::vector<char>& key);
     void removeEntry(const std::vector<char>& key);
     void clear();
     void getBulk(int size, std::map<std::vector<char>, const void*> &mbuf);
     int size();
+    // True if the context holds only values read from the server and never changed
+    bool isReadOnly();
 private:
-    std::map<const std::vector<char>, ContextEntry> context;
+    std::unordered_map<std::vector<char>, ContextEntry, ByteVectorHash> context;
     friend TransactionManager;
     friend operations::PrepareCommitOperation;
     TransactionRemoteStatus status = TransactionRemoteStatus::XA_OK;
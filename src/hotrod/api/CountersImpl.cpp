@@ -7,6 +7,7 @@
 
 #include <hotrod/api/CountersImpl.h>
 #include "hotrod/impl/operations/CounterOperations.h"
+#include "hotrod/sys/Log.h"
 
 namespace infinispan {
 namespace hotrod {
@@ -29,6 +30,14 @@ long BaseCounterImpl::getValue() {
     return op.execute();
 }
 
+std::future<long> BaseCounterImpl::getValueAsync() {
+    auto request = std::make_shared<PipelinedOperation<GetCounterValueOperation, long> >(*rcm.codec,
+            rcm.transportFactory, rcm.topology, 0, name);
+    std::future<long> result = request->getFuture();
+    rcm.submit(request);
+    return result;
+}
+
 const void* BaseCounterImpl::addListener(const event::CounterListener* listener) {
     return rcm.addListener(getName(), listener);
 }
@@ -42,17 +51,115 @@ long StrongCounterImpl::addAndGet(long delta) {
     return op.execute();
 }
 
+std::future<long> StrongCounterImpl::addAndGetAsync(long delta) {
+    auto request = std::make_shared<PipelinedOperation<AddAndGetCounterValueOperation, long> >(*rcm.codec,
+            rcm.transportFactory, rcm.topology, 0, name, delta);
+    std::future<long> result = request->getFuture();
+    rcm.submit(request);
+    return result;
+}
+
 long StrongCounterImpl::compareAndSwap(long expect, long update) {
     CompareAndSwapCounterValueOperation op(*rcm.codec, rcm.transportFactory, rcm.topology, 0, name, expect, update,
             configuration);
     return op.execute();
 }
 
+std::future<long> StrongCounterImpl::compareAndSwapAsync(long expect, long update) {
+    auto request = std::make_shared<PipelinedOperation<CompareAndSwapCounterValueOperation, long> >(*rcm.codec,
+            rcm.transportFactory, rcm.topology, 0, name, expect, update, configuration);
+    std::future<long> result = request->getFuture();
+    rcm.submit(request);
+    return result;
+}
+
 void WeakCounterImpl::add(long delta) {
     AddAndGetCounterValueOperation op(*rcm.codec, rcm.transportFactory, rcm.topology, 0, name, delta);
     op.execute();
 }
 
+AccumulatingWeakCounterImpl::AccumulatingWeakCounterImpl(RemoteCounterManagerImpl& rcm, std::string name,
+        CounterConfiguration configuration, uint32_t flushIntervalMillis, uint32_t flushThreshold) :
+        WeakCounterImpl(rcm, name, configuration), pending(0), closed(false), flushInterval(flushIntervalMillis), flushThreshold(
+                flushThreshold), nextFlush(std::chrono::steady_clock::now() + flushInterval) {
+    for (auto& cell : cells) {
+        cell.value = 0;
+    }
+}
+
+AccumulatingWeakCounterImpl::~AccumulatingWeakCounterImpl() {
+}
+
+size_t AccumulatingWeakCounterImpl::stripe() {
+    static std::atomic<size_t> nextStripe(0);
+    static thread_local size_t threadStripe = nextStripe.fetch_add(1) % STRIPES;
+    return threadStripe;
+}
+
+void AccumulatingWeakCounterImpl::checkOpen() {
+    if (closed) {
+        throw HotRodClientException(name + " counter is closed, its manager has been stopped");
+    }
+}
+
+long AccumulatingWeakCounterImpl::getValue() {
+    checkOpen();
+    flush();
+    return WeakCounterImpl::getValue();
+}
+
+std::future<long> AccumulatingWeakCounterImpl::getValueAsync() {
+    checkOpen();
+    flush();
+    return WeakCounterImpl::getValueAsync();
+}
+
+void AccumulatingWeakCounterImpl::add(long delta) {
+    checkOpen();
+    cells[stripe()].value.fetch_add(delta, std::memory_order_relaxed);
+    if (pending.fetch_add(1, std::memory_order_relaxed) + 1 >= flushThreshold) {
+        // Don't queue up behind a flush already in progress, it will carry this update too
+        std::unique_lock<std::mutex> guard(flushMutex, std::try_to_lock);
+        if (guard.owns_lock()) {
+            flushPending(guard);
+        }
+    }
+}
+
+void AccumulatingWeakCounterImpl::flush() {
+    std::unique_lock<std::mutex> guard(flushMutex);
+    flushPending(guard);
+}
+
+void AccumulatingWeakCounterImpl::flushPending(std::unique_lock<std::mutex>& /*guard*/) {
+    pending.store(0, std::memory_order_relaxed);
+    long delta = 0;
+    for (auto& cell : cells) {
+        delta += cell.value.exchange(0, std::memory_order_relaxed);
+    }
+    // Updates racing with close() are dropped, the manager can't send them anymore
+    if (delta == 0 || removed || closed) {
+        return;
+    }
+    try {
+        WeakCounterImpl::add(delta);
+    } catch (...) {
+        // Keep the delta for the next flush
+        cells[0].value.fetch_add(delta, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+void AccumulatingWeakCounterImpl::close() {
+    std::unique_lock<std::mutex> guard(flushMutex);
+    try {
+        flushPending(guard);
+    } catch (const std::exception& e) {
+        WARN("Unable to flush pending updates for counter %s: %s", name.c_str(), e.what());
+    }
+    closed = true;
+}
+
 }
 }
 
@@ -12,6 +12,9 @@
 #include "hotrod/impl/RemoteCounterManagerImpl.h"
 #include <string>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 namespace infinispan {
 namespace hotrod {
@@ -39,6 +42,8 @@ public:
 
     virtual long getValue();
 
+    virtual std::future<long> getValueAsync();
+
     const void* addListener(const event::CounterListener* listener);
 
     void removeListener(const void* handler);
@@ -50,7 +55,7 @@ protected:
     RemoteCounterManagerImpl& rcm;
     std::string name;
     CounterConfiguration configuration;
-    bool removed;
+    std::atomic<bool> removed;
 };
 
 class StrongCounterImpl: public BaseCounterImpl, public virtual StrongCounter {
@@ -63,8 +68,14 @@ public:
         return BaseCounterImpl::getValue();
     }
 
+    std::future<long> getValueAsync() {
+        return BaseCounterImpl::getValueAsync();
+    }
+
     long addAndGet(long delta);
 
+    std::future<long> addAndGetAsync(long delta);
+
     long incrementAndGet() {
         return addAndGet(1L);
     }
@@ -75,6 +86,8 @@ public:
 
     long compareAndSwap(long expect, long update);
 
+    std::future<long> compareAndSwapAsync(long expect, long update);
+
     bool compareAndSet(long expect, long update) {
         return compareAndSwap(expect, update) == expect;
     }
@@ -90,6 +103,10 @@ public:
         return BaseCounterImpl::getValue();
     }
 
+    std::future<long> getValueAsync() {
+        return BaseCounterImpl::getValueAsync();
+    }
+
     void increment() {
         return add(1L);
     }
@@ -101,6 +118,62 @@ public:
     void add(long delta);
 };
 
+/*
+ * A weak counter that sums the updates in local striped cells and sends
+ * them to the server as one aggregated delta. A flush happens on the timer
+ * of the manager, when the number of pending updates reaches the threshold
+ * or before reading the value.
+ */
+class AccumulatingWeakCounterImpl: public WeakCounterImpl {
+public:
+    AccumulatingWeakCounterImpl(RemoteCounterManagerImpl& rcm, std::string name, CounterConfiguration configuration,
+            uint32_t flushIntervalMillis, uint32_t flushThreshold);
+
+    ~AccumulatingWeakCounterImpl();
+
+    long getValue();
+
+    std::future<long> getValueAsync();
+
+    void add(long delta);
+
+    // Sends all the pending updates to the server
+    void flush();
+
+    // Sends the pending updates. A closed counter can't be updated or read
+    void close();
+
+    uint32_t getFlushIntervalMillis() const {
+        return (uint32_t) flushInterval.count();
+    }
+
+    uint32_t getFlushThreshold() const {
+        return flushThreshold;
+    }
+
+private:
+    static const size_t STRIPES = 16;
+    // Padded to a cache line to avoid false sharing between threads
+    struct Cell {
+        std::atomic<long> value;
+        char pad[64 - sizeof(std::atomic<long>)];
+    };
+    Cell cells[STRIPES];
+    std::atomic<uint32_t> pending;
+    std::atomic<bool> closed;
+    const std::chrono::milliseconds flushInterval;
+    const uint32_t flushThreshold;
+    std::mutex flushMutex;
+    // Next timed flush, guarded by the countersLock of the manager
+    std::chrono::steady_clock::time_point nextFlush;
+
+    static size_t stripe();
+    void checkOpen();
+    void flushPending(std::unique_lock<std::mutex>& guard);
+
+    friend class RemoteCounterManagerImpl;
+};
+
 }
 }
 
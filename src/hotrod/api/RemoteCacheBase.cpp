@@ -73,6 +73,50 @@ void* RemoteCacheBase::transactional_base_get(Transaction& currentTransaction, c
     return retVal;
 }
 
+// If a transaction is ongoing get the values for the keys in a transactional way.
+// All the keys missing from the context are fetched with their versions, the reads are pipelined per owner
+std::map<std::vector<char>, std::vector<char>> RemoteCacheBase::transactional_base_getAll(
+        Transaction& currentTransaction, const std::set<std::vector<char>>& keySet) {
+    if (!currentTransaction.acceptRead()) {
+        throw HotRodClientTxStateException(currentTransaction.statusToString(), "getAll");
+    }
+    SynchronizationAdapter& sa = transactionTable.getAdapter(currentTransaction);
+    TransactionContext& tc = sa.getTransactionContext(this);
+    std::set<std::vector<char>> missingKeys;
+    for (auto& key : keySet) {
+        if (!tc.hasValue(key)) {
+            missingKeys.insert(key);
+        }
+    }
+    std::map<std::vector<char>, std::vector<char>> result;
+    if (!missingKeys.empty()) {
+        auto remoteEntries = IMPL->getAllWithMetadata(missingKeys);
+        for (auto& key : missingKeys) {
+            std::vector<char> marshalledKey(key);
+            auto& entry = remoteEntries[key];
+            std::vector<char> valueBytes = entry.getValue();
+            MetadataValue meta = entry;
+            const void* value = valueBytes.data() ? baseValueUnmarshall(valueBytes) : nullptr;
+            if (value) {
+                result[key] = valueBytes;
+            }
+            // The context keeps the bytes as read, they are written back as is at prepare time
+            tc.addValue(marshalledKey, value, std::move(valueBytes), meta, this->valueDestructor, this->valueMarshallerFn,
+                    (value ? TransactionContext::ControlBit::NONE : TransactionContext::ControlBit::NON_EXISTING));
+        }
+    }
+    // Keys already in the context may have been changed by this transaction
+    for (auto& key : keySet) {
+        if (missingKeys.find(key) == missingKeys.end()) {
+            if (tc.getValue(key) != nullptr) {
+                std::vector<char> marshalledKey(key);
+                result[key] = tc.getEntry(marshalledKey).marshalledValue;
+            }
+        }
+    }
+    return result;
+}
+
 // If a transaction is ongoing put the (key,value) pair into the tx context
 void* RemoteCacheBase::transactional_base_put(Transaction& currentTransaction, const void* key, const void* val,
         int64_t life, int64_t idle, bool forceRV) {
@@ -108,7 +152,32 @@ void *RemoteCacheBase::base_get(const void *key, std::shared_ptr<Transaction> cu
     return IMPL->get(*this, key);
 }
 
-std::map<std::vector<char>, std::vector<char>> RemoteCacheBase::base_getAll(const std::set<std::vector<char>>& keySet) {
+bool RemoteCacheBase::base_getInto(const void *key, std::vector<char>& value, std::shared_ptr<Transaction> currentTxPtr) {
+    if (transactional) {
+        Transaction& currentTransaction = currentTxPtr ? *currentTxPtr : *transactionManager.getCurrentTransaction();
+        if (currentTransaction.getStatus() != NO_TRANSACTION) {
+            // The transaction context holds objects, the value is marshalled from the context copy
+            void* retVal = transactional_base_get(currentTransaction, key);
+            if (retVal == nullptr) {
+                value.clear();
+                return false;
+            }
+            baseValueMarshall(retVal, value);
+            valueDestructor(retVal);
+            return true;
+        }
+    }
+    return IMPL->getInto(*this, key, value);
+}
+
+std::map<std::vector<char>, std::vector<char>> RemoteCacheBase::base_getAll(const std::set<std::vector<char>>& keySet,
+        std::shared_ptr<Transaction> currentTxPtr) {
+    if (transactional) {
+        Transaction& currentTransaction = currentTxPtr ? *currentTxPtr : *transactionManager.getCurrentTransaction();
+        if (currentTransaction.getStatus() != NO_TRANSACTION) {
+            return transactional_base_getAll(currentTransaction, keySet);
+        }
+    }
     return IMPL->getAll(keySet);
 }
 
@@ -356,6 +425,10 @@ void RemoteCacheBase::base_withFlags(Flag flags) {
     IMPL->withFlags(flags);
 }
 
+Flag RemoteCacheBase::base_takeFlags() {
+    return IMPL->takeFlags();
+}
+
 std::vector<unsigned char> RemoteCacheBase::base_execute(const std::string &cmdName, const std::map<std::string,std::string>& args){
 	std::map<std::vector<char>,std::vector<char>> m;
     std::vector<char> cmdNameBuf;
@@ -419,6 +492,29 @@ QueryResponse RemoteCacheBase::base_query(const QueryRequest &qr)
 	return IMPL->query(qr);
 }
 
+QueryResponse* RemoteCacheBase::base_query_arena(const QueryRequest &qr, google::protobuf::Arena& arena)
+{
+	std::vector<char> respBytes = IMPL->queryBytes(qr);
+	QueryResponse* resp = google::protobuf::Arena::CreateMessage<QueryResponse>(&arena);
+	resp->ParseFromArray(respBytes.data(), (int)respBytes.size());
+	return resp;
+}
+
+void RemoteCacheBase::base_enableQueryCache(uint64_t lifespanMillis, size_t maxEntries)
+{
+	IMPL->enableQueryCache(std::chrono::milliseconds(lifespanMillis), maxEntries);
+}
+
+void RemoteCacheBase::base_disableQueryCache()
+{
+	IMPL->disableQueryCache();
+}
+
+void RemoteCacheBase::base_clearQueryCache()
+{
+	IMPL->clearQueryCache();
+}
+
 std::vector<unsigned char> RemoteCacheBase::base_query_char(std::vector<unsigned char> qr, size_t size)
 {
 	QueryRequest req;
@@ -426,16 +522,9 @@ std::vector<unsigned char> RemoteCacheBase::base_query_char(std::vector<unsigned
 	if (!req.has_local()) {
 		req.set_local(false);
 	}
-	QueryResponse resp= IMPL->query(req);
-
-#if GOOGLE_PROTOBUF_VERSION < 3004001
-	int respSize = resp.ByteSize();
-#else
-	int respSize = resp.ByteSizeLong();
-#endif
-	std::vector<unsigned char> respToChar(respSize);
-        resp.SerializeToArray(respToChar.data(),respSize);
-	return respToChar;
+	// The response is handed back marshalled, no need to parse it
+	std::vector<char> respBytes = IMPL->queryBytes(req);
+	return std::vector<unsigned char>(respBytes.begin(), respBytes.end());
 }
 
 
@@ -465,7 +554,7 @@ void RemoteCacheBase::putScript(const std::vector<char>& name, const std::vector
 }
 
 uint32_t RemoteCacheBase::base_prepareCommit(XID xid, TransactionContext& tctx) {
-    return IMPL->prepareCommit(xid, tctx);
+    return IMPL->prepareCommit(xid, tctx, false);
 }
 
 uint32_t RemoteCacheBase::base_commit(XID xid, TransactionContext& tctx) {
@@ -476,6 +565,10 @@ uint32_t RemoteCacheBase::base_rollback(XID xid, TransactionContext& tctx) {
     return IMPL->rollback(xid, tctx);
 }
 
+uint32_t RemoteCacheBase::base_onePhaseCommit(XID xid, TransactionContext& tctx) {
+    return IMPL->prepareCommit(xid, tctx, true);
+}
+
 void RemoteCacheBase::cloneImplWithDataFormat(EntryMediaTypes *df) {
     impl.reset(new RemoteCacheImpl(*impl));
     impl->setDataFormat(df); }
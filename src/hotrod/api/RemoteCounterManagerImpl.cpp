@@ -2,6 +2,8 @@
 #include "infinispan/hotrod/Counters.h"
 #include "hotrod/impl/RemoteCounterManagerImpl.h"
 #include "hotrod/impl/operations/CounterOperations.h"
+#include "hotrod/sys/Log.h"
+#include <algorithm>
 #include <random>
 #include <list>
 #include <functional>
@@ -22,6 +24,10 @@ using namespace infinispan::hotrod::operations;
 
 void RemoteCounterManagerImpl::start(std::shared_ptr<transport::TransportFactory> t, protocol::Codec* c) {
     const static char COUNTERCACHENAME[] = "org.infinispan.counter";
+    {
+        std::lock_guard<std::mutex> guard(dispatcherLock);
+        dispatcherStopping = false;
+    }
     started = true;
     codec = c;
     transportFactory = t;
@@ -29,39 +35,148 @@ void RemoteCounterManagerImpl::start(std::shared_ptr<transport::TransportFactory
             std::vector<char>(COUNTERCACHENAME, COUNTERCACHENAME + sizeof(COUNTERCACHENAME) - 1));
 }
 void RemoteCounterManagerImpl::stop() {
+    stopDispatcher();
+    stopFlusher();
+    // The handles still held by the application refuse any further update, see AccumulatingWeakCounterImpl::close()
+    std::map<std::string, std::shared_ptr<AccumulatingWeakCounterImpl>> toClose;
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        toClose.swap(accumulatingCounters);
+    }
+    for (auto& it : toClose) {
+        it.second->close();
+    }
     started = false;
     codec = nullptr;
     transportFactory.reset();
 }
 
+CounterConfiguration RemoteCounterManagerImpl::fetchConfiguration(const std::string& name, bool weak) {
+    GetCounterConfigurationOperation op(*codec, transportFactory, topology, 0, name);
+    CounterConfiguration cc = op.execute();
+    if (weak && cc.getType() != CounterType::WEAK) {
+        throw HotRodClientException(name + " counter is the wrong type (strong instead of weak");
+    }
+    if (!weak && cc.getType() == CounterType::WEAK) {
+        throw HotRodClientException(name + " counter is the wrong type (weak instead of strong");
+    }
+    return cc;
+}
+
 std::shared_ptr<StrongCounter> RemoteCounterManagerImpl::getStrongCounter(std::string name) {
-    auto it = counters.find(name);
-    if (it == counters.end()) {
-        GetCounterConfigurationOperation op(*codec, transportFactory, topology, 0, name);
-        CounterConfiguration cc = op.execute();
-        if (cc.getType() == CounterType::WEAK) {
-            throw HotRodClientException(name + " counter is the wrong type (weak instead of strong");
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        auto it = counters.find(name);
+        if (it != counters.end()) {
+            std::shared_ptr<StrongCounterImpl> sc = std::dynamic_pointer_cast<StrongCounterImpl>(it->second);
+            if (!sc) {
+                throw HotRodClientException(name + " counter is the wrong type (weak instead of strong");
+            }
+            return sc;
         }
-        std::shared_ptr<StrongCounterImpl> sc(new StrongCounterImpl(*this, name, cc));
-        counters[name] = sc;
-        return sc;
     }
-    return std::static_pointer_cast<StrongCounterImpl>(it->second);
+    // Not holding the lock while going remote, a concurrent lookup may win the insertion
+    std::shared_ptr<BaseCounterImpl> sc(new StrongCounterImpl(*this, name, fetchConfiguration(name, false)));
+    std::lock_guard<std::mutex> guard(countersLock);
+    return std::static_pointer_cast<StrongCounterImpl>(counters.insert(std::make_pair(name, sc)).first->second);
 }
 
 std::shared_ptr<WeakCounter> RemoteCounterManagerImpl::getWeakCounter(std::string name) {
-    auto it = counters.find(name);
-    if (it == counters.end()) {
-        GetCounterConfigurationOperation op(*codec, transportFactory, topology, 0, name);
-        CounterConfiguration cc = op.execute();
-        if (cc.getType() != CounterType::WEAK) {
-            throw HotRodClientException(name + " counter is the wrong type (strong instead of weak");
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        auto it = counters.find(name);
+        if (it != counters.end()) {
+            std::shared_ptr<WeakCounterImpl> wc = std::dynamic_pointer_cast<WeakCounterImpl>(it->second);
+            if (!wc) {
+                throw HotRodClientException(name + " counter is the wrong type (strong instead of weak");
+            }
+            return wc;
+        }
+    }
+    std::shared_ptr<BaseCounterImpl> wc(new WeakCounterImpl(*this, name, fetchConfiguration(name, true)));
+    std::lock_guard<std::mutex> guard(countersLock);
+    return std::static_pointer_cast<WeakCounterImpl>(counters.insert(std::make_pair(name, wc)).first->second);
+}
+
+// A counter is accumulated by a single handle, asking it again with other flush settings is an error
+static std::shared_ptr<AccumulatingWeakCounterImpl> checkFlushSettings(std::shared_ptr<AccumulatingWeakCounterImpl> wc,
+        uint32_t flushIntervalMillis, uint32_t flushThreshold) {
+    if (wc->getFlushIntervalMillis() != flushIntervalMillis || wc->getFlushThreshold() != flushThreshold) {
+        throw HotRodClientException(wc->getName() + " counter is already accumulated with other flush settings");
+    }
+    return wc;
+}
+
+std::shared_ptr<WeakCounter> RemoteCounterManagerImpl::getAccumulatingWeakCounter(std::string name,
+        uint32_t flushIntervalMillis, uint32_t flushThreshold) {
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        auto it = accumulatingCounters.find(name);
+        if (it != accumulatingCounters.end()) {
+            return checkFlushSettings(it->second, flushIntervalMillis, flushThreshold);
+        }
+    }
+    std::shared_ptr<AccumulatingWeakCounterImpl> wc(
+            new AccumulatingWeakCounterImpl(*this, name, fetchConfiguration(name, true), flushIntervalMillis,
+                    flushThreshold));
+    std::lock_guard<std::mutex> guard(countersLock);
+    auto inserted = accumulatingCounters.insert(std::make_pair(name, wc));
+    if (inserted.second && flushIntervalMillis > 0) {
+        if (!flusher.joinable()) {
+            flusherStopping = false;
+            flusher = std::thread(&RemoteCounterManagerImpl::runFlusher, this);
         }
-        std::shared_ptr<WeakCounterImpl> sc(new WeakCounterImpl(*this, name, cc));
-        counters[name] = sc;
-        return sc;
+        flusherCond.notify_all();
+    }
+    return checkFlushSettings(inserted.first->second, flushIntervalMillis, flushThreshold);
+}
+
+void RemoteCounterManagerImpl::stopFlusher() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        flusherStopping = true;
+        stopped.swap(flusher);
+    }
+    flusherCond.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+// Flushes the counters whose interval has elapsed, then sleeps until the next one is due
+void RemoteCounterManagerImpl::runFlusher() {
+    std::unique_lock<std::mutex> guard(countersLock);
+    while (!flusherStopping) {
+        auto now = std::chrono::steady_clock::now();
+        auto wakeup = now + std::chrono::seconds(1);
+        std::vector<std::shared_ptr<AccumulatingWeakCounterImpl> > due;
+        for (auto& it : accumulatingCounters) {
+            AccumulatingWeakCounterImpl& counter = *it.second;
+            if (counter.flushInterval.count() == 0) {
+                continue;
+            }
+            if (counter.nextFlush <= now) {
+                due.push_back(it.second);
+                counter.nextFlush = now + counter.flushInterval;
+            }
+            wakeup = std::min(wakeup, counter.nextFlush);
+        }
+        if (!due.empty()) {
+            guard.unlock();
+            for (auto& counter : due) {
+                try {
+                    counter->flush();
+                } catch (const std::exception& e) {
+                    WARN("Unable to flush pending updates for counter %s: %s", counter->getName().c_str(), e.what());
+                }
+            }
+            due.clear();
+            guard.lock();
+            continue;
+        }
+        flusherCond.wait_until(guard, wakeup);
     }
-    return std::static_pointer_cast<WeakCounterImpl>(it->second);
 }
 
 bool RemoteCounterManagerImpl::defineCounter(std::string name, CounterConfiguration configuration) {
@@ -83,10 +198,23 @@ CounterConfiguration RemoteCounterManagerImpl::getConfiguration(std::string name
 void RemoteCounterManagerImpl::remove(std::string name) {
     RemoveCounterOperation op(*codec, transportFactory, topology, 0, name);
     op.execute();
-    auto it = counters.find(name);
-    if (it != counters.end()) {
-        it->second->setRemoved();
-        counters.erase(name);
+    std::shared_ptr<AccumulatingWeakCounterImpl> accumulating;
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        auto it = counters.find(name);
+        if (it != counters.end()) {
+            it->second->setRemoved();
+            counters.erase(it);
+        }
+        auto ait = accumulatingCounters.find(name);
+        if (ait != accumulatingCounters.end()) {
+            accumulating = ait->second;
+            accumulating->setRemoved();
+            accumulatingCounters.erase(ait);
+        }
+    }
+    if (accumulating) {
+        accumulating->close();
     }
 }
 
@@ -95,6 +223,105 @@ std::set<std::string> RemoteCounterManagerImpl::getCounterNames() {
     return op.execute();
 }
 
+std::map<std::string, long> RemoteCounterManagerImpl::getValues(const std::set<std::string>& counterNames) {
+    std::vector<std::shared_ptr<AccumulatingWeakCounterImpl> > toFlush;
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        for (auto& name : counterNames) {
+            auto ait = accumulatingCounters.find(name);
+            if (ait != accumulatingCounters.end()) {
+                toFlush.push_back(ait->second);
+            }
+        }
+    }
+    for (auto& counter : toFlush) {
+        counter->flush();
+    }
+    // The reads are pipelined on the caller thread, the first failure is thrown once all are done
+    std::vector<std::shared_ptr<PipelinedRequest> > requests;
+    std::vector<std::future<long> > values;
+    for (auto& name : counterNames) {
+        auto request = std::make_shared<PipelinedOperation<GetCounterValueOperation, long> >(*codec, transportFactory,
+                topology, 0, name);
+        values.push_back(request->getFuture());
+        requests.push_back(request);
+    }
+    executePipelined(requests);
+    std::map<std::string, long> result;
+    auto value = values.begin();
+    for (auto& name : counterNames) {
+        result[name] = (value++)->get();
+    }
+    return result;
+}
+
+void RemoteCounterManagerImpl::executePipelined(const std::vector<std::shared_ptr<PipelinedRequest> >& requests) {
+    for (size_t begin = 0; begin < requests.size(); begin += Pipeline::MAX_BATCH) {
+        size_t end = std::min(requests.size(), begin + Pipeline::MAX_BATCH);
+        std::vector<PipelinedRequest*> batch;
+        for (size_t i = begin; i < end; i++) {
+            batch.push_back(requests[i].get());
+        }
+        Transport* transport;
+        try {
+            transport = &transportFactory->getTransport(HeaderParams::noCacheName(), std::set<InetSocketAddress>());
+        } catch (const HotRodClientException&) {
+            // No connection to share, each request retries on its own
+            for (auto request : batch) {
+                request->executeAlone();
+            }
+            continue;
+        }
+        Pipeline pipeline(*transportFactory, *codec);
+        pipeline.add(*transport, batch);
+        pipeline.run();
+    }
+}
+
+void RemoteCounterManagerImpl::submit(std::shared_ptr<PipelinedRequest> request) {
+    std::lock_guard<std::mutex> guard(dispatcherLock);
+    if (!started || dispatcherStopping) {
+        throw HotRodClientException("The counter manager is stopped");
+    }
+    if (!dispatcher.joinable()) {
+        dispatcher = std::thread(&RemoteCounterManagerImpl::runDispatcher, this);
+    }
+    submitted.push_back(request);
+    dispatcherCond.notify_all();
+}
+
+void RemoteCounterManagerImpl::stopDispatcher() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> guard(dispatcherLock);
+        dispatcherStopping = true;
+        stopped.swap(dispatcher);
+    }
+    dispatcherCond.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+// Pipelines all the requests queued while the previous ones were in flight, the queue is drained before stopping
+void RemoteCounterManagerImpl::runDispatcher() {
+    std::unique_lock<std::mutex> guard(dispatcherLock);
+    for (;;) {
+        if (submitted.empty()) {
+            if (dispatcherStopping) {
+                return;
+            }
+            dispatcherCond.wait(guard);
+            continue;
+        }
+        std::vector<std::shared_ptr<PipelinedRequest> > requests(submitted.begin(), submitted.end());
+        submitted.clear();
+        guard.unlock();
+        executePipelined(requests);
+        guard.lock();
+    }
+}
+
 static std::vector<char> generateV4UUID()
 {
     std::vector<char> tmp(16);
@@ -8,9 +8,15 @@
 #include "infinispan/hotrod/TransactionManager.h"
 #include "infinispan/hotrod/RemoteCacheBase.h"
 #include "infinispan/hotrod/exceptions.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <thread>
 #include <iostream>
+#include <mutex>
 #include <random>
+#include <future>
 
 
 namespace infinispan {
@@ -122,7 +128,9 @@ void TransactionManager::commit() {
             currentTransaction.status = ROLLEDBACK;
         } else {
             try {
-                if (remotePrepareCommit(currentTransaction) == TransactionRemoteStatus::XA_OK) {
+                if (isOnePhase(currentTransaction)) {
+                    remoteOnePhaseCommit(currentTransaction);
+                } else if (remotePrepareCommit(currentTransaction) == TransactionRemoteStatus::XA_OK) {
                     remoteCommit(currentTransaction);
                 }
                 currentTransaction.status = COMMITTED;
@@ -158,23 +166,144 @@ void TransactionManager::rollback() {
     }
 }
 
+/* A fixed set of threads, shared by all the transactions, running the remote calls of the
+ * caches after the first one. Never destroyed, the threads wait for work until the process exits
+ */
+class FanOutExecutor {
+public:
+    static FanOutExecutor& instance() {
+        static FanOutExecutor* executor = new FanOutExecutor(
+                std::min(std::max(std::thread::hardware_concurrency(), 2u), 8u));
+        return *executor;
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back(std::move(task));
+        }
+        ready.notify_one();
+    }
+
+private:
+    explicit FanOutExecutor(unsigned int size) {
+        for (unsigned int i = 0; i < size; i++) {
+            std::thread(&FanOutExecutor::run, this).detach();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            ready.wait(guard, [this] { return !tasks.empty(); });
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            guard.unlock();
+            task();
+            guard.lock();
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<std::function<void()> > tasks;
+};
+
+/* Starts f on each entry of the map and returns the futures in iteration order. The first
+ * entry runs on the caller thread on get(), the others on the FanOutExecutor meanwhile
+ */
+template<typename M, typename F>
+static std::vector<std::future<TransactionRemoteStatus> > fanOut(M& caches, F f) {
+    std::vector<std::future<TransactionRemoteStatus> > results;
+    for (auto& ctx : caches) {
+        auto* entry = &ctx;
+        if (results.empty()) {
+            results.push_back(std::async(std::launch::deferred, [entry, f] {return f(*entry);}));
+            continue;
+        }
+        auto task = std::make_shared<std::packaged_task<TransactionRemoteStatus()> >([entry, f] {return f(*entry);});
+        results.push_back(task->get_future());
+        FanOutExecutor::instance().submit([task] {(*task)();});
+    }
+    return results;
+}
+
+// A transaction with exactly one cache that has changes can be committed in a single round trip
+bool TransactionManager::isOnePhase(Transaction& t) {
+    size_t participants = 0;
+    for (auto& ctx : t.sa.registeredCache) {
+        if (!ctx.second.isReadOnly()) {
+            participants++;
+        }
+    }
+    return participants == 1;
+}
+
+void TransactionManager::remoteOnePhaseCommit(Transaction& t) {
+    for (auto& ctx : t.sa.registeredCache) {
+        if (ctx.second.isReadOnly()) {
+            continue;
+        }
+        // The server commits or rolls back on its own, nothing is left prepared there
+        TransactionRemoteStatus ret = static_cast<TransactionRemoteStatus>(ctx.first->base_onePhaseCommit(t.xid, ctx.second));
+        switch (ret) {
+        case TransactionRemoteStatus::XA_OK:
+        case TransactionRemoteStatus::XA_RDONLY:
+            break;
+        default:
+            throw HotRodClientTxRemoteStateException((unsigned int)ret);
+        }
+    }
+}
+
 TransactionRemoteStatus TransactionManager::remotePrepareCommit(Transaction& t) {
-    // For each caches listed as resource remotely call a PrepareCommit operation
-    bool readOnly = true;
+    // For each caches listed as resource remotely call a PrepareCommit operation,
+    // caches that have only been read have nothing to prepare
+    std::vector<std::pair<RemoteCacheBase* const, TransactionContext>*> participants;
     for (auto& ctx : t.sa.registeredCache) {
-        TransactionRemoteStatus ret = static_cast<TransactionRemoteStatus>(ctx.first->base_prepareCommit(t.xid, ctx.second));
+        if (!ctx.second.isReadOnly()) {
+            participants.push_back(&ctx);
+        }
+    }
+    XID& xid = t.xid;
+    auto results = fanOut(participants, [&xid](std::pair<RemoteCacheBase* const, TransactionContext>* ctx) {
+        return static_cast<TransactionRemoteStatus>(ctx->first->base_prepareCommit(xid, ctx->second));
+    });
+    // Gather all the outcomes before reacting, every cache that prepared must be known for the rollback
+    bool readOnly = true;
+    TransactionRemoteStatus failure = TransactionRemoteStatus::XA_OK;
+    std::exception_ptr error;
+    size_t i = 0;
+    for (auto ctx : participants) {
+        TransactionRemoteStatus ret;
+        try {
+            ret = results[i++].get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+            continue;
+        }
         switch (ret) {
         case TransactionRemoteStatus::XA_OK:
             readOnly = false;
-            t.sa.preparedCache[ctx.first] = &ctx.second;
+            t.sa.preparedCache[ctx->first] = &ctx->second;
             break;
         case TransactionRemoteStatus::XA_RDONLY:
             break;
         default:
-            t.sa.preparedCache[ctx.first] = &ctx.second;
-            throw HotRodClientTxRemoteStateException((unsigned int)ret);
+            t.sa.preparedCache[ctx->first] = &ctx->second;
+            if (failure == TransactionRemoteStatus::XA_OK) {
+                failure = ret;
+            }
         }
     }
+    if (failure != TransactionRemoteStatus::XA_OK) {
+        throw HotRodClientTxRemoteStateException((unsigned int)failure);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
     return readOnly ? TransactionRemoteStatus::XA_RDONLY : TransactionRemoteStatus::XA_OK;
 }
 
@@ -186,8 +315,21 @@ void TransactionManager::remoteCommit(Transaction& t) {
     bool unknown = false;
     unsigned int unknownErrorCode = 0;
 
-    for (auto& ctx : t.sa.registeredCache) {
-       TransactionRemoteStatus ret = static_cast<TransactionRemoteStatus>(ctx.first->base_commit(t.xid, ctx.second));
+    XID& xid = t.xid;
+    auto results = fanOut(t.sa.preparedCache, [&xid](std::pair<RemoteCacheBase* const, TransactionContext*>& ctx) {
+        return static_cast<TransactionRemoteStatus>(ctx.first->base_commit(xid, *ctx.second));
+    });
+    std::exception_ptr error;
+    for (auto& result : results) {
+       TransactionRemoteStatus ret;
+       try {
+           ret = result.get();
+       } catch (...) {
+           if (!error) {
+               error = std::current_exception();
+           }
+           continue;
+       }
        switch (ret) {
           case TransactionRemoteStatus::XA_OK:       //no issues
           case TransactionRemoteStatus::XA_RDONLY:   //no issues
@@ -213,6 +355,9 @@ void TransactionManager::remoteCommit(Transaction& t) {
              break;
        }
     }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 
     if (!hasCommit && !hasRollback) {
        //nothing committed neither rolled back
@@ -240,8 +385,21 @@ void TransactionManager::remoteRollback(Transaction& t) {
    bool unknown = false;
    int unknownErrorCode = 0;
 
-   for (auto& ctx : t.sa.preparedCache) {
-      TransactionRemoteStatus ret = static_cast<TransactionRemoteStatus>(ctx.first->base_rollback(t.xid, *ctx.second));
+   XID& xid = t.xid;
+   auto results = fanOut(t.sa.preparedCache, [&xid](std::pair<RemoteCacheBase* const, TransactionContext*>& ctx) {
+       return static_cast<TransactionRemoteStatus>(ctx.first->base_rollback(xid, *ctx.second));
+   });
+   std::exception_ptr error;
+   for (auto& result : results) {
+      TransactionRemoteStatus ret;
+      try {
+          ret = result.get();
+      } catch (...) {
+          if (!error) {
+              error = std::current_exception();
+          }
+          continue;
+      }
       switch (ret) {
          case TransactionRemoteStatus::XA_OK:       //no issues
          case TransactionRemoteStatus::XA_RDONLY:   //no issues
@@ -267,6 +425,9 @@ void TransactionManager::remoteRollback(Transaction& t) {
             break;
       }
    }
+   if (error) {
+       std::rethrow_exception(error);
+   }
 
    if (!hasCommit && !hasRollback) {
       //nothing committed neither rolled back
@@ -314,7 +475,7 @@ bool TransactionContext::hasValue(const std::vector<char>& key) {
 }
 
 bool TransactionContext::isDeleted(const std::vector<char>& key) {
-    std::map<const std::vector<char>, ContextEntry>::iterator found = context.find(key);
+    auto found = context.find(key);
     return (found != context.end() && found->second.action == Action::DELETED);
 }
 
@@ -340,11 +501,24 @@ void TransactionContext::setValue(std::vector<char>& key, const void* value, Met
     ce.deleter = deleter;
     ce.valueMarshaller = valueMarshaller;
     ce.value = value;
+    ce.marshalledValue.clear();
+    if (value && valueMarshaller) {
+        valueMarshaller(value, ce.marshalledValue);
+    }
 }
 
 void TransactionContext::addValue(std::vector<char>& key, const void* value, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller, ControlBit cb) {
-    context[key] = ContextEntry(TransactionContext::SET, value, meta, deleter, valueMarshaller);
-    context[key].controlByte |= cb;
+    std::vector<char> marshalledValue;
+    if (value && valueMarshaller) {
+        valueMarshaller(value, marshalledValue);
+    }
+    addValue(key, value, std::move(marshalledValue), meta, deleter, valueMarshaller, cb);
+}
+
+void TransactionContext::addValue(std::vector<char>& key, const void* value, std::vector<char>&& marshalledValue, MetadataValue& meta, std::function<void (const void *)> deleter, std::function<void (const void *, std::vector<char>&)> valueMarshaller, ControlBit cb) {
+    ContextEntry& ce = context[key] = ContextEntry(TransactionContext::SET, value, meta, deleter, valueMarshaller);
+    ce.controlByte |= cb;
+    ce.marshalledValue = std::move(marshalledValue);
 }
 
 void TransactionContext::setValueAsDeleted(std::vector<char>& key) {
@@ -358,6 +532,7 @@ void TransactionContext::setValueAsDeleted(std::vector<char>& key) {
     }
     ce.value = nullptr;
     ce.deleter = nullptr;
+    ce.marshalledValue.clear();
 }
 
 void TransactionContext::getBulk(int size, std::map<std::vector<char>, const void*> &mbuf) {
@@ -387,6 +562,15 @@ void TransactionContext::clear() {
     context.clear();
 }
 
+bool TransactionContext::isReadOnly() {
+    for (auto const & it : context) {
+        if (it.second.changed || (it.second.controlByte & ControlBit::NOT_READ)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int TransactionContext::size() {
     return context.size();
 }
@@ -34,6 +34,30 @@ public:
         return getWithVersion(rcb, key, &version);
     }
 
+    virtual bool getInto(RemoteCacheBase& rcb, const void* key, std::vector<char>& value) {
+        std::vector<char> kbuf;
+        rcb.baseKeyMarshall(key, kbuf);
+        {
+            std::lock_guard<std::mutex> guard(_nearMutex);
+            auto it = _nearMap.find(kbuf);
+            if (it != _nearMap.end()) {
+                ++hits;
+                const std::vector<char>& cached = it->second.getValueRef();
+                value.assign(cached.begin(), cached.end());
+                return true;
+            }
+        }
+        VersionedValueImpl<std::vector<char> > valueForMap = getRawWithVersion(kbuf);
+        const std::vector<char>& bytes = valueForMap.getValueRef();
+        if (!bytes.data()) {
+            value.clear();
+            return false;
+        }
+        value.assign(bytes.begin(), bytes.end());
+        addElementToMap(kbuf, valueForMap);
+        return true;
+    }
+
     virtual void *put(RemoteCacheBase& rcb, const void *key, const void* val,
             uint64_t life, uint64_t idle) {
         std::vector<char> kbuf;
@@ -0,0 +1,86 @@
+#include "hotrod/impl/QueryResultCache.h"
+
+namespace infinispan {
+namespace hotrod {
+
+QueryResultCache::QueryResultCache(std::chrono::milliseconds lifespan, size_t maxEntries) :
+    lifespan(lifespan), maxEntries(maxEntries), currentGeneration(0), hits(0), misses(0) {
+}
+
+bool QueryResultCache::get(const std::string& request, std::vector<char>& bytes) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = entries.find(request);
+        if (it != entries.end()) {
+            if (it->second.expiry > Clock::now()) {
+                bytes = it->second.response;
+                ++hits;
+                return true;
+            }
+            entries.erase(it);
+        }
+    }
+    ++misses;
+    return false;
+}
+
+uint64_t QueryResultCache::generation() const {
+    return currentGeneration;
+}
+
+void QueryResultCache::put(const std::string& request, const std::vector<char>& bytes, uint64_t generation) {
+    if (maxEntries == 0) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> guard(lock);
+    // Cleared while the query ran, the response may be stale
+    if (generation != currentGeneration) {
+        return;
+    }
+    if (entries.find(request) == entries.end()) {
+        makeRoom(now);
+    }
+    Entry& e = entries[request];
+    e.response = bytes;
+    e.expiry = now + lifespan;
+}
+
+// Drops the expired entries, or the one expiring first if none is
+void QueryResultCache::makeRoom(Clock::time_point now) {
+    if (entries.size() < maxEntries) {
+        return;
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.expiry <= now) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (entries.size() < maxEntries) {
+        return;
+    }
+    auto oldest = entries.begin();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second.expiry < oldest->second.expiry) {
+            oldest = it;
+        }
+    }
+    entries.erase(oldest);
+}
+
+void QueryResultCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    ++currentGeneration;
+    entries.clear();
+}
+
+void QueryResultCache::stats(std::map<std::string, std::string>& stats) const {
+    uint64_t h = hits, m = misses;
+    stats["queryCacheHits"] = std::to_string(h);
+    stats["queryCacheMisses"] = std::to_string(m);
+    stats["queryCacheHitRatio"] = std::to_string(h + m == 0 ? 0.0 : (double) h / (h + m));
+}
+
+}} // namespace infinispan::hotrod
@@ -0,0 +1,62 @@
+#ifndef ISPN_HOTROD_QUERYRESULTCACHE_H
+#define ISPN_HOTROD_QUERYRESULTCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace infinispan {
+namespace hotrod {
+
+/**
+ * QueryResultCache keeps the marshalled responses of recent queries, keyed by the marshalled
+ * request. Entries expire after a fixed lifespan, the whole cache can be invalidated at any time.
+ * Each clear starts a new generation, a response fetched before a clear isn't stored after it.
+ * Counts hits and misses for the cache stats.
+ */
+class QueryResultCache
+{
+public:
+    QueryResultCache(std::chrono::milliseconds lifespan, size_t maxEntries);
+
+    /**
+     * Copy the cached response for a request into bytes
+     * \return true on a hit, false if there's no valid entry
+     */
+    bool get(const std::string& request, std::vector<char>& bytes);
+    /**
+     * The generation to pass to put, read before the request is sent
+     */
+    uint64_t generation() const;
+    /**
+     * Store the response to a request, unless the cache was cleared since the generation was read
+     */
+    void put(const std::string& request, const std::vector<char>& bytes, uint64_t generation);
+    void clear();
+    void stats(std::map<std::string, std::string>& stats) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::vector<char> response;
+        Clock::time_point expiry;
+    };
+
+    void makeRoom(Clock::time_point now);
+
+    const std::chrono::milliseconds lifespan;
+    const size_t maxEntries;
+    std::mutex lock;
+    std::map<std::string, Entry> entries;
+    std::atomic<uint64_t> currentGeneration;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+};
+
+}} // namespace infinispan::hotrod
+
+#endif // ISPN_HOTROD_QUERYRESULTCACHE_H
@@ -3,6 +3,7 @@
 #include "hotrod/impl/RemoteCacheManagerImpl.h"
 #include "hotrod/impl/operations/OperationsFactory.h"
 #include "hotrod/impl/operations/GetOperation.h"
+#include "hotrod/impl/operations/GetIntoOperation.h"
 #include "hotrod/impl/operations/GetAllOperation.h"
 #include "hotrod/impl/operations/PutOperation.h"
 #include "hotrod/impl/operations/PingOperation.h"
@@ -14,6 +15,7 @@
 #include "hotrod/impl/operations/RemoveIfUnmodifiedOperation.h"
 #include "hotrod/impl/operations/GetWithMetadataOperation.h"
 #include "hotrod/impl/operations/GetWithVersionOperation.h"
+#include "hotrod/impl/operations/Pipeline.h"
 #include "hotrod/impl/operations/BulkGetOperation.h"
 #include "hotrod/impl/operations/BulkGetKeysOperation.h"
 #include "hotrod/impl/operations/StatsOperation.h"
@@ -29,6 +31,7 @@
 #include <hotrod/impl/operations/AddClientListenerOperation.h>
 #include <hotrod/impl/operations/RemoveClientListenerOperation.h>
 #include <hotrod/impl/operations/TransactionOperations.h>
+#include <algorithm>
 #include <iostream>
 
 namespace infinispan {
@@ -49,39 +52,120 @@ void *RemoteCacheImpl::get(RemoteCacheBase& remoteCacheBase, const void *k) {
     assertRemoteCacheManagerIsStarted();
 	std::vector<char> kbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
 
-    std::unique_ptr<GetOperation> gco(operationsFactory->newGetKeyOperation(keyBytes, dataFormat));
-    std::vector<char> bytes = gco->execute();
+    GetOperation gco = operationsFactory->newGetKeyOperation(kbuf, dataFormat);
+    std::vector<char> bytes = gco.execute();
     return bytes.data() ? remoteCacheBase.baseValueUnmarshall(bytes) : NULL;
 }
 
+bool RemoteCacheImpl::getInto(RemoteCacheBase& remoteCacheBase, const void *k, std::vector<char>& value) {
+    assertRemoteCacheManagerIsStarted();
+    // The key buffer is kept per thread, so it stops allocating once it's big enough
+    static thread_local std::vector<char> kbuf;
+    kbuf.clear();
+    remoteCacheBase.baseKeyMarshall(k, kbuf);
+    GetIntoOperation gco = operationsFactory->newGetIntoOperation(kbuf, value, dataFormat);
+    return gco.execute();
+}
+
+VersionedValueImpl<std::vector<char>> RemoteCacheImpl::getRawWithVersion(const std::vector<char>& keyBytes) {
+    assertRemoteCacheManagerIsStarted();
+    GetWithVersionOperation gco = operationsFactory->newGetWithVersionOperation(keyBytes, dataFormat);
+    return gco.execute();
+}
+
 std::map<std::vector<char>,std::vector<char>> RemoteCacheImpl::getAll(const std::set<std::vector<char>>& keySet) {
     assertRemoteCacheManagerIsStarted();
-    // split key set according to server address
-    std::map<const InetSocketAddress, std::set<std::vector<char> > > splittedKeySet;
-    for ( auto key : keySet)
+    // split key set according to the primary owner, all the keys are routed in one batch
+    std::vector<char> cacheNameBytes(name.begin(), name.end());
+    std::vector<const std::vector<char>*> keys;
+    keys.reserve(keySet.size());
+    for (auto& key : keySet)
     {
-       std::vector<char> cacheNameBytes(name.begin(), name.end());
-       const InetSocketAddress& addr = operationsFactory->getTransportFactory()->getTopologyInfo().getHashAwareServer(key, cacheNameBytes);
-       splittedKeySet[addr].insert(key);
+       keys.push_back(&key);
     }
+    std::vector<std::vector<size_t> > buckets = operationsFactory->getTransportFactory()->getTopologyInfo().routeKeys(
+            keys.data(), keys.size(), cacheNameBytes);
     std::map<std::vector<char>,std::vector<char>> result;
     // Execute separated GetAllOperations and merge the result
-    for (auto item: splittedKeySet)
+    for (auto& bucket : buckets)
     {
-        std::unique_ptr<GetAllOperation> gco(operationsFactory->newGetAllOperation(item.second, dataFormat));
+        if (bucket.empty()) {
+            continue;
+        }
+        std::set<std::vector<char> > splittedKeySet;
+        for (size_t i : bucket) {
+            splittedKeySet.insert(splittedKeySet.end(), *keys[i]);
+        }
+        std::unique_ptr<GetAllOperation> gco(operationsFactory->newGetAllOperation(splittedKeySet, dataFormat));
         std::map<std::vector<char>,std::vector<char>> splittedResult = gco->execute();
         result.insert(splittedResult.begin(), splittedResult.end());
     }
     return result;
 }
 
+std::map<std::vector<char>, MetadataValueImpl<std::vector<char>>> RemoteCacheImpl::getAllWithMetadata(const std::set<std::vector<char>>& keySet) {
+    assertRemoteCacheManagerIsStarted();
+    typedef PipelinedOperation<GetWithMetadataOperation, MetadataValueImpl<std::vector<char>> > PipelinedGet;
+    // There's no bulk read returning versions, the reads are pipelined on a connection to each primary owner
+    std::vector<char> cacheNameBytes(name.begin(), name.end());
+    std::vector<const std::vector<char>*> keys;
+    keys.reserve(keySet.size());
+    for (auto& key : keySet)
+    {
+       keys.push_back(&key);
+    }
+    std::shared_ptr<TransportFactory> transportFactory = operationsFactory->getTransportFactory();
+    std::vector<std::vector<size_t> > buckets = transportFactory->getTopologyInfo().routeKeys(
+            keys.data(), keys.size(), cacheNameBytes);
+    std::vector<std::shared_ptr<PipelinedGet> > requests;
+    std::vector<std::future<MetadataValueImpl<std::vector<char>> > > values;
+    for (auto key : keys)
+    {
+        requests.push_back(std::make_shared<PipelinedGet>(operationsFactory->newGetWithMetadataOperation(*key, dataFormat)));
+        values.push_back(requests.back()->getFuture());
+    }
+    // Each round trip carries up to MAX_BATCH keys of every owner
+    for (size_t begin = 0; begin < keys.size(); begin += Pipeline::MAX_BATCH)
+    {
+        Pipeline pipeline(*transportFactory, operationsFactory->getCodec());
+        for (auto& bucket : buckets)
+        {
+            if (bucket.size() <= begin) {
+                continue;
+            }
+            std::vector<PipelinedRequest*> batch;
+            for (size_t i = begin; i < std::min(bucket.size(), begin + Pipeline::MAX_BATCH); i++) {
+                batch.push_back(requests[bucket[i]].get());
+            }
+            Transport* transport;
+            try {
+                transport = &transportFactory->getTransport(*keys[bucket[begin]], cacheNameBytes,
+                        std::set<InetSocketAddress>());
+            } catch (const HotRodClientException&) {
+                // No connection to this owner, each read retries on its own
+                for (auto request : batch) {
+                    request->executeAlone();
+                }
+                continue;
+            }
+            pipeline.add(*transport, batch);
+        }
+        pipeline.run();
+    }
+    std::map<std::vector<char>, MetadataValueImpl<std::vector<char>>> result;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        result[*keys[i]] = values[i].get();
+    }
+    return result;
+}
+
 std::vector<char> RemoteCacheImpl::putraw(const std::vector<char> &k, const std::vector<char> &v, uint64_t life, uint64_t idle) {
     assertRemoteCacheManagerIsStarted();
     applyDefaultExpirationFlags(life, idle);
-    std::unique_ptr<PutOperation> op(operationsFactory->newPutKeyValueOperation(k, v, life,idle, dataFormat));
-    return op->execute();
+    PutOperation op = operationsFactory->newPutKeyValueOperation(k, v, life,idle, dataFormat);
+    return op.execute();
 }
 
 void *RemoteCacheImpl::put(RemoteCacheBase& remoteCacheBase, const void *k, const void* v, uint64_t life, uint64_t idle) {
@@ -89,11 +173,9 @@ void *RemoteCacheImpl::put(RemoteCacheBase& remoteCacheBase, const void *k, cons
 	std::vector<char> kbuf, vbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
     remoteCacheBase.baseValueMarshall(v, vbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::vector<char> valueBytes(vbuf.data(), vbuf.data()+vbuf.size());
     applyDefaultExpirationFlags(life, idle);
-    std::unique_ptr<PutOperation> op(operationsFactory->newPutKeyValueOperation(keyBytes, valueBytes, life, idle, dataFormat));
-    std::vector<char> bytes = op->execute();
+    PutOperation op = operationsFactory->newPutKeyValueOperation(kbuf, vbuf, life, idle, dataFormat);
+    std::vector<char> bytes = op.execute();
     return bytes.data() ? remoteCacheBase.baseValueUnmarshall(bytes) : NULL;
 }
 
@@ -102,11 +184,9 @@ void *RemoteCacheImpl::putIfAbsent(RemoteCacheBase& remoteCacheBase, const void
     std::vector<char> kbuf, vbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
     remoteCacheBase.baseValueMarshall(v, vbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::vector<char> valueBytes(vbuf.data(), vbuf.data()+vbuf.size());
     applyDefaultExpirationFlags(life, idle);
-    std::unique_ptr<PutIfAbsentOperation> op(operationsFactory->newPutIfAbsentOperation(keyBytes, valueBytes, life, idle, dataFormat));
-    std::vector<char> bytes = op->execute();
+    PutIfAbsentOperation op = operationsFactory->newPutIfAbsentOperation(kbuf, vbuf, life, idle, dataFormat);
+    std::vector<char> bytes = op.execute();
     return bytes.data() ? remoteCacheBase.baseValueUnmarshall(bytes) : NULL;
 }
 
@@ -120,11 +200,9 @@ void *RemoteCacheImpl::replace(RemoteCacheBase& remoteCacheBase, const void *k,
     std::vector<char> kbuf, vbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
     remoteCacheBase.baseValueMarshall(v, vbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::vector<char> valueBytes(vbuf.data(), vbuf.data()+vbuf.size());
     applyDefaultExpirationFlags(life, idle);
-    std::unique_ptr<ReplaceOperation> op(operationsFactory->newReplaceOperation(keyBytes, valueBytes, life, idle, dataFormat));
-    std::vector<char> bytes = op->execute();
+    ReplaceOperation op = operationsFactory->newReplaceOperation(kbuf, vbuf, life, idle, dataFormat);
+    std::vector<char> bytes = op.execute();
     return bytes.data() ? remoteCacheBase.baseValueUnmarshall(bytes) : NULL;
 }
 
@@ -132,10 +210,9 @@ void *RemoteCacheImpl::remove(RemoteCacheBase& remoteCacheBase, const void* k) {
     assertRemoteCacheManagerIsStarted();
     std::vector<char> kbuf, obuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
 
-    std::unique_ptr<RemoveOperation> gco(operationsFactory->newRemoveOperation(keyBytes, dataFormat));
-    std::vector<char> bytes = gco->execute();
+    RemoveOperation gco = operationsFactory->newRemoveOperation(kbuf, dataFormat);
+    std::vector<char> bytes = gco.execute();
     return bytes.data() ? remoteCacheBase.baseValueUnmarshall(bytes) : NULL;
 }
 
@@ -143,10 +220,8 @@ bool RemoteCacheImpl::containsKey(RemoteCacheBase& remoteCacheBase, const void*
     assertRemoteCacheManagerIsStarted();
     std::vector<char> kbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::unique_ptr<ContainsKeyOperation> gco(
-        operationsFactory->newContainsKeyOperation(keyBytes, dataFormat));
-    return gco->execute();
+    ContainsKeyOperation gco = operationsFactory->newContainsKeyOperation(kbuf, dataFormat);
+    return gco.execute();
 }
 
 bool RemoteCacheImpl::replaceWithVersion(RemoteCacheBase& remoteCacheBase,
@@ -156,11 +231,9 @@ bool RemoteCacheImpl::replaceWithVersion(RemoteCacheBase& remoteCacheBase,
     std::vector<char> kbuf, vbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
     remoteCacheBase.baseValueMarshall(v, vbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::vector<char> valueBytes(vbuf.data(), vbuf.data()+vbuf.size());
 
-    std::unique_ptr<ReplaceIfUnmodifiedOperation> op(operationsFactory->newReplaceIfUnmodifiedOperation(keyBytes, valueBytes, life, idle, version, dataFormat));
-    VersionedOperationResponse response = op->execute();
+    ReplaceIfUnmodifiedOperation op = operationsFactory->newReplaceIfUnmodifiedOperation(kbuf, vbuf, life, idle, version, dataFormat);
+    VersionedOperationResponse response = op.execute();
     return response.isUpdated();
 }
 
@@ -168,10 +241,9 @@ bool RemoteCacheImpl::removeWithVersion(RemoteCacheBase& remoteCacheBase, const
     assertRemoteCacheManagerIsStarted();
     std::vector<char> kbuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
 
-    std::unique_ptr<RemoveIfUnmodifiedOperation> gco(operationsFactory->newRemoveIfUnmodifiedOperation(keyBytes, version, dataFormat));
-    VersionedOperationResponse response = gco->execute();
+    RemoveIfUnmodifiedOperation gco = operationsFactory->newRemoveIfUnmodifiedOperation(kbuf, version, dataFormat);
+    VersionedOperationResponse response = gco.execute();
     return response.isUpdated();
 }
 
@@ -180,9 +252,8 @@ void *RemoteCacheImpl::getWithVersion(RemoteCacheBase& remoteCacheBase, const vo
     assertRemoteCacheManagerIsStarted();
     std::vector<char> kbuf, obuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::unique_ptr<GetWithVersionOperation> gco(operationsFactory->newGetWithVersionOperation(keyBytes, dataFormat));
-    VersionedValueImpl<std::vector<char>> m = gco->execute();
+    GetWithVersionOperation gco = operationsFactory->newGetWithVersionOperation(kbuf, dataFormat);
+    VersionedValueImpl<std::vector<char>> m = gco.execute();
     obuf=m.getValue();
     version->version = m.version;
     return obuf.data() ? remoteCacheBase.baseValueUnmarshall(obuf) : NULL;
@@ -193,9 +264,8 @@ void *RemoteCacheImpl::getWithMetadata(RemoteCacheBase& remoteCacheBase, const v
     assertRemoteCacheManagerIsStarted();
     std::vector<char> kbuf, obuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
-    std::unique_ptr<GetWithMetadataOperation> gco(operationsFactory->newGetWithMetadataOperation(keyBytes, dataFormat));
-    MetadataValueImpl<std::vector<char>> m = gco->execute();
+    GetWithMetadataOperation gco = operationsFactory->newGetWithMetadataOperation(kbuf, dataFormat);
+    MetadataValueImpl<std::vector<char>> m = gco.execute();
     obuf=m.getValue();
     metadata->version = m.version;
     metadata->created = m.created;
@@ -233,6 +303,10 @@ void RemoteCacheImpl::stats(std::map<std::string, std::string> &statistics) {
     assertRemoteCacheManagerIsStarted();
     std::unique_ptr<StatsOperation> gco(operationsFactory->newStatsOperation(dataFormat));
     statistics = gco->execute();
+    std::shared_ptr<QueryResultCache> cache = std::atomic_load(&queryCache);
+    if (cache) {
+        cache->stats(statistics);
+    }
 }
 
 void RemoteCacheImpl::clear() {
@@ -264,6 +338,10 @@ void RemoteCacheImpl::withFlags(Flag flags) {
 	operationsFactory->setFlags(flags);
 }
 
+Flag RemoteCacheImpl::takeFlags() {
+	return (Flag) operationsFactory->takeFlags();
+}
+
 void RemoteCacheImpl::applyDefaultExpirationFlags(uint64_t lifespan, uint64_t maxIdle) {
    if (lifespan == 0) {
       operationsFactory->addFlags(DEFAULT_LIFESPAN);
@@ -294,16 +372,57 @@ std::vector<char> RemoteCacheImpl::execute(RemoteCacheBase& remoteCacheBase, con
 
     std::vector<char> kbuf, obuf;
     remoteCacheBase.baseKeyMarshall(k, kbuf);
-    std::vector<char> keyBytes(kbuf.data(), kbuf.data()+kbuf.size());
 
-    std::unique_ptr<ExecuteCmdKeyOperation> op(operationsFactory->newExecuteCmdKeyOperation(keyBytes, cmdNameBytes, args, dataFormat));
+    std::unique_ptr<ExecuteCmdKeyOperation> op(operationsFactory->newExecuteCmdKeyOperation(kbuf, cmdNameBytes, args, dataFormat));
     return op->execute();
 
 }
 
 QueryResponse RemoteCacheImpl::query(const QueryRequest &qr) {
+	std::vector<char> bytes = queryBytes(qr);
+	QueryResponse resp;
+	resp.ParseFromArray(bytes.data(), (int)bytes.size());
+	return resp;
+}
+
+std::vector<char> RemoteCacheImpl::queryBytes(const QueryRequest &qr) {
+	std::shared_ptr<QueryResultCache> cache = std::atomic_load(&queryCache);
+	std::string key;
+	std::vector<char> bytes;
+	uint64_t generation = 0;
+	if (cache) {
+#if GOOGLE_PROTOBUF_VERSION < 3004001
+		key.resize(qr.ByteSize());
+#else
+		key.resize(qr.ByteSizeLong());
+#endif
+		qr.SerializeToArray(&key[0], (int)key.size());
+		generation = cache->generation();
+		if (cache->get(key, bytes)) {
+			return bytes;
+		}
+	}
 	std::unique_ptr<QueryOperation> op(operationsFactory->newQueryOperation(qr, dataFormat));
-	return op->execute();
+	bytes = op->execute();
+	if (cache) {
+		cache->put(key, bytes, generation);
+	}
+	return bytes;
+}
+
+void RemoteCacheImpl::enableQueryCache(std::chrono::milliseconds lifespan, size_t maxEntries) {
+	std::atomic_store(&queryCache, std::make_shared<QueryResultCache>(lifespan, maxEntries));
+}
+
+void RemoteCacheImpl::disableQueryCache() {
+	std::atomic_store(&queryCache, std::shared_ptr<QueryResultCache>());
+}
+
+void RemoteCacheImpl::clearQueryCache() {
+	std::shared_ptr<QueryResultCache> cache = std::atomic_load(&queryCache);
+	if (cache) {
+		cache->clear();
+	}
 }
 
 CacheTopologyInfo RemoteCacheImpl::getCacheTopologyInfo() {
@@ -322,11 +441,19 @@ void RemoteCacheImpl::addClientListener(ClientListener& clientListener, const st
 void RemoteCacheImpl::removeClientListener(ClientListener& clientListener) {
     RemoveClientListenerOperation *rclo = operationsFactory->newRemoveClientListenerOperation(clientListener, remoteCacheManager.getListenerNotifier(), dataFormat);
     std::unique_ptr<RemoveClientListenerOperation> op(rclo);
-    op->execute();
+    // Whatever the server says, e.g. after a failover, the local end of the listener goes away
+    const std::vector<char> listenerId = clientListener.getListenerId();
+    try {
+        op->execute();
+    } catch (...) {
+        remoteCacheManager.getListenerNotifier().releaseClientListener(listenerId);
+        throw;
+    }
+    remoteCacheManager.getListenerNotifier().releaseClientListener(listenerId);
 }
 
-uint32_t RemoteCacheImpl::prepareCommit(XID xid, TransactionContext& tctx) {
-    auto pco =  std::unique_ptr<PrepareCommitOperation>(operationsFactory->newPrepareCommitOperation(xid, tctx, dataFormat));
+uint32_t RemoteCacheImpl::prepareCommit(XID xid, TransactionContext& tctx, bool onePhaseCommit) {
+    auto pco =  std::unique_ptr<PrepareCommitOperation>(operationsFactory->newPrepareCommitOperation(xid, tctx, onePhaseCommit, dataFormat));
     return pco->execute();
 }
 
@@ -5,7 +5,10 @@
 #include "hotrod/impl/MetadataValueImpl.h"
 #include "hotrod/impl/VersionedValueImpl.h"
 #include "hotrod/impl/operations/PingOperation.h"
+#include "hotrod/impl/QueryResultCache.h"
 #include "infinispan/hotrod/Query.h"
+#include <chrono>
+#include <memory>
 
 using namespace org::infinispan::query::remote::client;
 
@@ -23,7 +26,9 @@ class RemoteCacheImpl
 public:
     RemoteCacheImpl(RemoteCacheManagerImpl& rcm, const std::string& name);
     virtual void *get(RemoteCacheBase& rcb, const void* key);
+    virtual bool getInto(RemoteCacheBase& rcb, const void* key, std::vector<char>& value);
     std::map<std::vector<char>,std::vector<char>> getAll(const std::set<std::vector<char>>& keySet);
+    std::map<std::vector<char>, MetadataValueImpl<std::vector<char>>> getAllWithMetadata(const std::set<std::vector<char>>& keySet);
     virtual void *put(RemoteCacheBase& rcb, const void *key, const void* val, uint64_t life, uint64_t idle);
     std::vector<char> putraw(const std::vector<char> &k, const std::vector<char> &v, uint64_t life, uint64_t idle);
     void *putIfAbsent(RemoteCacheBase& rcb, const void *key, const void* val, uint64_t life, uint64_t idle);
@@ -43,27 +48,36 @@ public:
     std::vector<char> execute(std::vector<char> cmdName, const std::map<std::vector<char>,std::vector<char>>& args);
     std::vector<char> execute(RemoteCacheBase& rcb, const void* k, std::vector<char> cmdName, const std::map<std::vector<char>,std::vector<char>>& args);
     QueryResponse query(const QueryRequest & qr);
+    std::vector<char> queryBytes(const QueryRequest & qr);
+    void enableQueryCache(std::chrono::milliseconds lifespan, size_t maxEntries);
+    void disableQueryCache();
+    void clearQueryCache();
     operations::PingResult ping();
     CacheTopologyInfo getCacheTopologyInfo();
     void addClientListener(ClientListener&, const std::vector<std::vector<char> >, const std::vector<std::vector<char> >, const std::function<void()> &);
     void removeClientListener(ClientListener&);
-    uint32_t prepareCommit(XID xid, TransactionContext& tctx);
+    uint32_t prepareCommit(XID xid, TransactionContext& tctx, bool onePhaseCommit);
     uint32_t commit(XID xid, TransactionContext& tctx);
     uint32_t rollback(XID xid, TransactionContext& tctx);
     virtual void init(operations::OperationsFactory* operationsFactory);
     virtual void stop() {}
 
     void withFlags(Flag flag);
+    Flag takeFlags();
 
     const char *getName() const;
     const std::string& getNameAsString() const;
     void setDataFormat(EntryMediaTypes* df) { dataFormat = df; }
+protected:
+    VersionedValueImpl<std::vector<char>> getRawWithVersion(const std::vector<char>& keyBytes);
 private:
     RemoteCacheImpl(const RemoteCacheImpl& other);
     RemoteCacheManagerImpl& remoteCacheManager;
     std::shared_ptr<operations::OperationsFactory> operationsFactory;
     std::string name;
     EntryMediaTypes* dataFormat;
+    // Accessed with the atomic shared_ptr functions, null when the query cache is disabled
+    std::shared_ptr<QueryResultCache> queryCache;
 
     void applyDefaultExpirationFlags(uint64_t lifespan, uint64_t maxIdle);
     void assertRemoteCacheManagerIsStarted();
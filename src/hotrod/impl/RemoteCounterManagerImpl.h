@@ -8,10 +8,15 @@
 #include "hotrod/impl/transport/TransportFactory.h"
 #include "hotrod/impl/protocol/Codec.h"
 #include "hotrod/impl/Topology.h"
+#include "hotrod/impl/operations/Pipeline.h"
 #include "infinispan/hotrod/RemoteCounterManager.h"
 #include <memory>
 #include <string>
 #include <map>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 #ifndef SRC_HOTROD_IMPL_REMOTECOUNTERMANAGERIMPL_H_
 #define SRC_HOTROD_IMPL_REMOTECOUNTERMANAGERIMPL_H_
@@ -22,14 +27,17 @@ namespace hotrod {
 class BaseCounterImpl;
 class StrongCounterImpl;
 class WeakCounterImpl;
+class AccumulatingWeakCounterImpl;
 
 class RemoteCounterManagerImpl: public RemoteCounterManager {
 public:
     RemoteCounterManagerImpl(std::shared_ptr<ClientListenerNotifier>& listenerNotifier) :
-            transportFactory(), codec(nullptr), started(false), listenerNotifier(listenerNotifier), eventTransport(
-                    nullptr) {
+            transportFactory(), codec(nullptr), started(false), listenerNotifier(listenerNotifier), flusherStopping(
+                    false), dispatcherStopping(false), eventTransport(nullptr) {
     }
     ~RemoteCounterManagerImpl() {
+        stopDispatcher();
+        stopFlusher();
     }
 
     void start(std::shared_ptr<transport::TransportFactory> t, protocol::Codec* c);
@@ -37,27 +45,56 @@ public:
 
     std::shared_ptr<StrongCounter> getStrongCounter(std::string name);
     std::shared_ptr<WeakCounter> getWeakCounter(std::string name);
+    std::shared_ptr<WeakCounter> getAccumulatingWeakCounter(std::string name, uint32_t flushIntervalMillis,
+            uint32_t flushThreshold);
     bool defineCounter(std::string name, CounterConfiguration configuration);
     bool isDefined(std::string name);
     CounterConfiguration getConfiguration(std::string name);
     void remove(std::string name);
     std::set<std::string> getCounterNames();
+    std::map<std::string, long> getValues(const std::set<std::string>& counterNames);
     const void* addListener(const std::string counterName, const event::CounterListener* listener);
     void removeListener(const std::string counterName, const void* handler);
 
+    // Runs the requests on the caller thread, pipelined on a counter connection
+    void executePipelined(const std::vector<std::shared_ptr<operations::PipelinedRequest> >& requests);
+
+    // Queues a request of an asynchronous operation, see runDispatcher()
+    void submit(std::shared_ptr<operations::PipelinedRequest> request);
+
 private:
+    CounterConfiguration fetchConfiguration(const std::string& name, bool weak);
+    void stopFlusher();
+    void runFlusher();
+    void stopDispatcher();
+    void runDispatcher();
+
     std::shared_ptr<transport::TransportFactory> transportFactory;
     protocol::Codec* codec;
     bool started;
     std::shared_ptr<ClientListenerNotifier>& listenerNotifier;
     Topology topology;
+    // Counter handles by name, guarded by countersLock. Entries live until remove()
     std::map<std::string, std::shared_ptr<BaseCounterImpl>> counters;
+    std::map<std::string, std::shared_ptr<AccumulatingWeakCounterImpl>> accumulatingCounters;
+    std::mutex countersLock;
+    // A single thread flushes all the accumulating counters with a timer, started by the first of them
+    std::condition_variable flusherCond;
+    bool flusherStopping;
+    std::thread flusher;
+    // A single thread pipelines the queued asynchronous operations, started by the first of them
+    std::deque<std::shared_ptr<operations::PipelinedRequest> > submitted;
+    std::mutex dispatcherLock;
+    std::condition_variable dispatcherCond;
+    bool dispatcherStopping;
+    std::thread dispatcher;
     std::shared_ptr<CounterDispatcher> counterDispatcher;
     Transport* eventTransport;
     std::vector<char> listenerId;
     friend BaseCounterImpl;
     friend StrongCounterImpl;
     friend WeakCounterImpl;
+    friend AccumulatingWeakCounterImpl;
 };
 }
 }
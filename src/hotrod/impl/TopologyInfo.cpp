@@ -13,52 +13,110 @@ TopologyInfo::~TopologyInfo() {
 	// TODO Auto-generated destructor stub
 }
 
+std::shared_ptr<const TopologyInfo::CacheTopology> TopologyInfo::newCacheTopology(
+        std::shared_ptr<consistenthash::ConsistentHash> hash, uint32_t numSegments, int topologyId) const {
+	std::shared_ptr<CacheTopology> t(new CacheTopology());
+	t->hash = hash;
+	t->numSegments = numSegments;
+	t->topologyId = topologyId;
+	if (hash) {
+		t->segmentsByServer = hash->getSegmentsByServers();
+	} else {
+		// Without a hash every server owns every segment
+		std::vector<int> v(numSegments);
+		std::iota(v.begin(), v.end(), 0);
+		for (auto it = servers.begin(); it < servers.end(); it++) {
+			t->segmentsByServer[*it] = v;
+		}
+	}
+	return t;
+}
+
 void TopologyInfo::updateTopology(std::vector<std::vector<transport::InetSocketAddress>>& segmentOwners,
-        uint32_t &numSegment, uint8_t &hashFunctionVersion, std::vector<char> cacheName, int topologyId) {
-	std::unique_lock<std::mutex> ulh(mutexHash, std::defer_lock);
-	std::unique_lock<std::mutex> uls(mutexSeg, std::defer_lock);
-	std::lock(ulh, uls);
+        uint32_t &numSegment, uint8_t &/*hashFunctionVersion*/, std::vector<char> cacheName, int topologyId) {
 	std::shared_ptr<consistenthash::ConsistentHash> hash(new infinispan::hotrod::consistenthash::SegmentConsistentHash());
 	hash->init(segmentOwners, numSegment);
-	createTopologyId(cacheName, topologyId);
-	segmentsByCache[cacheName]=numSegment;
-	topologyIdsByCache[cacheName]=topologyId;
-	consistentHashByCacheName[cacheName]=hash;
+	std::shared_ptr<const CacheTopology> t = newCacheTopology(hash, numSegment, topologyId);
+	std::lock_guard<std::mutex> lg(mutexWrite);
+	std::shared_ptr<Snapshot> s(new Snapshot(*loadSnapshot()));
+	(*s)[cacheName] = t;
+	std::atomic_store(&snapshot, std::shared_ptr<const Snapshot>(s));
+}
+
+int TopologyInfo::createTopologyId(std::vector<char> cacheName, int id) {
+	std::lock_guard<std::mutex> lg(mutexWrite);
+	std::shared_ptr<const Snapshot> current = loadSnapshot();
+	if (current->find(cacheName) == current->end()) {
+		std::shared_ptr<Snapshot> s(new Snapshot(*current));
+		(*s)[cacheName] = newCacheTopology(std::shared_ptr<consistenthash::ConsistentHash>(), 0, id);
+		std::atomic_store(&snapshot, std::shared_ptr<const Snapshot>(s));
 	}
+	return id;
+}
 
-CacheTopologyInfo TopologyInfo::getCacheTopologyInfo(const std::vector<char>& cacheName) {
-	std::unique_lock<std::mutex> ul(mutexHash);
-	if (consistentHashByCacheName.find(cacheName)
-			!= consistentHashByCacheName.end()) {
-		return CacheTopologyInfo(
-				consistentHashByCacheName[cacheName]->getSegmentsByServers(),
-				segmentsByCache[cacheName], topologyIdsByCache[cacheName]);
-	} else {
-		std::map<transport::InetSocketAddress, std::vector<int> > segmentPerServers_;
-		for (auto it = servers.begin(); it < servers.end(); it++) {
-			std::vector<int> v(segmentsByCache[cacheName]);
-			std::iota(v.begin(), v.end(), 0);
-			segmentPerServers_[*it] = v;
+void TopologyInfo::updateServers(std::vector<transport::InetSocketAddress>& servers_) {
+	std::lock_guard<std::mutex> lg(mutexWrite);
+	servers = servers_;
+	// Only the topologies without a hash depend on the server list
+	std::shared_ptr<Snapshot> s(new Snapshot(*loadSnapshot()));
+	for (auto& entry : *s) {
+		if (!entry.second->hash) {
+			entry.second = newCacheTopology(entry.second->hash, entry.second->numSegments, entry.second->topologyId);
 		}
-		return CacheTopologyInfo(segmentPerServers_, segmentsByCache[cacheName],
-				topologyIdsByCache[cacheName]);
 	}
+	std::atomic_store(&snapshot, std::shared_ptr<const Snapshot>(s));
+}
+
+std::shared_ptr<const TopologyInfo::CacheTopology> TopologyInfo::getCacheTopology(const std::vector<char>& cacheName) const {
+	std::shared_ptr<const Snapshot> s = loadSnapshot();
+	Snapshot::const_iterator it = s->find(cacheName);
+	return it != s->end() ? it->second : std::shared_ptr<const CacheTopology>();
 }
 
+int TopologyInfo::getTopologyId(const std::vector<char>& cacheName) const {
+	std::shared_ptr<const CacheTopology> t = getCacheTopology(cacheName);
+	return t ? t->topologyId : 0;
+}
+
+CacheTopologyInfo TopologyInfo::getCacheTopologyInfo(const std::vector<char>& cacheName) {
+	std::shared_ptr<const CacheTopology> t = getCacheTopology(cacheName);
+	if (t) {
+		return CacheTopologyInfo(t->segmentsByServer, t->numSegments, t->topologyId);
+	}
+	std::shared_ptr<const CacheTopology> unknown = newCacheTopology(std::shared_ptr<consistenthash::ConsistentHash>(), 0, 0);
+	return CacheTopologyInfo(unknown->segmentsByServer, 0, 0);
+}
 
 transport::InetSocketAddress TopologyInfo::getHashAwareServer(
 		const std::vector<char> &key, const std::vector<char> &cacheName) {
-	std::unique_lock<std::mutex> ulh(mutexHash);
-	std::map<std::vector<char>,
-			std::shared_ptr<infinispan::hotrod::consistenthash::ConsistentHash> >::iterator element =
-			consistentHashByCacheName.find(cacheName);
-	if (element != consistentHashByCacheName.end()) {
-		if (!element->second) {
-			return element->second->getServer(key);
-		}
+	std::shared_ptr<const CacheTopology> t = getCacheTopology(cacheName);
+	if (t && t->hash) {
+		return t->hash->getServer(key);
 	}
 	return transport::InetSocketAddress();
 }
 
+std::shared_ptr<consistenthash::ConsistentHash> TopologyInfo::getConsistentHash(const std::vector<char>& cacheName) {
+	std::shared_ptr<const CacheTopology> t = getCacheTopology(cacheName);
+	return t ? t->hash : std::shared_ptr<consistenthash::ConsistentHash>();
+}
+
+std::vector<std::vector<size_t> > TopologyInfo::routeKeys(const std::vector<char>* const* keys, size_t count,
+        const std::vector<char>& cacheName) {
+	std::shared_ptr<consistenthash::ConsistentHash> hash = getConsistentHash(cacheName);
+	if (!hash) {
+		std::vector<std::vector<size_t> > buckets(1, std::vector<size_t>(count));
+		std::iota(buckets[0].begin(), buckets[0].end(), 0);
+		return buckets;
+	}
+	std::vector<std::vector<size_t> > buckets(hash->getServerList().size() + 1);
+	std::vector<int32_t> indexes(count);
+	hash->getServerIndexes(keys, count, indexes.data());
+	for (size_t i = 0; i < count; i++) {
+		buckets[indexes[i] >= 0 ? indexes[i] : buckets.size() - 1].push_back(i);
+	}
+	return buckets;
+}
+
 } /* namespace hotrod */
 } /* namespace infinispan */
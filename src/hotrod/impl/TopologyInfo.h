@@ -8,47 +8,86 @@
 #include "infinispan/hotrod/Configuration.h"
 #include "hotrod/sys/Log.h"
 #include <memory>
+#include <map>
 #include <vector>
 #include <mutex>
 namespace infinispan {
 namespace hotrod {
 
+/**
+ * TopologyInfo publishes the topology as immutable snapshots. Writers copy the current snapshot,
+ * change the copy and swap it in atomically, readers load the current snapshot and never block
+ * writers or each other. Everything derived from a topology, like the segments per server, is
+ * computed once when the topology is published.
+ */
 class TopologyInfo {
 public:
+	/**
+	 * The topology of a cache, never modified after it's published
+	 */
+	struct CacheTopology {
+		std::shared_ptr<consistenthash::ConsistentHash> hash;
+		uint32_t numSegments;
+		int topologyId;
+		std::map<transport::InetSocketAddress, std::vector<int> > segmentsByServer;
+	};
+	typedef std::map<std::vector<char>, std::shared_ptr<const CacheTopology> > Snapshot;
+
 	TopologyInfo(std::vector<transport::InetSocketAddress>& servers_, const Configuration& c_):
 		servers(servers_), configuration(c_) {
+		// servers_ may not be constructed yet, the server list is published by updateServers()
+		std::shared_ptr<CacheTopology> t(new CacheTopology());
+		t->numSegments = 0;
+		t->topologyId = -1;
+		std::shared_ptr<Snapshot> s(new Snapshot());
 		const std::vector<char> emptyCacheName;
-		topologyIdsByCache.insert(std::pair<std::vector<char>,int > (emptyCacheName, -1));
+		(*s)[emptyCacheName] = t;
+		snapshot = s;
 	};
 	virtual ~TopologyInfo();
 	CacheTopologyInfo getCacheTopologyInfo(const std::vector<char> &cacheName);
 	void updateTopology(std::vector<std::vector<transport::InetSocketAddress>>& segmentOwners,
 	        uint32_t &numSegment, uint8_t &hashFunctionVersion, std::vector<char> cacheName, int topologyId);
 	transport::InetSocketAddress getHashAwareServer(const std::vector<char>& key, const std::vector<char>& cacheName);
+	std::shared_ptr<consistenthash::ConsistentHash> getConsistentHash(const std::vector<char>& cacheName);
+
+	/**
+	 * Groups a batch of keys by primary owner, under a single read of the topology snapshot.
+	 * \return one bucket of key positions per server of the consistent hash, in server index order,
+	 * plus a last bucket for the keys without owner. All the keys are in the last bucket if the
+	 * cache has no consistent hash
+	 */
+	std::vector<std::vector<size_t> > routeKeys(const std::vector<char>* const* keys, size_t count,
+	        const std::vector<char>& cacheName);
+
+	/**
+	 * \return the published topology of a cache, nullptr if the cache is unknown
+	 */
+	std::shared_ptr<const CacheTopology> getCacheTopology(const std::vector<char>& cacheName) const;
+
+	/**
+	 * \return the topology id of a cache, 0 if the cache is unknown
+	 */
+	int getTopologyId(const std::vector<char>& cacheName) const;
+
 	std::vector<transport::InetSocketAddress>& getServers() const {
 		return servers;
 	}
 
-	void updateServers(std::vector<transport::InetSocketAddress>& servers_){
-		servers=servers_;
-	}
+	void updateServers(std::vector<transport::InetSocketAddress>& servers_);
 
-	int createTopologyId(std::vector<char> cacheName, int id)
-	{
-		 topologyIdsByCache.insert(std::pair<std::vector<char>, int> (cacheName, id));
-		 return id;
-	}
-	int getSegmentsByCacheName(std::vector<char> cacheName);
+	int createTopologyId(std::vector<char> cacheName, int id);
 
 private:
 	Topology topology;
-    std::map<std::vector<char>, std::shared_ptr<infinispan::hotrod::consistenthash::ConsistentHash> > consistentHashByCacheName;
-    std::map<std::vector<char>, uint32_t > segmentsByCache;
-    std::map<std::vector<char>, int > topologyIdsByCache;
-    std::mutex mutexHash, mutexSeg;
+	std::shared_ptr<const Snapshot> snapshot;
+	std::mutex mutexWrite;
     std::vector<transport::InetSocketAddress>& servers;
     const Configuration& configuration;
 
+    std::shared_ptr<const Snapshot> loadSnapshot() const { return std::atomic_load(&snapshot); }
+    std::shared_ptr<const CacheTopology> newCacheTopology(std::shared_ptr<consistenthash::ConsistentHash> hash,
+            uint32_t numSegments, int topologyId) const;
     void traceEverythingOnTopology();
 };
 
@@ -21,6 +21,10 @@ template<class V> class VersionedValueImpl : public VersionedValue
     	return value;
     }
 
+    const V& getValueRef() const {
+        return value;
+    }
+
     void setValue(const V& _value) {
     	value = _value;
     }
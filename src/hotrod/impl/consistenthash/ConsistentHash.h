@@ -21,6 +21,34 @@ public:
 	virtual void init(std::vector<std::vector<transport::InetSocketAddress>> _segmentOwners, uint32_t _numSegments) = 0;
     virtual const infinispan::hotrod::transport::InetSocketAddress& getServer(const std::vector<char>& key) = 0;
 
+    /**
+     * Routes a key to the index of its primary owner in getServerList().
+     * @param key the marshalled key
+     * @return the server index, -1 if the key has no owner
+     */
+    virtual int32_t getServerIndex(const std::vector<char>& key) = 0;
+
+    /**
+     * Routes a batch of keys, the same as calling getServerIndex() for each of them.
+     * @param keys the marshalled keys
+     * @param count the number of keys
+     * @param serverIndexes set to the server index of every key, -1 if the key has no owner
+     */
+    virtual void getServerIndexes(const std::vector<char>* const* keys, size_t count, int32_t* serverIndexes) = 0;
+
+    /**
+     * Routes a key to all its owners.
+     * @param key the marshalled key
+     * @param owners set to the server indexes of the owners, primary first
+     * @return the number of owners
+     */
+    virtual uint32_t getOwnerIndexes(const std::vector<char>& key, const uint16_t*& owners) = 0;
+
+    /**
+     * @return the distinct servers of the topology, in server index order
+     */
+    virtual const std::vector<infinispan::hotrod::transport::InetSocketAddress>& getServerList() const = 0;
+
     /**
      * Computes hash code of a given int32_t and then normalizes it to ensure a positive
      * value is always returned.
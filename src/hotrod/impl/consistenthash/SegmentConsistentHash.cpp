@@ -6,27 +6,65 @@
  */
 
 #include <hotrod/impl/consistenthash/SegmentConsistentHash.h>
+#include <algorithm>
 
 namespace infinispan {
 namespace hotrod {
 namespace consistenthash {
 
+void SegmentConsistentHash::init(std::vector<std::vector<transport::InetSocketAddress>> _segmentOwners, uint32_t _numSegments) {
+   // The hash space is split by the number of segments of the topology, the segments
+   // missing from _segmentOwners have no owner
+   numSegments = _numSegments;
+   segmentSize = numSegments > 0 ? getSegmentSize(numSegments) : 0;
+   const uint32_t ownedSegments = (uint32_t) std::min<size_t>(_numSegments, _segmentOwners.size());
+   servers.clear();
+   owners.clear();
+   ownerOffsets.assign(1, 0);
+   ownerOffsets.reserve(numSegments + 1);
+   std::map<transport::InetSocketAddress, uint16_t> indexes;
+   for (uint32_t i = 0; i < numSegments; i++) {
+      if (i >= ownedSegments) {
+         ownerOffsets.push_back((uint32_t) owners.size());
+         continue;
+      }
+      for (const transport::InetSocketAddress& addr : _segmentOwners[i]) {
+         std::map<transport::InetSocketAddress, uint16_t>::iterator it = indexes.find(addr);
+         if (it == indexes.end()) {
+            it = indexes.insert(std::make_pair(addr, (uint16_t) servers.size())).first;
+            servers.push_back(addr);
+         }
+         owners.push_back(it->second);
+      }
+      ownerOffsets.push_back((uint32_t) owners.size());
+   }
+}
+
 const infinispan::hotrod::transport::InetSocketAddress& SegmentConsistentHash::getServer(const std::vector<char>& key) {
-   int segmentId = getSegment(key);
-   return segmentOwners[segmentId][0];
+   static const transport::InetSocketAddress noServer;
+   int32_t index = getServerIndex(key);
+   return index >= 0 ? servers[index] : noServer;
 }
+
 uint32_t SegmentConsistentHash::getSegment(const std::vector<char>& key)
 {
    return getNormalizedHash(key)/segmentSize;
 }
 
+void SegmentConsistentHash::getServerIndexes(const std::vector<char>* const* keys, size_t count, int32_t* serverIndexes)
+{
+   for (size_t i = 0; i < count; i++) {
+      serverIndexes[i] = getServerIndex(*keys[i]);
+   }
+}
+
 std::map<transport::InetSocketAddress, std::vector<int> > SegmentConsistentHash::getSegmentsByServers() {
 	std::map<transport::InetSocketAddress, std::vector<int> > m;
-	for (unsigned int i = 0; i< segmentOwners.size(); i++)
+	for (unsigned int i = 0; i < numSegments; i++)
 	{
-		for (unsigned int j = 0; j< segmentOwners[i].size(); j++)
+		for (uint32_t j = ownerOffsets[i]; j < ownerOffsets[i + 1]; j++)
 		{
-			m[segmentOwners[i][j]].push_back(i);
+			m[servers[owners[j]]].push_back(i);
 		}
 	}
 	return m;
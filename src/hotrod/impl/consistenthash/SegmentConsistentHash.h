@@ -19,21 +19,39 @@ namespace infinispan {
 namespace hotrod {
 namespace consistenthash {
 
+/**
+ * The topology is compiled into flat tables: every distinct owner gets a small server index and
+ * the owners of segment s are owners[ownerOffsets[s]..ownerOffsets[s+1]), primary first. Routing a
+ * key is a hash, a division and an array load, no address is compared or copied.
+ */
 class SegmentConsistentHash: public ConsistentHash {
 public:
-	SegmentConsistentHash() : segmentOwners(), numSegments(0), segmentSize(0) {};
+	SegmentConsistentHash() : numSegments(0), segmentSize(0) {};
 	virtual ~SegmentConsistentHash() {};
-	void init(std::vector<std::vector<transport::InetSocketAddress>> _segmentOwners, uint32_t _numSegments) {
-	      segmentOwners = _segmentOwners;
-	      numSegments = _numSegments;
-	      segmentSize = getSegmentSize(_numSegments);
-	   }
+	void init(std::vector<std::vector<transport::InetSocketAddress>> _segmentOwners, uint32_t _numSegments);
 
     void init(std::map<transport::InetSocketAddress, std::set<int32_t> > & /*servers2Hash*/,
 				int32_t /*numKeyOwners*/, int32_t /*hashSpace*/) { throw UnsupportedOperationException(); }
 
     const infinispan::hotrod::transport::InetSocketAddress& getServer(const std::vector<char>& key);
 
+    int32_t getServerIndex(const std::vector<char>& key) {
+        return numSegments > 0 ? getPrimaryOwnerIndex(getSegment(key)) : -1;
+    }
+
+    void getServerIndexes(const std::vector<char>* const* keys, size_t count, int32_t* serverIndexes);
+
+    uint32_t getOwnerIndexes(const std::vector<char>& key, const uint16_t*& ownerIndexes) {
+        if (numSegments == 0) {
+            return 0;
+        }
+        uint32_t segment = getSegment(key);
+        ownerIndexes = owners.data() + ownerOffsets[segment];
+        return ownerOffsets[segment + 1] - ownerOffsets[segment];
+    }
+
+    const std::vector<transport::InetSocketAddress>& getServerList() const { return servers; }
+
     int32_t getNormalizedHash(int32_t objectId) { return hash(objectId) & 0x7fffffff; }
 
     int32_t getNormalizedHash(const std::vector<char>& key) { return hash(key.data(),key.size()) & 0x7fffffff; }
@@ -53,9 +71,15 @@ private:
 
     uint32_t getSegment(const std::vector<char>& key);
 
+    int32_t getPrimaryOwnerIndex(uint32_t segment) const {
+        return ownerOffsets[segment] < ownerOffsets[segment + 1] ? owners[ownerOffsets[segment]] : -1;
+    }
+
     virtual std::map<transport::InetSocketAddress, std::vector<int> > getSegmentsByServers();
 
-    std::vector<std::vector<transport::InetSocketAddress>> segmentOwners;
+    std::vector<transport::InetSocketAddress> servers;
+    std::vector<uint16_t> owners;
+    std::vector<uint32_t> ownerOffsets;
 
     uint32_t numSegments;
     uint32_t segmentSize;
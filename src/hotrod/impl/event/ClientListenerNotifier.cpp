@@ -38,64 +38,109 @@ ClientListenerNotifier* ClientListenerNotifier::create(std::shared_ptr<Transport
 void ClientListenerNotifier::addClientListener(const std::vector<char> listenerId, const ClientListener& clientListener, const std::vector<char> cacheName, Transport& t, const Codec20& codec20, std::shared_ptr<void> operationPtr, const std::function<void()> &recoveryCallback)
 {
 	auto ed = std::shared_ptr<EventDispatcher>(new EventDispatcher(listenerId, clientListener, cacheName, t, codec20, operationPtr, recoveryCallback));
+	std::lock_guard<std::mutex> guard(lock);
 	eventDispatchers.insert(std::make_pair(listenerId, ed));
 }
 
 std::shared_ptr<CounterDispatcher> ClientListenerNotifier::addCounterListener(const std::vector<char> listenerId, const std::vector<char> cacheName,  Transport& t, const Codec20& codec20, const std::function<void()> &recoveryCallback) {
     auto ed = std::shared_ptr<CounterDispatcher>(new CounterDispatcher(listenerId, cacheName, t, codec20, recoveryCallback));
-    eventDispatchers.insert(std::make_pair(listenerId, ed));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        eventDispatchers.insert(std::make_pair(listenerId, ed));
+    }
     ed->start();
     return ed;
 }
 void ClientListenerNotifier::failoverClientListeners(const std::vector<transport::InetSocketAddress>& failedServers)
 {
-	for (auto server: failedServers)
+	std::vector<std::shared_ptr<GenericDispatcher> > failed;
 	{
-		for (auto &edPair : eventDispatchers)
+		std::lock_guard<std::mutex> guard(lock);
+		for (auto server: failedServers)
 		{
-			if (edPair.second->getTransport().targets(server))
+			for (auto &edPair : eventDispatchers)
 			{
-			    edPair.second->failOver();
+				if (edPair.second->getTransport().targets(server))
+				{
+					failed.push_back(edPair.second);
+				}
 			}
 		}
 	}
+	// Failing over adds the listeners again
+	for (auto &ed : failed)
+	{
+		ed->failOver();
+	}
 }
 
 void ClientListenerNotifier::stop()
 {
-	for(auto& kv : eventDispatchers)
+	std::vector<std::shared_ptr<GenericDispatcher> > dispatchers;
 	{
-		kv.second->stop();
+		std::lock_guard<std::mutex> guard(lock);
+		for(auto& kv : eventDispatchers)
+		{
+			dispatchers.push_back(kv.second);
+		}
+	}
+	for (auto& ed : dispatchers)
+	{
+		ed->stop();
 	}
 }
 
 void ClientListenerNotifier::releaseTransport(const std::vector<char> listenerId) {
-    eventDispatchers.find(listenerId)->second->getTransport().release();
-    eventDispatchers.find(listenerId)->second->waitThreadExit();
-    transportFactory->releaseTransport(eventDispatchers.find(listenerId)->second->getTransport());
+    std::shared_ptr<GenericDispatcher> ed = findDispatcher(listenerId);
+    if (!ed) {
+        return;
+    }
+    ed->getTransport().release();
+    ed->waitThreadExit();
+    transportFactory->releaseTransport(ed->getTransport());
 }
 
+void ClientListenerNotifier::releaseClientListener(const std::vector<char> listenerId) {
+    releaseTransport(listenerId);
+    removeClientListener(listenerId);
+}
 
 void ClientListenerNotifier::removeClientListener(const std::vector<char> listenerId)
 {
-	eventDispatchers.erase(listenerId);
+	std::shared_ptr<GenericDispatcher> ed;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = eventDispatchers.find(listenerId);
+		if (it == eventDispatchers.end())
+			return;
+		ed = it->second;
+		eventDispatchers.erase(it);
+	}
+	// The last reference can join the dispatcher thread, not while holding the lock
 }
 
 void ClientListenerNotifier::startClientListener(const std::vector<char> listenerId)
 {
-      auto it = eventDispatchers.find(listenerId);
-      if (it != eventDispatchers.end())
-          it->second->start();
+      std::shared_ptr<GenericDispatcher> ed = findDispatcher(listenerId);
+      if (ed)
+          ed->start();
 }
 
 const Transport& ClientListenerNotifier::findClientListenerTransport(const std::vector<char> listenerId)
 {
-    auto it = eventDispatchers.find(listenerId);
-    if (it!=eventDispatchers.end())
-        return it->second->getTransport();
+    std::shared_ptr<GenericDispatcher> ed = findDispatcher(listenerId);
+    if (ed)
+        return ed->getTransport();
     throw HotRodClientException("Internal: client listener not found");
 }
 
+std::shared_ptr<GenericDispatcher> ClientListenerNotifier::findDispatcher(const std::vector<char>& listenerId)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = eventDispatchers.find(listenerId);
+    return it != eventDispatchers.end() ? it->second : std::shared_ptr<GenericDispatcher>();
+}
+
 
 
 } /* namespace event */
@@ -13,6 +13,7 @@
 #include "infinispan/hotrod/EventMarshaller.h"
 #include "hotrod/impl/event/EventDispatcher.h"
 #include <map>
+#include <mutex>
 
 using namespace infinispan::hotrod::protocol;
 using namespace infinispan::hotrod::transport;
@@ -32,10 +33,18 @@ public:
 	static ClientListenerNotifier* create(std::shared_ptr<TransportFactory> factory);
 	void failoverClientListeners(const std::vector<transport::InetSocketAddress>& failedServers);
 	void releaseTransport(const std::vector<char> listenerId);
+	/*
+	 * Closes the connection of a listener, waits for its dispatcher to exit and forgets it.
+	 * Does nothing if the listener is unknown. Must not be called by the dispatcher of the listener
+	 */
+	void releaseClientListener(const std::vector<char> listenerId);
 	void stop();
 protected:
 	ClientListenerNotifier(std::shared_ptr<TransportFactory> factory);
 private:
+	std::shared_ptr<GenericDispatcher> findDispatcher(const std::vector<char>& listenerId);
+	// Guards eventDispatchers only, dispatchers are started, stopped and joined outside of it
+	std::mutex lock;
 	std::map<std::vector<char>, std::shared_ptr<GenericDispatcher>> eventDispatchers;
 	std::shared_ptr<TransportFactory> transportFactory;
 };
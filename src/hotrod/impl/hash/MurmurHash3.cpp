@@ -1,4 +1,5 @@
 #include "hotrod/impl/hash/MurmurHash3.h"
+#include <cstring>
 
 namespace infinispan {
 namespace hotrod {
@@ -53,8 +54,10 @@ inline uint64_t rotl64(uint64_t x, int8_t r) {
 // Block read - if your platform needs to do endian-swapping or can only
 // handle aligned reads, do the conversion here
 
-FORCE_INLINE int64_t getblock64(const int64_t * p, int i) {
-    return p[i];
+FORCE_INLINE uint64_t getblock64(const int8_t * p, int i) {
+    uint64_t block;
+    memcpy(&block, p + i * 8, sizeof(block));
+    return block;
 }
 
 //-----------------------------------------------------------------------------
@@ -71,130 +74,89 @@ FORCE_INLINE uint64_t fmix64(uint64_t k) {
 }
 
 //-----------------------------------------------------------------------------
+// Block mix. The state is unsigned: the arithmetic must wrap around, as it does
+// in the Java implementation, and signed overflow would be undefined.
+
+FORCE_INLINE void bmix64(uint64_t& h1, uint64_t& h2, uint64_t& c1, uint64_t& c2, uint64_t k1, uint64_t k2) {
+    k1 *= c1;
+    k1 = ROTL64(k1, 23);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 += h2;
 
+    h2 = ROTL64(h2, 41);
 
-uint64_t MurmurHash3_x64_64(const void * key, const int32_t len, const int32_t seed) {
-    // Exactly the same as MurmurHash3_x64_128, except it only returns state.h1
-    const int8_t * data = (const int8_t*) key;
-    const int nblocks = len / 16;
-
-    int64_t h1 = BIG_CONSTANT(0x9368e53c2f6af274) ^ seed;
-    int64_t h2 = BIG_CONSTANT(0x586dcd208f7cd3fd) ^ seed;
-
-    int64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
-    int64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
-
-    const int64_t * blocks = (const int64_t *) (data);
-
-    for (int i = 0; i < nblocks; i++) {
-        int64_t k1 = getblock64(blocks, i * 2 + 0);
-        int64_t k2 = getblock64(blocks, i * 2 + 1);
-
-        // bmix
-
-        k1 *= c1;
-        k1 = ROTL64(k1, 23);
-        k1 *= c2;
-        h1 ^= k1;
-        h1 += h2;
-
-        h2 = ROTL64(h2, 41);
-
-
-        k2 *= c2;
-        k2 = ROTL64(k2, 23);
-        k2 *= c1;
-        h2 ^= k2;
-        h2 += h1;
-
-        h1 = h1 * 3 + 0x52dce729;
-        h2 = h2 * 3 + 0x38495ab5;
-
-        c1 = c1 * 5 + 0x7b7d159c;
-        c2 = c2 * 5 + 0x6bce6396;
-    }
+    k2 *= c2;
+    k2 = ROTL64(k2, 23);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 += h1;
 
-    //----------
-    // tail
+    h1 = h1 * 3 + 0x52dce729;
+    h2 = h2 * 3 + 0x38495ab5;
 
-    const int8_t * tail = (const int8_t*) (data + nblocks * 16);
+    c1 = c1 * 5 + 0x7b7d159c;
+    c2 = c2 * 5 + 0x6bce6396;
+}
 
-    int64_t k1 = 0;
-    int64_t k2 = 0;
+// Tail bytes are signed, as Java bytes
+FORCE_INLINE uint64_t tailbyte(const int8_t * tail, int i, int shift) {
+    return (uint64_t) (int64_t) tail[i] << shift;
+}
 
-    switch (len & 15) {
+FORCE_INLINE void readtail64(const int8_t * tail, int rest, uint64_t& k1, uint64_t& k2) {
+    k1 = 0;
+    k2 = 0;
+    switch (rest) {
     case 15:
-        k2 ^= ((int64_t) tail[14]) << 48;
+        k2 ^= tailbyte(tail, 14, 48);
 	// fall through
     case 14:
-        k2 ^= ((int64_t) tail[13]) << 40;
+        k2 ^= tailbyte(tail, 13, 40);
 	// fall through
     case 13:
-        k2 ^= ((int64_t) tail[12]) << 32;
+        k2 ^= tailbyte(tail, 12, 32);
 	// fall through
     case 12:
-        k2 ^= ((int64_t) tail[11]) << 24;
+        k2 ^= tailbyte(tail, 11, 24);
 	// fall through
     case 11:
-        k2 ^= ((int64_t) tail[10]) << 16;
+        k2 ^= tailbyte(tail, 10, 16);
 	// fall through
     case 10:
-        k2 ^= ((int64_t) tail[9]) << 8;
+        k2 ^= tailbyte(tail, 9, 8);
 	// fall through
     case 9:
-        k2 ^= ((int64_t) tail[8]) << 0;
+        k2 ^= tailbyte(tail, 8, 0);
 	// fall through
     case 8:
-        k1 ^= ((int64_t) tail[7]) << 56;
+        k1 ^= tailbyte(tail, 7, 56);
 	// fall through
     case 7:
-        k1 ^= ((int64_t) tail[6]) << 48;
+        k1 ^= tailbyte(tail, 6, 48);
 	// fall through
     case 6:
-        k1 ^= ((int64_t) tail[5]) << 40;
+        k1 ^= tailbyte(tail, 5, 40);
 	// fall through
     case 5:
-        k1 ^= ((int64_t) tail[4]) << 32;
+        k1 ^= tailbyte(tail, 4, 32);
 	// fall through
     case 4:
-        k1 ^= ((int64_t) tail[3]) << 24;
+        k1 ^= tailbyte(tail, 3, 24);
 	// fall through
     case 3:
-        k1 ^= ((int64_t) tail[2]) << 16;
+        k1 ^= tailbyte(tail, 2, 16);
 	// fall through
     case 2:
-        k1 ^= ((int64_t) tail[1]) << 8;
+        k1 ^= tailbyte(tail, 1, 8);
 	// fall through
     case 1:
-        k1 ^= ((int64_t) tail[0]) << 0;
+        k1 ^= tailbyte(tail, 0, 0);
     };
+}
 
-    if ((len & 15) != 0) {
-        // bmix
-        k1 *= c1;
-        k1 = ROTL64(k1, 23);
-        k1 *= c2;
-        h1 ^= k1;
-        h1 += h2;
-
-        h2 = ROTL64(h2, 41);
-
-        k2 *= c2;
-        k2 = ROTL64(k2, 23);
-        k2 *= c1;
-        h2 ^= k2;
-        h2 += h1;
-
-        h1 = h1 * 3 + 0x52dce729;
-        h2 = h2 * 3 + 0x38495ab5;
-
-        c1 = c1 * 5 + 0x7b7d159c;
-        c2 = c2 * 5 + 0x6bce6396;
-    }
-
-    //----------
-    // finalization
-    h2 ^= len;
+FORCE_INLINE uint64_t finalize64(uint64_t h1, uint64_t h2, const int32_t len) {
+    h2 ^= (uint64_t) (int64_t) len;
 
     h1 += h2;
     h2 += h1;
@@ -202,14 +164,47 @@ uint64_t MurmurHash3_x64_64(const void * key, const int32_t len, const int32_t s
     h1 = fmix64(h1);
     h2 = fmix64(h2);
 
-    h1 += h2;
-    h2 += h1;
+    return h1 + h2;
+}
 
-    return h1;
+//-----------------------------------------------------------------------------
+
+
+uint64_t MurmurHash3_x64_64(const void * key, const int32_t len, const int32_t seed) {
+    // Exactly the same as MurmurHash3_x64_128, except it only returns state.h1
+    const int8_t * data = (const int8_t*) key;
+    const int nblocks = len / 16;
+
+    uint64_t h1 = BIG_CONSTANT(0x9368e53c2f6af274) ^ (int64_t) seed;
+    uint64_t h2 = BIG_CONSTANT(0x586dcd208f7cd3fd) ^ (int64_t) seed;
+
+    uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
+    uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
+
+    for (int i = 0; i < nblocks; i++) {
+        bmix64(h1, h2, c1, c2, getblock64(data, i * 2 + 0), getblock64(data, i * 2 + 1));
+    }
+
+    //----------
+    // tail
+
+    const int8_t * tail = (const int8_t*) (data + nblocks * 16);
+
+    uint64_t k1, k2;
+    readtail64(tail, len & 15, k1, k2);
+
+    if ((len & 15) != 0) {
+        bmix64(h1, h2, c1, c2, k1, k2);
+    }
+
+    //----------
+    // finalization
+
+    return finalize64(h1, h2, len);
 }
 
 int32_t MurmurHash3_x64_32(const void * key, const int32_t len, const int32_t seed) {
-    return (int32_t) ((uint64_t) MurmurHash3_x64_64(key, len, seed) >> 32);
+    return (int32_t) (MurmurHash3_x64_64(key, len, seed) >> 32);
 }
 
 // Method declarations
@@ -226,53 +221,22 @@ uint32_t MurmurHash3::hash(int32_t key) {
 	int8_t b2 = (int8_t) ((uint32_t) key >> 16);
 	int8_t b3 = (int8_t) ((uint32_t) key >> 24);
 
-	int64_t h1 = BIG_CONSTANT(0x9368e53c2f6af274) ^ 9001;
-	int64_t h2 = BIG_CONSTANT(0x586dcd208f7cd3fd) ^ 9001;
-
-	int64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
-	int64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
-
-	int64_t k1 = 0;
-	int64_t k2 = 0;
-
-	k1 ^= (int64_t) b3 << 24;
-	k1 ^= (int64_t) b2 << 16;
-	k1 ^= (int64_t) b1 << 8;
-	k1 ^= b0;
-
-	// bmix
-	k1 *= c1;
-	k1 = ROTL64(k1, 23);
-	k1 *= c2;
-	h1 ^= k1;
-	h1 += h2;
-
-	h2 = ROTL64(h2, 41);
-
-	k2 *= c2;
-	k2 = ROTL64(k2, 23);
-	k2 *= c1;
-	h2 ^= k2;
-	h2 += h1;
-
-	h1 = h1 * 3 + 0x52dce729;
-	h2 = h2 * 3 + 0x38495ab5;
-
-	c1 = c1 * 5 + 0x7b7d159c;
-	c2 = c2 * 5 + 0x6bce6396;
+	uint64_t h1 = BIG_CONSTANT(0x9368e53c2f6af274) ^ 9001;
+	uint64_t h2 = BIG_CONSTANT(0x586dcd208f7cd3fd) ^ 9001;
 
-	h2 ^= 4;
+	uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
+	uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
 
-	h1 += h2;
-	h2 += h1;
+	uint64_t k1 = 0;
 
-	h1 = fmix64(h1);
-	h2 = fmix64(h2);
+	k1 ^= (uint64_t) (int64_t) b3 << 24;
+	k1 ^= (uint64_t) (int64_t) b2 << 16;
+	k1 ^= (uint64_t) (int64_t) b1 << 8;
+	k1 ^= (uint64_t) (int64_t) b0;
 
-	h1 += h2;
-	h2 += h1;
+	bmix64(h1, h2, c1, c2, k1, 0);
 
-	return (int32_t) ((uint64_t) h1 >> 32);
+	return (uint32_t) (finalize64(h1, h2, 4) >> 32);
 }
 
 }} // namespace
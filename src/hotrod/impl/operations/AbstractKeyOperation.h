@@ -34,23 +34,29 @@ template<class T> class AbstractKeyOperation : public RetryOnFailureOperation<T>
 
     transport::Transport& getTransport(int retryCount, const std::set<transport::InetSocketAddress>& failedServers) {
         if (retryCount == 0) {
-            return this->transportFactory->getTransport(key, this->cacheName, failedServers);
+            return isReadOnly() ? this->transportFactory->getReadTransport(key, this->cacheName, failedServers)
+                    : this->transportFactory->getTransport(key, this->cacheName, failedServers);
         } else {
             return this->transportFactory->getTransport(this->cacheName, failedServers);
         }
     }
 
+    /**
+     * Read only operations may be served by any owner of the key, see ReadRoutingPolicy
+     */
+    virtual bool isReadOnly() const { return false; }
+
     uint8_t sendKeyOperation(
         const std::vector<char>& _key, transport::Transport& transport,
         uint8_t opCode, uint8_t /*opRespCode*/)
     {
         // 1) write [header][key length][key]
-        std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, opCode));
+        protocol::HeaderParams params = this->writeHeader(transport, opCode);
         transport.writeArray(_key);
         transport.flush();
 
         // 2) now read the header
-        return this->readHeaderAndValidate(transport, *params);
+        return this->readHeaderAndValidate(transport, params);
     }
 
     std::vector<char> returnPossiblePrevValue(transport::Transport& transport, uint8_t status) {
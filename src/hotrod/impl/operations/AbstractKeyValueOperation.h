@@ -43,7 +43,7 @@ template<class T> class AbstractKeyValueOperation : public AbstractKeyOperation<
             uint8_t                                       /*opRespCode*/)
         {
             // 1) write header
-            std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, opCode));
+            protocol::HeaderParams params = this->writeHeader(transport, opCode);
 
             // 2) write key and value
             transport.writeArray(this->key);
@@ -54,7 +54,7 @@ template<class T> class AbstractKeyValueOperation : public AbstractKeyOperation<
             // 3) now read header
 
             //return status (not error status for sure)
-            return this->readHeaderAndValidate(transport, *params);
+            return this->readHeaderAndValidate(transport, params);
         }
 };
 
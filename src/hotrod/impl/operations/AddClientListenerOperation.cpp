@@ -88,7 +88,7 @@ static void processImmediateEvent(const ClientListener &clientListener, const Co
 char AddClientListenerOperation::executeOperation(transport::Transport& transport)
 {
     this->failed = false;
-    std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, ADD_CLIENT_LISTENER_REQUEST));
+    protocol::HeaderParams params = this->writeHeader(transport, ADD_CLIENT_LISTENER_REQUEST);
     const Codec20& codec20 = dynamic_cast<const Codec20&>(codec);
     transport.writeArray(listenerId);
     codec20.writeClientListenerParams(transport, clientListener, filterFactoryParams, converterFactoryParams);
@@ -121,12 +121,12 @@ char AddClientListenerOperation::executeOperation(transport::Transport& transpor
                 respOpCode = codec20.readAddEventListenerResponseType(transport, respMessageId);
             }
         }
-        if (respMessageId != params->getMessageId() && respMessageId != 0) {
+        if (respMessageId != params.getMessageId() && respMessageId != 0) {
             std::ostringstream message;
-            message << "Invalid message id. Expected " << params->getMessageId() << " and received " << respMessageId;
+            message << "Invalid message id. Expected " << params.getMessageId() << " and received " << respMessageId;
             throw InvalidResponseException(message.str());
         }
-        if (HotRodConstants::isSuccess(status) && HotRodConstants::isSuccess(codec20.readPartialHeader(transport, *params, respOpCode))) {
+        if (HotRodConstants::isSuccess(status) && HotRodConstants::isSuccess(codec20.readPartialHeader(transport, params, respOpCode))) {
             listenerNotifier.startClientListener(listenerId);
         }
         else {
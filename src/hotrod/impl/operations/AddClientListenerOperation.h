@@ -27,7 +27,7 @@ namespace operations {
 class AddClientListenerOperation: public RetryOnFailureOperation<char>, public std::enable_shared_from_this<AddClientListenerOperation> {
 public:
 	AddClientListenerOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-                             std::vector<char> cacheName, Topology& topologyId, int flags,
+                             const std::vector<char>& cacheName, Topology& topologyId, int flags,
                              ClientListenerNotifier &listenerNotifier, const ClientListener& clientListener,
 		             std::vector<std::vector<char> > filterFactoryParams,
 	std::vector<std::vector<char> > converterFactoryParams, const std::function<void()> &recoveryCallback, EntryMediaTypes* df)
@@ -35,6 +35,9 @@ public:
 							 listenerId(generateV4UUID()), clientListener(clientListener), filterFactoryParams(filterFactoryParams), converterFactoryParams(converterFactoryParams),
 							 recoveryCallback(recoveryCallback), cacheName(cacheName)
 							 {};
+	AddClientListenerOperation(const Codec&, std::shared_ptr<TransportFactory>, std::vector<char>&&, Topology&, int,
+	                         ClientListenerNotifier&, const ClientListener&, std::vector<std::vector<char> >,
+	                         std::vector<std::vector<char> >, const std::function<void()>&, EntryMediaTypes*) = delete;
     virtual void releaseTransport(transport::Transport* transport);
     virtual void invalidateTransport(const infinispan::hotrod::transport::InetSocketAddress &, transport::Transport*);
 
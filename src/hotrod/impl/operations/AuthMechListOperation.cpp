@@ -12,7 +12,7 @@ namespace hotrod {
 namespace operations {
 
 AuthMechListOperation::AuthMechListOperation(Codec& codec, Transport &transport) :
-         HotRodOperation(codec, 0, std::vector<char>(), topology, nullptr), codec(codec), transport(transport) {
+         HotRodOperation(codec, 0, protocol::HeaderParams::noCacheName(), topology, nullptr), codec(codec), transport(transport) {
 }
 AuthMechListOperation::~AuthMechListOperation() {
     // TODO Auto-generated destructor stub
@@ -21,10 +21,10 @@ AuthMechListOperation::~AuthMechListOperation() {
 std::vector<std::string> AuthMechListOperation::execute() {
     std::vector<std::string> result;
 
-    std::unique_ptr<protocol::HeaderParams> params(writeHeader(transport, AUTH_MECH_LIST_REQUEST));
+    protocol::HeaderParams params = writeHeader(transport, AUTH_MECH_LIST_REQUEST);
    transport.flush();
 
-   readHeaderAndValidate(transport, *params);
+   readHeaderAndValidate(transport, params);
    int mechCount = transport.readVInt();
 
    for (int i = 0; i < mechCount; i++) {
@@ -26,10 +26,10 @@ BulkGetKeysOperation::BulkGetKeysOperation(
 std::set<std::vector<char>> BulkGetKeysOperation::executeOperation(Transport& transport)
 {
     TRACE("Execute BulkGetKeys(flags=%u,scope=%d)", flags, scope);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<std::set<std::vector<char>> >::writeHeader(transport, BULK_GET_KEYS_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<std::set<std::vector<char>> >::writeHeader(transport, BULK_GET_KEYS_REQUEST);
     transport.writeVInt(scope);
     transport.flush();
-    RetryOnFailureOperation<std::set<std::vector<char>> >::readHeaderAndValidate(transport, *params);
+    RetryOnFailureOperation<std::set<std::vector<char>> >::readHeaderAndValidate(transport, params);
     std::set<std::vector<char>> result;
     while (transport.readByte()==1) {
         result.insert(transport.readArray());
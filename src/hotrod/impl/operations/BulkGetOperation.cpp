@@ -22,10 +22,10 @@ BulkGetOperation::BulkGetOperation(
 std::map<std::vector<char>,std::vector<char>> BulkGetOperation::executeOperation(infinispan::hotrod::transport::Transport& transport)
 {
     TRACE("Execute BulkGet(flags=%u, entryCount=%d)", flags, entryCount);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<std::map<std::vector<char>, std::vector<char>> >::writeHeader(transport, BULK_GET_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<std::map<std::vector<char>, std::vector<char>> >::writeHeader(transport, BULK_GET_REQUEST);
     transport.writeVInt(entryCount);
     transport.flush();
-    RetryOnFailureOperation<std::map<std::vector<char>, std::vector<char>> >::readHeaderAndValidate(transport, *params);
+    RetryOnFailureOperation<std::map<std::vector<char>, std::vector<char>> >::readHeaderAndValidate(transport, params);
     std::map<std::vector<char>,std::vector<char>> result;
     while (transport.readByte()==1) {
         std::vector<char> key = transport.readArray();
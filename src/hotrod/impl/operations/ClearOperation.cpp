@@ -21,9 +21,9 @@ ClearOperation::ClearOperation(
 std::vector<char> ClearOperation::executeOperation(infinispan::hotrod::transport::Transport& transport)
 {
     TRACE("Executing Clear(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<std::vector<char>>::writeHeader(transport, CLEAR_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<std::vector<char>>::writeHeader(transport, CLEAR_REQUEST);
     transport.flush();
-    RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, *params);
+    RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, params);
     TRACE("Finished Clear");
     return std::vector<char>();
 }
@@ -13,6 +13,7 @@ class ContainsKeyOperation : public AbstractKeyOperation<bool>
     protected:
         bool executeOperation(
             infinispan::hotrod::transport::Transport& transport);
+        bool isReadOnly() const { return true; }
 
     private:
         ContainsKeyOperation(
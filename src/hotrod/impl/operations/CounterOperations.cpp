@@ -92,11 +92,11 @@ CounterConfiguration BaseCounterOperation::readConfiguration(infinispan::hotrod:
 
 bool DefineCounterOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing DefineCounterOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_CREATE_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_CREATE_REQUEST);
     writeName(transport, counterName);
     writeConfiguration(transport, configuration);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     TRACE("Finished DefineCounterOperation");
     return isSuccess(status);
 }
@@ -104,11 +104,10 @@ bool DefineCounterOperation::executeOperation(infinispan::hotrod::transport::Tra
 CounterConfiguration GetCounterConfigurationOperation::executeOperation(
         infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing GetConfigurationOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(
-            RetryOnFailureOperation<CounterConfiguration>::writeHeader(transport, COUNTER_GET_CONFIGURATION_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<CounterConfiguration>::writeHeader(transport, COUNTER_GET_CONFIGURATION_REQUEST);
     writeName(transport, counterName);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     if (!isSuccess(status)) {
         throw HotRodClientException(
                 std::string("Error in CounterGetConfiguration operation, counter name: ") + counterName + " status: "
@@ -121,10 +120,10 @@ CounterConfiguration GetCounterConfigurationOperation::executeOperation(
 
 void ResetCounterOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing ResetOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<void>::writeHeader(transport, COUNTER_RESET_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<void>::writeHeader(transport, COUNTER_RESET_REQUEST);
     writeName(transport, counterName);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     if (!isSuccess(status) && status != KEY_DOES_NOT_EXIST_STATUS) {
         throw HotRodClientException(
                 std::string("Error in CounterReset operation, counter name: ") + counterName + " status: "
@@ -135,10 +134,10 @@ void ResetCounterOperation::executeOperation(infinispan::hotrod::transport::Tran
 
 void RemoveCounterOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing RemoveOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<void>::writeHeader(transport, COUNTER_REMOVE_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<void>::writeHeader(transport, COUNTER_REMOVE_REQUEST);
     writeName(transport, counterName);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     if (!isSuccess(status) && status != KEY_DOES_NOT_EXIST_STATUS) {
         throw HotRodClientException(
                 std::string("Error in CounterRemove operation, counter name: ") + counterName + " status: "
@@ -149,9 +148,8 @@ void RemoveCounterOperation::executeOperation(infinispan::hotrod::transport::Tra
 
 std::set<std::string> GetCounterNamesOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing GetCounterNamesOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(
-            RetryOnFailureOperation<std::set<std::string>>::writeHeader(transport, COUNTER_GET_NAMES_REQUEST));
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    HeaderParams params = RetryOnFailureOperation<std::set<std::string>>::writeHeader(transport, COUNTER_GET_NAMES_REQUEST);
+    uint8_t status = readHeaderAndValidate(transport, params);
     std::set<std::string> ret;
     if (!isSuccess(status)) {
         auto num = transport.readVInt();
@@ -166,20 +164,30 @@ std::set<std::string> GetCounterNamesOperation::executeOperation(infinispan::hot
 
 bool IsCounterDefinedOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing IsCounterDefinedOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_CREATE_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_CREATE_REQUEST);
     writeName(transport, counterName);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     TRACE("Finished IsCounterDefinedOperation");
     return status==0x00;
 }
 
 long GetCounterValueOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
+    HeaderParams params = writeRequest(transport);
+    transport.flush();
+    return readResponse(transport, params, codec.readMessageId(transport));
+}
+
+HeaderParams GetCounterValueOperation::writeRequest(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing IsCounterDefinedOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_GET_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_GET_REQUEST);
     writeName(transport, counterName);
-    transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    return params;
+}
+
+long GetCounterValueOperation::readResponse(infinispan::hotrod::transport::Transport& transport, HeaderParams& params,
+        uint64_t messageId) {
+    uint8_t status = readHeaderAndValidate(transport, params, messageId);
     if (!isSuccess(status)) {
         throw HotRodClientException(
                 std::string("Error in GetCountervalue operation, counter name: ") + counterName + " status: "
@@ -191,12 +199,22 @@ long GetCounterValueOperation::executeOperation(infinispan::hotrod::transport::T
 }
 
 long AddAndGetCounterValueOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
+    HeaderParams params = writeRequest(transport);
+    transport.flush();
+    return readResponse(transport, params, codec.readMessageId(transport));
+}
+
+HeaderParams AddAndGetCounterValueOperation::writeRequest(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing GetCounterValue(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_ADD_AND_GET_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_ADD_AND_GET_REQUEST);
     writeName(transport, counterName);
     transport.writeLong(delta);
-    transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    return params;
+}
+
+long AddAndGetCounterValueOperation::readResponse(infinispan::hotrod::transport::Transport& transport,
+        HeaderParams& params, uint64_t messageId) {
+    uint8_t status = readHeaderAndValidate(transport, params, messageId);
     assertBoundaries(status);
     TRACE("Finished GetCounterValue");
     if (!isSuccess(status)) {
@@ -218,13 +236,23 @@ void AddAndGetCounterValueOperation::assertBoundaries(short status) {
 }
 
 long CompareAndSwapCounterValueOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
+    HeaderParams params = writeRequest(transport);
+    transport.flush();
+    return readResponse(transport, params, codec.readMessageId(transport));
+}
+
+HeaderParams CompareAndSwapCounterValueOperation::writeRequest(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing CompareAndSwapOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_CAS_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<long>::writeHeader(transport, COUNTER_CAS_REQUEST);
     writeName(transport, counterName);
     transport.writeLong(expect);
     transport.writeLong(update);
-    transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    return params;
+}
+
+long CompareAndSwapCounterValueOperation::readResponse(infinispan::hotrod::transport::Transport& transport,
+        HeaderParams& params, uint64_t messageId) {
+    uint8_t status = readHeaderAndValidate(transport, params, messageId);
     assertBoundaries(status);
     if (status != NO_ERROR_STATUS) {
         throw HotRodClientException(
@@ -249,12 +277,11 @@ void CompareAndSwapCounterValueOperation::assertBoundaries(short status) {
 Transport* AddCounterListenerOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing AddCounterListenerOperation(flags=%u)", flags);
     failed = false;
-    std::unique_ptr<HeaderParams> params(
-            RetryOnFailureOperation<Transport*>::writeHeader(transport, COUNTER_ADD_LISTENER_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<Transport*>::writeHeader(transport, COUNTER_ADD_LISTENER_REQUEST);
     writeName(transport, counterName);
     transport.writeArray(listenerId);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     if (status != NO_ERROR_STATUS) {
         failed = true;
         return nullptr;
@@ -278,12 +305,11 @@ void AddCounterListenerOperation::invalidateTransport(const infinispan::hotrod::
 
 bool RemoveCounterListenerOperation::executeOperation(infinispan::hotrod::transport::Transport& transport) {
     TRACE("Executing RemoveCounterListenerOperation(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(
-            RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_REMOVE_LISTENER_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<bool>::writeHeader(transport, COUNTER_REMOVE_LISTENER_REQUEST);
     writeName(transport, counterName);
     transport.writeArray(listenerId);
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     return status == NO_ERROR_STATUS;
 }
 
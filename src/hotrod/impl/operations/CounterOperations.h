@@ -41,7 +41,7 @@ public:
     DefineCounterOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName, CounterConfiguration configuration) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<bool>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr), configuration(configuration) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr), configuration(configuration) {
     }
     bool executeOperation(infinispan::hotrod::transport::Transport& transport);
     private:
@@ -56,7 +56,7 @@ public:
             std::shared_ptr<transport::TransportFactory> transportFactory, Topology& topologyId, uint32_t flags,
             std::string counterName) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<CounterConfiguration>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     CounterConfiguration executeOperation(infinispan::hotrod::transport::Transport& transport);
 };
@@ -67,7 +67,7 @@ public:
     ResetCounterOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<void>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     void executeOperation(infinispan::hotrod::transport::Transport& transport);
 };
@@ -78,7 +78,7 @@ public:
     RemoveCounterOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<void>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     void executeOperation(infinispan::hotrod::transport::Transport& transport);
 };
@@ -89,7 +89,7 @@ public:
     GetCounterNamesOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags) :
             BaseCounterOperation(), RetryOnFailureOperation<std::set<std::string> >(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     std::set<std::string> executeOperation(infinispan::hotrod::transport::Transport& transport);
 };
@@ -100,7 +100,7 @@ public:
     IsCounterDefinedOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<bool>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     bool executeOperation(infinispan::hotrod::transport::Transport& transport);
 };
@@ -111,9 +111,13 @@ public:
     GetCounterValueOperation(protocol::Codec& codec, std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<long>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr) {
     }
     long executeOperation(infinispan::hotrod::transport::Transport& transport);
+    // The two halves of executeOperation(), see Pipeline
+    protocol::HeaderParams writeRequest(infinispan::hotrod::transport::Transport& transport);
+    long readResponse(infinispan::hotrod::transport::Transport& transport, protocol::HeaderParams& params,
+            uint64_t messageId);
 };
 
 class AddAndGetCounterValueOperation: public BaseCounterOperation, public RetryOnFailureOperation<long>
@@ -123,9 +127,12 @@ public:
             std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName, long delta) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<long>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr), delta(delta) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr), delta(delta) {
     }
     long executeOperation(infinispan::hotrod::transport::Transport& transport);
+    protocol::HeaderParams writeRequest(infinispan::hotrod::transport::Transport& transport);
+    long readResponse(infinispan::hotrod::transport::Transport& transport, protocol::HeaderParams& params,
+            uint64_t messageId);
     private:
     long delta;
 
@@ -137,15 +144,19 @@ public:
     CompareAndSwapCounterValueOperation(protocol::Codec& codec,
             std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName, long expect, long update,
-            CounterConfiguration& cc) :
+            const CounterConfiguration& cc) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<long>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr), expect(expect), update(update), cc(cc) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr), expect(expect), update(update), cc(cc) {
     }
     long executeOperation(infinispan::hotrod::transport::Transport& transport);
+    protocol::HeaderParams writeRequest(infinispan::hotrod::transport::Transport& transport);
+    long readResponse(infinispan::hotrod::transport::Transport& transport, protocol::HeaderParams& params,
+            uint64_t messageId);
     private:
     long expect;
     long update;
-    CounterConfiguration& cc;
+    // A copy, an asynchronous operation may outlive the counter handle
+    CounterConfiguration cc;
 
     void assertBoundaries(short status);
 
@@ -157,7 +168,7 @@ public:
             Topology& topologyId, uint32_t flags, std::string counterName, std::vector<char> listenerId,
             bool keepTransport) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<Transport*>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr), listenerId(listenerId), keepTransport(keepTransport), failed(
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr), listenerId(listenerId), keepTransport(keepTransport), failed(
                     false) {
     }
     Transport* executeOperation(infinispan::hotrod::transport::Transport& transport);
@@ -177,7 +188,7 @@ public:
             std::shared_ptr<transport::TransportFactory> transportFactory,
             Topology& topologyId, uint32_t flags, std::string counterName, std::vector<char> listenerId) :
             BaseCounterOperation(counterName), RetryOnFailureOperation<bool>(codec, transportFactory,
-                    std::vector<char>(), topologyId, flags, nullptr), listenerId(listenerId) {
+                    protocol::HeaderParams::noCacheName(), topologyId, flags, nullptr), listenerId(listenerId) {
     }
     bool executeOperation(infinispan::hotrod::transport::Transport& transport);
     private:
@@ -38,7 +38,7 @@ namespace infinispan
                 uint8_t /*opRespCode*/)
             {
                 // 1) write header
-                std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, opCode));
+                protocol::HeaderParams params = this->writeHeader(transport, opCode);
 
                 // 2) write key and value
                 transport.writeArray(this->cmdName);
@@ -53,7 +53,7 @@ namespace infinispan
                 transport.flush();
 
                 // 3) now read header
-                RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, *params);
+                RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, params);
                 return transport.readArray();
             }
 
@@ -84,7 +84,7 @@ namespace infinispan
                 uint8_t /*opRespCode*/)
             {
                 // 1) write header
-                std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, opCode));
+                protocol::HeaderParams params = this->writeHeader(transport, opCode);
 
                 // 2) write key and value
                 transport.writeArray(this->cmdName);
@@ -99,7 +99,7 @@ namespace infinispan
                 transport.flush();
 
                 // 3) now read header
-                RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, *params);
+                RetryOnFailureOperation<std::vector<char>>::readHeaderAndValidate(transport, params);
                 return transport.readArray();
             }
 
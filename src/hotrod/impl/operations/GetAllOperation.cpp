@@ -16,14 +16,14 @@ std::map<std::vector<char>, std::vector<char>> GetAllOperation::executeOperation
 {
 	std::map<std::vector<char>, std::vector<char>> result;
 	TRACE("Executing GetAll(flags=%u)", flags);
-	std::unique_ptr<protocol::HeaderParams> params(this->writeHeader(transport, GET_ALL_REQUEST));
+	protocol::HeaderParams params = this->writeHeader(transport, GET_ALL_REQUEST);
 	transport.writeVInt(keySet.size());
 	for (auto &item : keySet)
 	{
 		transport.writeArray(item);
 		transport.flush();
 	}
-	uint8_t status = readHeaderAndValidate(transport, *params);
+	uint8_t status = readHeaderAndValidate(transport, params);
 	if (status == NO_ERROR_STATUS) {
 		uint32_t count = transport.readVInt();
 		for (uint32_t i = 0; i < count; i++)
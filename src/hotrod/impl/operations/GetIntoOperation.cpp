@@ -0,0 +1,31 @@
+#include "hotrod/impl/operations/GetIntoOperation.h"
+
+namespace infinispan {
+namespace hotrod {
+namespace operations {
+
+using infinispan::hotrod::protocol::Codec;
+using namespace infinispan::hotrod::transport;
+
+GetIntoOperation::GetIntoOperation(
+    const Codec& _codec, std::shared_ptr<transport::TransportFactory> _transportFactory, const std::vector<char>& _key,
+    const std::vector<char>& _cacheName, Topology& _topologyId, uint32_t _flags, std::vector<char>& _value, EntryMediaTypes* df)
+    : AbstractKeyOperation<bool>(
+        _codec, _transportFactory, _key, _cacheName, _topologyId, _flags, df), value(_value)
+{}
+
+bool GetIntoOperation::executeOperation(Transport& transport) {
+    TRACE("Executing GetInto(flags=%u)", flags);
+    TRACEBYTES("key = ", key);
+    uint8_t status = sendKeyOperation(key, transport, GET_REQUEST, GET_RESPONSE);
+    if (HotRodConstants::isSuccess(status)) {
+        transport.readArrayInto(value);
+        TRACEBYTES("return value = ", value);
+        return true;
+    }
+    TRACE("Error status %u", status);
+    value.clear();
+    return false;
+}
+
+}}} /// namespace infinispan::hotrod::operations
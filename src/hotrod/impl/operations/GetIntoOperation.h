@@ -0,0 +1,36 @@
+#ifndef ISPN_HOTROD_OPERATIONS_GETINTOOPERATION_H
+#define ISPN_HOTROD_OPERATIONS_GETINTOOPERATION_H
+
+#include "hotrod/impl/operations/AbstractKeyOperation.h"
+
+namespace infinispan {
+namespace hotrod {
+class Topology;
+namespace operations {
+
+/*
+ * Reads the value straight into a caller-owned buffer, the buffer capacity
+ * is reused so a steady state of gets doesn't allocate
+ */
+class GetIntoOperation : public AbstractKeyOperation<bool>
+{
+  protected:
+    bool executeOperation(
+        infinispan::hotrod::transport::Transport& transport);
+    bool isReadOnly() const { return true; }
+
+  private:
+    GetIntoOperation(
+        const infinispan::hotrod::protocol::Codec& codec,
+        std::shared_ptr<transport::TransportFactory> transportFactory,
+        const std::vector<char>& key, const std::vector<char>& cacheName,
+        Topology& topologyId, uint32_t flags, std::vector<char>& value, EntryMediaTypes* df);
+
+    std::vector<char>& value;
+
+  friend class OperationsFactory;
+};
+
+}}} // namespace infinispan::hotrod::operations
+
+#endif  // ISPN_HOTROD_OPERATIONS_GETINTOOPERATION_H
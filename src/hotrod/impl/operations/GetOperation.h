@@ -14,6 +14,7 @@ class GetOperation : public AbstractKeyOperation<std::vector<char>>
   protected:
     std::vector<char> executeOperation(
         infinispan::hotrod::transport::Transport& transport);
+    bool isReadOnly() const { return true; }
 
   private:
     GetOperation(
@@ -23,6 +24,7 @@ class GetOperation : public AbstractKeyOperation<std::vector<char>>
         Topology& topologyId, uint32_t flags, EntryMediaTypes* df);
 
   friend class OperationsFactory;
+  friend class OperationsTest;
 };
 
 }}} // namespace infinispan::hotrod::operations
@@ -21,11 +21,25 @@ GetWithMetadataOperation::GetWithMetadataOperation(
 
 MetadataValueImpl<std::vector<char>> GetWithMetadataOperation::executeOperation(Transport& transport)
 {
-    MetadataValueImpl<std::vector<char>> result;
+    protocol::HeaderParams params = writeRequest(transport);
+    transport.flush();
+    return readResponse(transport, params, codec.readMessageId(transport));
+}
+
+protocol::HeaderParams GetWithMetadataOperation::writeRequest(Transport& transport)
+{
     TRACE("Execute GetWithMetadata(flags=%u)", flags);
     TRACEBYTES("key = ", key);
-    uint8_t status = sendKeyOperation(
-        key, transport, GET_WITH_METADATA_REQUEST, GET_WITH_METADATA_RESPONSE);
+    protocol::HeaderParams params = writeHeader(transport, GET_WITH_METADATA_REQUEST);
+    transport.writeArray(key);
+    return params;
+}
+
+MetadataValueImpl<std::vector<char>> GetWithMetadataOperation::readResponse(Transport& transport,
+    protocol::HeaderParams& params, uint64_t messageId)
+{
+    MetadataValueImpl<std::vector<char>> result;
+    uint8_t status = readHeaderAndValidate(transport, params, messageId);
     if (HotRodConstants::isSuccess(status)) {
         uint8_t flag = transport.readByte();
         if ((flag & INFINITE_LIFESPAN) != INFINITE_LIFESPAN) {
@@ -14,9 +14,16 @@ namespace operations {
 class GetWithMetadataOperation
    : public AbstractKeyOperation<MetadataValueImpl<std::vector<char>> >
 {
+    public:
+        // The two halves of executeOperation(), see Pipeline
+        protocol::HeaderParams writeRequest(infinispan::hotrod::transport::Transport& transport);
+        MetadataValueImpl<std::vector<char>> readResponse(infinispan::hotrod::transport::Transport& transport,
+            protocol::HeaderParams& params, uint64_t messageId);
+
     protected:
         MetadataValueImpl<std::vector<char>> executeOperation(
             infinispan::hotrod::transport::Transport& transport);
+        bool isReadOnly() const { return true; }
 
     private:
         GetWithMetadataOperation(
@@ -17,6 +17,7 @@ class GetWithVersionOperation
     protected:
         VersionedValueImpl<std::vector<char>> executeOperation(
             infinispan::hotrod::transport::Transport& transport);
+        bool isReadOnly() const { return true; }
 
     private:
         GetWithVersionOperation(
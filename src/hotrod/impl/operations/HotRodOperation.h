@@ -24,16 +24,17 @@ template<class T> class HotRodOperation : public protocol::HotRodConstants
             codec(_codec), flags(_flags),
             cacheName(_cacheName), topologyId(_topologyId), dataFormat(df) {
     }
+    // The cache name is kept by reference, a temporary would dangle
+    HotRodOperation(const protocol::Codec&, uint32_t, std::vector<char>&&, Topology&, EntryMediaTypes*) = delete;
 
-    protocol::HeaderParams* writeHeader(
+    protocol::HeaderParams writeHeader(
         transport::Transport& transport, uint8_t opCode)
     {
-        protocol::HeaderParams* params =
-            new protocol::HeaderParams(topologyId);
-        (*params).setOpCode(opCode).setCacheName(cacheName)
+        protocol::HeaderParams params(topologyId);
+        params.setOpCode(opCode).setCacheName(cacheName)
             .setFlags(flags).setClientIntel(CLIENT_INTELLIGENCE_HASH_DISTRIBUTION_AWARE)
             .setTxMarker(NO_TX).setTopologyAge(0).setDataFormat(dataFormat);
-        codec.writeHeader(transport, *params);
+        codec.writeHeader(transport, params);
         return params;
     }
 
@@ -44,11 +45,20 @@ template<class T> class HotRodOperation : public protocol::HotRodConstants
         return codec.readHeader(transport, params);
     }
 
+    // For a response already matched to its request by message id, see Pipeline
+    uint8_t readHeaderAndValidate(
+        transport::Transport& transport,
+        protocol::HeaderParams& params, uint64_t receivedMessageId)
+    {
+        return codec.readHeaderAfterMessageId(transport, params, receivedMessageId);
+    }
+
     virtual ~HotRodOperation() {}
 
     const protocol::Codec& codec;
     uint32_t flags;
-    std::vector<char> cacheName;
+    // Interned by the OperationsFactory, shared by every operation on the cache
+    const std::vector<char>& cacheName;
     // TODO: atomic
     Topology& topologyId;
     void setDataFormat(EntryMediaTypes *df) { this->dataFormat = df; }
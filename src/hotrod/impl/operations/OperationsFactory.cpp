@@ -3,6 +3,7 @@
 #include "hotrod/impl/protocol/CodecFactory.h"
 #include "hotrod/impl/transport/Transport.h"
 #include "hotrod/impl/operations/GetOperation.h"
+#include "hotrod/impl/operations/GetIntoOperation.h"
 #include "hotrod/impl/operations/GetAllOperation.h"
 #include "hotrod/impl/operations/PutOperation.h"
 #include "hotrod/impl/operations/PutIfAbsentOperation.h"
@@ -28,7 +29,9 @@
 #include <hotrod/impl/operations/TransactionOperations.h>
 #include "infinispan/hotrod/Flag.h"
 
+#include <atomic>
 #include <cstring>
+#include <utility>
 #include <vector>
 #include <functional>
 
@@ -39,11 +42,32 @@ namespace operations {
 using namespace protocol;
 using namespace transport;
 
+/*
+ * Flags requested with withFlags() for the next operation of the calling thread, by factory id.
+ * Keeping them per thread lets many threads share a cache without racing on them, keeping them
+ * per factory lets a thread interleave caches. Ids aren't reused, so the flags left behind by
+ * a destroyed factory are never picked up by another one.
+ * A thread has pending flags for very few caches at a time, a vector keeps its storage between
+ * operations so that the request path doesn't allocate
+ */
+namespace {
+thread_local std::vector<std::pair<uint64_t, uint32_t> > pendingFlags;
+std::atomic<uint64_t> nextFactoryId(1);
+
+std::vector<std::pair<uint64_t, uint32_t> >::iterator findPendingFlags(uint64_t id) {
+	std::vector<std::pair<uint64_t, uint32_t> >::iterator it = pendingFlags.begin();
+	while (it != pendingFlags.end() && it->first != id) {
+		++it;
+	}
+	return it;
+}
+}
+
 OperationsFactory::OperationsFactory(
 		std::shared_ptr<infinispan::hotrod::transport::TransportFactory> tf,
 		const std::string& cn, bool frv, infinispan::hotrod::protocol::Codec& c) :
-		transportFactory(tf), codec(c), forceReturnValue(frv), flags(), cacheNameBytes(
-				cn.begin(), cn.end()) {
+		transportFactory(tf), codec(c), forceReturnValue(frv), cacheNameBytes(
+				cn.begin(), cn.end()), id(nextFactoryId++) {
 	if (transportFactory) {
 		topologyId = transportFactory->createTopologyId(cacheNameBytes);
 	}
@@ -56,12 +80,18 @@ PingOperation* OperationsFactory::newPingOperation(Transport& transport,
 	return pingOperation;
 }
 
-GetOperation* OperationsFactory::newGetKeyOperation(
+GetOperation OperationsFactory::newGetKeyOperation(
 		const std::vector<char>& key, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::GetOperation* operation = new GetOperation(
+	return GetOperation(
 			codec, transportFactory, key, cacheNameBytes, topologyId,
 			getFlags(), df);
-	return operation;
+}
+
+GetIntoOperation OperationsFactory::newGetIntoOperation(
+		const std::vector<char>& key, std::vector<char>& value, EntryMediaTypes* df) {
+	return GetIntoOperation(
+			codec, transportFactory, key, cacheNameBytes, topologyId,
+			getFlags(), value, df);
 }
 
 GetAllOperation* OperationsFactory::newGetAllOperation(
@@ -72,83 +102,65 @@ GetAllOperation* OperationsFactory::newGetAllOperation(
 	return allOperation;
 }
 
-PutOperation* OperationsFactory::newPutKeyValueOperation(
+PutOperation OperationsFactory::newPutKeyValueOperation(
 		const std::vector<char>& key, const std::vector<char>& value,
 		uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::PutOperation* putOperation =
-			new PutOperation(codec, transportFactory, key, cacheNameBytes,
+	return PutOperation(codec, transportFactory, key, cacheNameBytes,
 					topologyId, getFlags(), value, lifespanSecs, maxIdleSecs, df);
-	return putOperation;
 }
 
-PutIfAbsentOperation* OperationsFactory::newPutIfAbsentOperation(
+PutIfAbsentOperation OperationsFactory::newPutIfAbsentOperation(
 		const std::vector<char>& key, const std::vector<char>& value,
 		uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::PutIfAbsentOperation* putIfAbsentOperation =
-			new PutIfAbsentOperation(codec, transportFactory, key,
+	return PutIfAbsentOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), value, lifespanSecs,
 					maxIdleSecs, df);
-	return putIfAbsentOperation;
 }
 
-ReplaceOperation* OperationsFactory::newReplaceOperation(
+ReplaceOperation OperationsFactory::newReplaceOperation(
 		const std::vector<char>& key, const std::vector<char>& value,
 		uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::ReplaceOperation* replaceOperation =
-			new ReplaceOperation(codec, transportFactory, key, cacheNameBytes,
+	return ReplaceOperation(codec, transportFactory, key, cacheNameBytes,
 					topologyId, getFlags(), value, lifespanSecs, maxIdleSecs, df);
-	return replaceOperation;
 }
 
-RemoveOperation* OperationsFactory::newRemoveOperation(
+RemoveOperation OperationsFactory::newRemoveOperation(
 		const std::vector<char>& key, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::RemoveOperation* removeOperation =
-			new RemoveOperation(codec, transportFactory, key, cacheNameBytes,
+	return RemoveOperation(codec, transportFactory, key, cacheNameBytes,
 					topologyId, getFlags(), df);
-	return removeOperation;
 }
 
-ContainsKeyOperation* OperationsFactory::newContainsKeyOperation(
+ContainsKeyOperation OperationsFactory::newContainsKeyOperation(
 		const std::vector<char>& key, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::ContainsKeyOperation* containsKeyOperation =
-			new ContainsKeyOperation(codec, transportFactory, key,
+	return ContainsKeyOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), df);
-	return containsKeyOperation;
 }
 
-ReplaceIfUnmodifiedOperation* OperationsFactory::newReplaceIfUnmodifiedOperation(
+ReplaceIfUnmodifiedOperation OperationsFactory::newReplaceIfUnmodifiedOperation(
 		const std::vector<char>& key, const std::vector<char>& value,
 		uint32_t lifespanSecs, uint32_t maxIdleSecs, int64_t version,
 		EntryMediaTypes* df) {
-	infinispan::hotrod::operations::ReplaceIfUnmodifiedOperation* replaceIfUnmodifiedOperation =
-			new ReplaceIfUnmodifiedOperation(codec, transportFactory, key,
+	return ReplaceIfUnmodifiedOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), value, lifespanSecs,
 					maxIdleSecs, version, df);
-	return replaceIfUnmodifiedOperation;
 }
 
-RemoveIfUnmodifiedOperation* OperationsFactory::newRemoveIfUnmodifiedOperation(
+RemoveIfUnmodifiedOperation OperationsFactory::newRemoveIfUnmodifiedOperation(
 		const std::vector<char>& key, int64_t version, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::RemoveIfUnmodifiedOperation* removeIfUnmodifiedOperation =
-			new RemoveIfUnmodifiedOperation(codec, transportFactory, key,
+	return RemoveIfUnmodifiedOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), version, df);
-	return removeIfUnmodifiedOperation;
 }
 
-GetWithMetadataOperation* OperationsFactory::newGetWithMetadataOperation(
+GetWithMetadataOperation OperationsFactory::newGetWithMetadataOperation(
 		const std::vector<char>& key, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::GetWithMetadataOperation* withMetadataOperation =
-			new GetWithMetadataOperation(codec, transportFactory, key,
+	return GetWithMetadataOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), df);
-	return withMetadataOperation;
 }
 
-GetWithVersionOperation* OperationsFactory::newGetWithVersionOperation(
+GetWithVersionOperation OperationsFactory::newGetWithVersionOperation(
 		const std::vector<char>& key, EntryMediaTypes* df) {
-	infinispan::hotrod::operations::GetWithVersionOperation* withVersionOperation =
-			new GetWithVersionOperation(codec, transportFactory, key,
+	return GetWithVersionOperation(codec, transportFactory, key,
 					cacheNameBytes, topologyId, getFlags(), df);
-	return withVersionOperation;
 }
 
 BulkGetOperation* OperationsFactory::newBulkGetOperation(int size,
@@ -224,11 +236,20 @@ QueryOperation* OperationsFactory::newQueryOperation(const QueryRequest& qr,
 }
 
 uint32_t OperationsFactory::getFlags() {
-	uint32_t result = flags;
+	uint32_t result = takeFlags();
 	if (forceReturnValue) {
 		result |= FORCE_RETURN_VALUE;
 	}
-	flags = 0;
+	return result;
+}
+
+uint32_t OperationsFactory::takeFlags() {
+	std::vector<std::pair<uint64_t, uint32_t> >::iterator it = findPendingFlags(id);
+	if (it == pendingFlags.end()) {
+		return 0;
+	}
+	uint32_t result = it->second;
+	pendingFlags.erase(it);
 	return result;
 }
 AddClientListenerOperation* OperationsFactory::newAddClientListenerOperation(
@@ -255,10 +276,10 @@ RemoveClientListenerOperation* OperationsFactory::newRemoveClientListenerOperati
 }
 
 PrepareCommitOperation* OperationsFactory::newPrepareCommitOperation(XID xid,
-		TransactionContext& tctx, EntryMediaTypes* df) {
+		TransactionContext& tctx, bool onePhaseCommit, EntryMediaTypes* df) {
 	infinispan::hotrod::operations::PrepareCommitOperation* prepareCommitOperation =
 			new PrepareCommitOperation(codec, transportFactory, cacheNameBytes,
-					topologyId, getFlags(), xid, tctx, df);
+					topologyId, getFlags(), xid, tctx, onePhaseCommit, df);
 	return prepareCommitOperation;
 }
 
@@ -279,11 +300,17 @@ RollbackOperation* OperationsFactory::newRollbackOperation(XID xid,
 }
 
 void OperationsFactory::addFlags(uint32_t f) {
-	flags |= f;
+	setFlags(takeFlags() | f);
 }
 
 void OperationsFactory::setFlags(uint32_t f) {
-	flags = f;
+	std::vector<std::pair<uint64_t, uint32_t> >::iterator it = findPendingFlags(id);
+	if (it != pendingFlags.end()) {
+		pendingFlags.erase(it);
+	}
+	if (f) {
+		pendingFlags.push_back(std::make_pair(id, f));
+	}
 }
 
 AdminOperation* OperationsFactory::newAdminOperation(
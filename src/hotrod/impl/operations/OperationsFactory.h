@@ -39,6 +39,7 @@ namespace operations {
 
 class PingOperation;
 class GetOperation;
+class GetIntoOperation;
 class GetAllOperation;
 class PutOperation;
 class PutIfAbsentOperation;
@@ -69,39 +70,52 @@ class RollbackOperation;
 class OperationsFactory
 {
   public:
+    /*
+     * Created by RemoteCacheManagerImpl for each cache. Without a transport factory
+     * the operations can only be run on a given transport
+     */
+    OperationsFactory(
+      std::shared_ptr<infinispan::hotrod::transport::TransportFactory> transportFactory,
+      const std::string& cacheName, bool forceReturnValue, infinispan::hotrod::protocol::Codec& codec);
 
     PingOperation* newPingOperation(
       infinispan::hotrod::transport::Transport& transport, EntryMediaTypes* df);
 
-    GetOperation* newGetKeyOperation(const std::vector<char>& key, EntryMediaTypes* df);
+    /*
+     * Operations on the key/value request path are returned by value so that
+     * callers can keep them on the stack
+     */
+    GetOperation newGetKeyOperation(const std::vector<char>& key, EntryMediaTypes* df);
+
+    GetIntoOperation newGetIntoOperation(const std::vector<char>& key, std::vector<char>& value, EntryMediaTypes* df);
 
     GetAllOperation* newGetAllOperation(const std::set<std::vector<char>>& keySet, EntryMediaTypes* df);
 
-    PutOperation* newPutKeyValueOperation(
+    PutOperation newPutKeyValueOperation(
       const std::vector<char>& key, const std::vector<char>& value,
       uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df);
 
-    PutIfAbsentOperation* newPutIfAbsentOperation(
+    PutIfAbsentOperation newPutIfAbsentOperation(
       const std::vector<char>& key, const std::vector<char>& value,
       uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df);
 
-    ReplaceOperation* newReplaceOperation(
+    ReplaceOperation newReplaceOperation(
       const std::vector<char>& key, const std::vector<char>& value,
       uint32_t lifespanSecs, uint32_t maxIdleSecs, EntryMediaTypes* df);
 
-    RemoveOperation* newRemoveOperation(const std::vector<char>& key, EntryMediaTypes* df);
+    RemoveOperation newRemoveOperation(const std::vector<char>& key, EntryMediaTypes* df);
 
-    ContainsKeyOperation* newContainsKeyOperation(const std::vector<char>& key, EntryMediaTypes* df);
+    ContainsKeyOperation newContainsKeyOperation(const std::vector<char>& key, EntryMediaTypes* df);
 
-    ReplaceIfUnmodifiedOperation* newReplaceIfUnmodifiedOperation(
+    ReplaceIfUnmodifiedOperation newReplaceIfUnmodifiedOperation(
       const std::vector<char>& key, const std::vector<char>& value,
       uint32_t lifespanSecs, uint32_t maxIdleSecs, int64_t version, EntryMediaTypes* df);
 
-    RemoveIfUnmodifiedOperation* newRemoveIfUnmodifiedOperation(const std::vector<char>& key, int64_t version, EntryMediaTypes* df);
+    RemoveIfUnmodifiedOperation newRemoveIfUnmodifiedOperation(const std::vector<char>& key, int64_t version, EntryMediaTypes* df);
 
-    GetWithMetadataOperation* newGetWithMetadataOperation(const std::vector<char>& key, EntryMediaTypes* df);
+    GetWithMetadataOperation newGetWithMetadataOperation(const std::vector<char>& key, EntryMediaTypes* df);
 
-    GetWithVersionOperation* newGetWithVersionOperation(const std::vector<char>& key, EntryMediaTypes* df);
+    GetWithVersionOperation newGetWithVersionOperation(const std::vector<char>& key, EntryMediaTypes* df);
 
     BulkGetOperation* newBulkGetOperation(int size, EntryMediaTypes* df);
 
@@ -126,12 +140,15 @@ class OperationsFactory
     AddClientListenerOperation* newAddClientListenerOperation(ClientListener& listener, ClientListenerNotifier& listenerNotifier, const std::vector<std::vector<char> > filterFactoryParam, const std::vector<std::vector<char> > converterFactoryParams,const std::function<void()> &recoveryCallback, EntryMediaTypes* df);
     RemoveClientListenerOperation* newRemoveClientListenerOperation(ClientListener& listener, ClientListenerNotifier& listenerNotifier, EntryMediaTypes* df);
 
-    PrepareCommitOperation* newPrepareCommitOperation(XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+    PrepareCommitOperation* newPrepareCommitOperation(XID xid, TransactionContext& tctx, bool onePhaseCommit, EntryMediaTypes* df);
     CommitOperation* newCommitOperation(XID xid, TransactionContext& tctx, EntryMediaTypes* df);
     RollbackOperation* newRollbackOperation(XID xid, TransactionContext& tctx, EntryMediaTypes* df);
 
+    // Flags for the next operation created by the calling thread
     void addFlags(uint32_t flags);
     void setFlags(uint32_t flags);
+    // Returns and clears the calling thread's flags
+    uint32_t takeFlags();
 
     AdminOperation* newAdminOperation(
         const std::vector<char>& cmdName, const std::map<std::vector<char>,std::vector<char>>& values);
@@ -139,6 +156,7 @@ class OperationsFactory
     CacheTopologyInfo getCacheTopologyInfo();
 
     std::shared_ptr<infinispan::hotrod::transport::TransportFactory> getTransportFactory() { return transportFactory; }
+    const infinispan::hotrod::protocol::Codec& getCodec() { return codec; }
 
 
     virtual ~OperationsFactory() { }
@@ -149,16 +167,12 @@ private:
     std::shared_ptr<infinispan::hotrod::protocol::Codec> codecPtr;
     const infinispan::hotrod::protocol::Codec& codec;
     bool forceReturnValue;
-    uint32_t flags;
     std::vector<char> cacheNameBytes;
+    // Identifies the factory in the flags of the threads, see takeFlags()
+    const uint64_t id;
 
     uint32_t getFlags();
 
-    OperationsFactory(
-      std::shared_ptr<infinispan::hotrod::transport::TransportFactory> transportFactory,
-      const std::string& cacheName, bool forceReturnValue, infinispan::hotrod::protocol::Codec& codec);
-
-  friend class infinispan::hotrod::RemoteCacheManagerImpl;
 };
 
 }}} // namespace infinispan::hotrod::operations
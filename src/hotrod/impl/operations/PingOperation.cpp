@@ -17,14 +17,14 @@ PingOperation::PingOperation(const Codec& c, Topology& id,
 
 PingOperation::PingOperation(const Codec& c, Topology& id,
 		Transport& t, EntryMediaTypes* df)
-    : HotRodOperation<PingResult>(c, 0, std::vector<char>(), id, df), transport(t)
+    : HotRodOperation<PingResult>(c, 0, protocol::HeaderParams::noCacheName(), id, df), transport(t)
 {}
 
 PingResult PingOperation::execute() {
-	std::unique_ptr<infinispan::hotrod::protocol::HeaderParams> params(writeHeader(transport, HotRodConstants::PING_REQUEST));
+	protocol::HeaderParams params = writeHeader(transport, HotRodConstants::PING_REQUEST);
 	transport.flush();
 
-    uint8_t respStatus = readHeaderAndValidate(transport, *params);
+    uint8_t respStatus = readHeaderAndValidate(transport, params);
     if (HotRodConstants::isSuccess(respStatus)) {
     	TRACE("Ping successful!");
     	if (HotRodConstants::hasCompatibility(respStatus)) {
@@ -40,6 +40,7 @@ class PingOperation : public HotRodOperation<PingResult>
         transport::Transport& transport,
         const std::vector<char>& cacheName,
 		EntryMediaTypes* df);
+    PingOperation(const protocol::Codec&, Topology&, transport::Transport&, std::vector<char>&&, EntryMediaTypes*) = delete;
 
     transport::Transport& transport;
 
@@ -0,0 +1,91 @@
+#include "hotrod/impl/operations/Pipeline.h"
+#include "hotrod/impl/transport/tcp/TcpTransport.h"
+#include "hotrod/sys/Log.h"
+
+#include <map>
+
+namespace infinispan {
+namespace hotrod {
+namespace operations {
+
+using namespace infinispan::hotrod::transport;
+
+const size_t Pipeline::MAX_BATCH;
+
+void Pipeline::add(Transport& transport, const std::vector<PipelinedRequest*>& requests) {
+    Batch batch;
+    batch.transport = &transport;
+    batch.requests = requests;
+    batch.answered.assign(requests.size(), false);
+    batch.timer = std::make_shared<RequestTimer>(transportFactory);
+    batch.failed = false;
+    batches.push_back(batch);
+}
+
+void Pipeline::run() {
+    // Everything is on the wire before the first response is awaited
+    for (auto& batch : batches) {
+        write(batch);
+    }
+    for (auto& batch : batches) {
+        if (!batch.failed) {
+            read(batch);
+        }
+    }
+    for (auto& batch : batches) {
+        batch.timer->stop(batch.failed);
+        if (batch.failed) {
+            // The address dies with the transport
+            InetSocketAddress address = dynamic_cast<TcpTransport&>(*batch.transport).getServerAddress();
+            transportFactory.invalidateTransport(address, batch.transport);
+        } else {
+            transportFactory.releaseTransport(*batch.transport);
+        }
+    }
+    for (auto& batch : batches) {
+        for (size_t i = 0; i < batch.requests.size(); i++) {
+            if (!batch.answered[i]) {
+                batch.requests[i]->executeAlone();
+            }
+        }
+    }
+    batches.clear();
+}
+
+void Pipeline::write(Batch& batch) {
+    batch.timer->start(*batch.transport);
+    try {
+        for (auto request : batch.requests) {
+            batch.messageIds.push_back(request->writeRequest(*batch.transport));
+        }
+        batch.transport->flush();
+    } catch (const HotRodClientException& ex) {
+        WARN("Pipelined write failed: %s", ex.what());
+        batch.failed = true;
+    }
+}
+
+void Pipeline::read(Batch& batch) {
+    std::map<uint64_t, size_t> pending;
+    for (size_t i = 0; i < batch.messageIds.size(); i++) {
+        pending[batch.messageIds[i]] = i;
+    }
+    try {
+        while (!pending.empty()) {
+            uint64_t messageId = codec.readMessageId(*batch.transport);
+            std::map<uint64_t, size_t>::iterator it = pending.find(messageId);
+            if (it == pending.end()) {
+                throw InvalidResponseException("Unexpected message id in pipelined response: "
+                        + std::to_string(messageId));
+            }
+            size_t i = it->second;
+            pending.erase(it);
+            batch.answered[i] = batch.requests[i]->readResponse(*batch.transport, messageId);
+        }
+    } catch (const HotRodClientException& ex) {
+        WARN("Pipelined read failed: %s", ex.what());
+        batch.failed = true;
+    }
+}
+
+}}} // namespace infinispan::hotrod::operations
@@ -0,0 +1,138 @@
+#ifndef ISPN_HOTROD_OPERATIONS_PIPELINE_H
+#define ISPN_HOTROD_OPERATIONS_PIPELINE_H
+
+#include "hotrod/impl/protocol/Codec.h"
+#include "hotrod/impl/protocol/HeaderParams.h"
+#include "hotrod/impl/transport/Transport.h"
+#include "hotrod/impl/transport/TransportFactory.h"
+#include "infinispan/hotrod/exceptions.h"
+
+#include <exception>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace infinispan {
+namespace hotrod {
+namespace operations {
+
+/*
+ * A request of a Pipeline, its result is delivered to whoever waits for it
+ */
+class PipelinedRequest
+{
+  public:
+    virtual ~PipelinedRequest() {}
+
+    // Writes the request without flushing, returns its message id
+    virtual uint64_t writeRequest(transport::Transport& transport) = 0;
+
+    // Reads the response whose message id has been read. Only a failure of the connection is thrown,
+    // false for a failure that the operation retries
+    virtual bool readResponse(transport::Transport& transport, uint64_t messageId) = 0;
+
+    // Runs the operation on its own, with its retries, when the pipeline couldn't answer it
+    virtual void executeAlone() = 0;
+};
+
+/*
+ * Pipelines an operation with writeRequest() and readResponse() halves. The result, or the failure,
+ * is delivered to the future
+ */
+template<class Op, class T> class PipelinedOperation : public PipelinedRequest
+{
+  public:
+    template<class... Args> explicit PipelinedOperation(Args&&... args) : op(std::forward<Args>(args)...) {
+    }
+
+    std::future<T> getFuture() {
+        return result.get_future();
+    }
+
+    uint64_t writeRequest(transport::Transport& transport) {
+        params.reset(new protocol::HeaderParams(op.writeRequest(transport)));
+        return params->getMessageId();
+    }
+
+    bool readResponse(transport::Transport& transport, uint64_t messageId) {
+        T value;
+        try {
+            value = op.readResponse(transport, *params, messageId);
+        } catch (const TransportException&) {
+            throw;
+        } catch (const InvalidResponseException&) {
+            throw;
+        } catch (const HotRodClientException&) {
+            // The response has been read, the connection is still usable
+            return false;
+        } catch (...) {
+            result.set_exception(std::current_exception());
+            return true;
+        }
+        result.set_value(value);
+        return true;
+    }
+
+    void executeAlone() {
+        T value;
+        try {
+            value = op.execute();
+        } catch (...) {
+            result.set_exception(std::current_exception());
+            return;
+        }
+        result.set_value(value);
+    }
+
+  private:
+    Op op;
+    std::unique_ptr<protocol::HeaderParams> params;
+    std::promise<T> result;
+};
+
+/*
+ * Runs batches of requests, one batch per connection. The requests of all the batches are written
+ * first, then the responses are read and matched to their request by message id, as the server may
+ * answer them in any order. All the batches together cost a single round trip.
+ *
+ * A connection that fails is invalidated, the others are released. The requests without a response,
+ * or with a failure that their operation retries, then run alone.
+ */
+class Pipeline
+{
+  public:
+    // Keeps the requests and the responses in flight within the socket buffers, so that the server
+    // never waits for the client to read while the client is still writing
+    static const size_t MAX_BATCH = 128;
+
+    Pipeline(transport::TransportFactory& transportFactory, const protocol::Codec& codec) :
+        transportFactory(transportFactory), codec(codec) {
+    }
+
+    // Adds a batch of at most MAX_BATCH requests, run() owns the transport from now on
+    void add(transport::Transport& transport, const std::vector<PipelinedRequest*>& requests);
+
+    void run();
+
+  private:
+    struct Batch {
+        transport::Transport* transport;
+        std::vector<PipelinedRequest*> requests;
+        std::vector<uint64_t> messageIds;
+        std::vector<bool> answered;
+        std::shared_ptr<transport::RequestTimer> timer;
+        bool failed;
+    };
+
+    void write(Batch& batch);
+    void read(Batch& batch);
+
+    transport::TransportFactory& transportFactory;
+    const protocol::Codec& codec;
+    std::vector<Batch> batches;
+};
+
+}}} // namespace infinispan::hotrod::operations
+
+#endif  // ISPN_HOTROD_OPERATIONS_PIPELINE_H
@@ -18,19 +18,22 @@ namespace operations {
 using namespace org::infinispan::query::remote::client;
 using namespace infinispan::hotrod::operations;
 
-class QueryOperation : public RetryOnFailureOperation<QueryResponse>{
+/*
+ * Returns the marshalled QueryResponse, so the caller decides where it's parsed
+ */
+class QueryOperation : public RetryOnFailureOperation<std::vector<char> >{
 public:
 	QueryOperation(const protocol::Codec& _codec,
 			std::shared_ptr<transport::TransportFactory> _transportFactory,
 			const std::vector<char>& _cacheName, Topology& _topologyId,
 			uint32_t _flags, const QueryRequest& _queryRequest, EntryMediaTypes* df) :
-			RetryOnFailureOperation<QueryResponse>(_codec, _transportFactory,
+			RetryOnFailureOperation<std::vector<char> >(_codec, _transportFactory,
 					_cacheName, _topologyId, _flags, df), queryRequest(
 					_queryRequest) {}
 	virtual ~QueryOperation();
 
-	QueryResponse executeOperation(transport::Transport &t) {
-        std::unique_ptr<protocol::HeaderParams> params((this->writeHeader(t, QUERY_REQUEST)));
+	std::vector<char> executeOperation(transport::Transport &t) {
+        protocol::HeaderParams params = this->writeHeader(t, QUERY_REQUEST);
 
     int size = queryRequest.ByteSize();
     std::vector<char> queryToChar(size);
@@ -38,17 +41,16 @@ public:
     queryRequest.SerializeToArray(queryToChar.data(),size);
     t.writeArray(queryToChar);
     t.flush();
-    //int8_t status= codec.readHeader(t,*params);
+    //int8_t status= codec.readHeader(t,params);
 
 
-    int8_t status=readHeaderAndValidate(t, *params);
+    int8_t status=readHeaderAndValidate(t, params);
 
-    QueryResponse qr;
+    std::vector<char> responseBytes;
     if (HotRodConstants::isSuccess(status)) {
-			std::vector<char> responseBytes = t.readArray();
-			qr.ParseFromArray(responseBytes.data(), (int)responseBytes.size());
+			responseBytes = t.readArray();
 		}
-	return qr;
+	return responseBytes;
  }
 
 private:
@@ -26,14 +26,13 @@ transport::Transport& RemoveClientListenerOperation::getTransport(int /*retryCou
 
 char RemoveClientListenerOperation::executeOperation(transport::Transport& transport)
 {
-    std::unique_ptr<HeaderParams> params(this->writeHeader(transport, REMOVE_CLIENT_LISTENER_REQUEST));
+    HeaderParams params = this->writeHeader(transport, REMOVE_CLIENT_LISTENER_REQUEST);
     transport.writeArray(clientListener.getListenerId());
     transport.flush();
-    uint8_t status = readHeaderAndValidate(transport, *params);
+    uint8_t status = readHeaderAndValidate(transport, params);
     if (HotRodConstants::isSuccess(status))
     {
-      listenerNotifier.releaseTransport(clientListener.getListenerId());
-      listenerNotifier.removeClientListener(clientListener.getListenerId());
+      listenerNotifier.releaseClientListener(clientListener.getListenerId());
     }
     return status;
 }
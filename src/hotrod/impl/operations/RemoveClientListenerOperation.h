@@ -17,10 +17,12 @@ namespace operations {
 class RemoveClientListenerOperation: public RetryOnFailureOperation<char> {
 public:
 	RemoveClientListenerOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-                             std::vector<char> cacheName, Topology& topologyId, int flags,
+                             const std::vector<char>& cacheName, Topology& topologyId, int flags,
                              ClientListenerNotifier &listenerNotifier, const ClientListener& clientListener, EntryMediaTypes* df)
                            : RetryOnFailureOperation<char>(codec, transportFactory, cacheName, topologyId, flags, df), listenerNotifier(listenerNotifier), clientListener(clientListener)
 							 {};
+	RemoveClientListenerOperation(const Codec&, std::shared_ptr<TransportFactory>, std::vector<char>&&, Topology&, int,
+	                         ClientListenerNotifier&, const ClientListener&, EntryMediaTypes*) = delete;
     virtual void releaseTransport(transport::Transport* transport);
     virtual transport::Transport& getTransport(int retryCount, const std::set<transport::InetSocketAddress>& failedServers);
 	virtual char executeOperation(transport::Transport& transport);
@@ -26,14 +26,14 @@ VersionedOperationResponse RemoveIfUnmodifiedOperation::executeOperation(Transpo
     TRACE("Execute RemoteIfUnmodified(flags=%u, version=%lld)", flags, version);
     TRACEBYTES("key = ", key);
     // 1) write header
-    std::unique_ptr<HeaderParams> params(AbstractKeyOperation<VersionedOperationResponse>::writeHeader(transport, REMOVE_IF_UNMODIFIED_REQUEST));
+    HeaderParams params = AbstractKeyOperation<VersionedOperationResponse>::writeHeader(transport, REMOVE_IF_UNMODIFIED_REQUEST);
 
     //2) write message body
     transport.writeArray(key);
     transport.writeLong(version);
     transport.flush();
 
-    return AbstractKeyOperation<VersionedOperationResponse>::returnVersionedOperationResponse(transport, *params);
+    return AbstractKeyOperation<VersionedOperationResponse>::returnVersionedOperationResponse(transport, params);
 
 }
 
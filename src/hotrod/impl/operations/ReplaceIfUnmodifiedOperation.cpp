@@ -24,7 +24,7 @@ VersionedOperationResponse ReplaceIfUnmodifiedOperation::executeOperation(
     TRACEBYTES("key = ", key);
     TRACEBYTES("value = ", value);
     // 1) write header
-    std::unique_ptr<HeaderParams> params(AbstractKeyOperation<VersionedOperationResponse>::writeHeader(transport, REPLACE_IF_UNMODIFIED_REQUEST));
+    HeaderParams params = AbstractKeyOperation<VersionedOperationResponse>::writeHeader(transport, REPLACE_IF_UNMODIFIED_REQUEST);
 
     //2) write message body
     transport.writeArray(key);
@@ -33,7 +33,7 @@ VersionedOperationResponse ReplaceIfUnmodifiedOperation::executeOperation(
     transport.writeArray(value);
     transport.flush();
 
-    return AbstractKeyValueOperation<VersionedOperationResponse>::returnVersionedOperationResponse(transport, *params);
+    return AbstractKeyValueOperation<VersionedOperationResponse>::returnVersionedOperationResponse(transport, params);
 }
 
 
@@ -20,10 +20,13 @@ template<class T> class RetryOnFailureOperation : public HotRodOperation<T>
         std::set<transport::InetSocketAddress> failedServers;
         while (shouldRetry(retryCount)) {
             transport::Transport* transport = NULL;
+            transport::RequestTimer timer(*transportFactory);
             try {
                 // Transport retrieval should be retried
                 transport = &getTransport(retryCount, failedServers);
+                timer.start(*transport);
                 const T& result = executeOperation(*transport);
+                timer.stop(false);
                 releaseTransport(transport);
                 return result;
             } catch (const TransportException& te) {
@@ -31,6 +34,7 @@ template<class T> class RetryOnFailureOperation : public HotRodOperation<T>
                 // instance is no longer usable and should be destroyed
             	transport::InetSocketAddress isa(te.getHostCString(),te.getPort());
             	failedServers.insert(isa);
+                timer.stop(true);
                 invalidateTransport(isa, transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, te);
             } catch (const RemoteNodeSuspectException& rnse) {
@@ -38,15 +42,19 @@ template<class T> class RetryOnFailureOperation : public HotRodOperation<T>
                 // as a result of a server finding out that another node has
                 // been suspected, so there's nothing really wrong with the server
                 // from which this node was received
+                timer.stop(false);
                 releaseTransport(transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, rnse);
             } catch (const HotRodClientException& hrex) {
+                timer.stop(false);
                 releaseTransport(transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, hrex);
             } catch (const CounterUpperBoundException& ex) {
+                timer.stop(false);
                 releaseTransport(transport);
                 throw;
             } catch (const CounterLowerBoundException& ex) {
+                timer.stop(false);
                 releaseTransport(transport);
                 throw;
             }
@@ -62,6 +70,8 @@ template<class T> class RetryOnFailureOperation : public HotRodOperation<T>
         const std::vector<char>& _cacheName, Topology& _topologyId, uint32_t _flags, EntryMediaTypes* df) :
             HotRodOperation<T>(_codec, _flags, _cacheName, _topologyId, df),
             transportFactory(_transportFactory) {}
+    RetryOnFailureOperation(const protocol::Codec&, std::shared_ptr<transport::TransportFactory>,
+        std::vector<char>&&, Topology&, uint32_t, EntryMediaTypes*) = delete;
 
     bool shouldRetry(int retryCount) {
        return retryCount <= transportFactory->getMaxRetries();
@@ -116,10 +126,13 @@ template<> class RetryOnFailureOperation<void> : public HotRodOperation<void>
         int retryCount = 0;
         while (shouldRetry(retryCount)) {
             transport::Transport* transport = NULL;
+            transport::RequestTimer timer(*transportFactory);
             try {
                 // Transport retrieval should be retried
                 transport = &getTransport(retryCount, transportFactory->getFailedServers());
+                timer.start(*transport);
                 executeOperation(*transport);
+                timer.stop(false);
                 releaseTransport(transport);
                 return;
             } catch (const TransportException& te) {
@@ -127,6 +140,7 @@ template<> class RetryOnFailureOperation<void> : public HotRodOperation<void>
                 // instance is no longer usable and should be destroyed
                 transport::InetSocketAddress isa(te.getHostCString(),te.getPort());
                 transportFactory->addFailedServer(isa);
+                timer.stop(true);
                 invalidateTransport(isa, transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, te);
             } catch (const RemoteNodeSuspectException& rnse) {
@@ -134,9 +148,11 @@ template<> class RetryOnFailureOperation<void> : public HotRodOperation<void>
                 // as a result of a server finding out that another node has
                 // been suspected, so there's nothing really wrong with the server
                 // from which this node was received
+                timer.stop(false);
                 releaseTransport(transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, rnse);
             } catch (const HotRodClientException& hrex) {
+                timer.stop(false);
                 releaseTransport(transport);
                 logErrorAndThrowExceptionIfNeeded(retryCount, hrex);
             }
@@ -152,6 +168,8 @@ template<> class RetryOnFailureOperation<void> : public HotRodOperation<void>
         const std::vector<char>& _cacheName, Topology& _topologyId, uint32_t _flags, EntryMediaTypes* df) :
             HotRodOperation<void>(_codec, _flags, _cacheName, _topologyId, df),
             transportFactory(_transportFactory) {}
+    RetryOnFailureOperation(const protocol::Codec&, std::shared_ptr<transport::TransportFactory>,
+        std::vector<char>&&, Topology&, uint32_t, EntryMediaTypes*) = delete;
 
     bool shouldRetry(int retryCount) {
        return retryCount <= transportFactory->getMaxRetries();
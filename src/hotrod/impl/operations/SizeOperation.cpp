@@ -21,9 +21,9 @@ SizeOperation::SizeOperation(
 uint64_t SizeOperation::executeOperation(infinispan::hotrod::transport::Transport& transport)
 {
     TRACE("Executing size(flags=%u)", flags);
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<uint64_t>::writeHeader(transport, SIZE_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<uint64_t>::writeHeader(transport, SIZE_REQUEST);
     transport.flush();
-    RetryOnFailureOperation<uint64_t>::readHeaderAndValidate(transport, *params);
+    RetryOnFailureOperation<uint64_t>::readHeaderAndValidate(transport, params);
     TRACE("Finished Size");
     return transport.readVInt();
 }
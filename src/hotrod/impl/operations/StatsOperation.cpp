@@ -21,9 +21,9 @@ StatsOperation::StatsOperation(
 std::map<std::string, std::string> StatsOperation::executeOperation(Transport& transport)
 {
     TRACE("Executing Stats");
-    std::unique_ptr<HeaderParams> params(RetryOnFailureOperation<std::map<std::string, std::string> >::writeHeader(transport, STATS_REQUEST));
+    HeaderParams params = RetryOnFailureOperation<std::map<std::string, std::string> >::writeHeader(transport, STATS_REQUEST);
     transport.flush();
-    RetryOnFailureOperation<std::map<std::string, std::string> >::readHeaderAndValidate(transport, *params);
+    RetryOnFailureOperation<std::map<std::string, std::string> >::readHeaderAndValidate(transport, params);
 
     int nrOfStats = transport.readVInt();
     TRACE("Stats returning map of %d entries:", nrOfStats);
@@ -16,15 +16,16 @@ namespace operations {
 static void writeXID(transport::Transport& transport, XID& xid);
 
 PrepareCommitOperation::PrepareCommitOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-        std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df) :
-        RetryOnFailureOperation<uint32_t>(codec, transportFactory, cacheName, topologyId, flags, df), xid(xid), tctx(tctx) {
+        const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx,
+        bool onePhaseCommit, EntryMediaTypes* df) :
+        RetryOnFailureOperation<uint32_t>(codec, transportFactory, cacheName, topologyId, flags, df), xid(xid), tctx(tctx), onePhaseCommit(onePhaseCommit) {
 
 }
 
 uint32_t PrepareCommitOperation::executeOperation(transport::Transport& transport) {
-    std::unique_ptr<HeaderParams> params(this->writeHeader(transport, PREPARE_REQUEST));
+    HeaderParams params = this->writeHeader(transport, PREPARE_REQUEST);
     writeXID(transport, this->xid);
-    transport.writeByte(0); // One phase commit on XA transaction not implemented here
+    transport.writeByte(onePhaseCommit ? 1 : 0);
     transport.writeVInt(tctx.size());
     for ( auto & it : tctx.context) {
         transport.writeArray(it.first);
@@ -41,45 +42,43 @@ uint32_t PrepareCommitOperation::executeOperation(transport::Transport& transpor
             if (it.second.meta.maxIdle > 0) {
                 transport.writeVLong(it.second.meta.maxIdle);
             }
-            std::vector<char> marshalledVal;
-            it.second.valueMarshaller(it.second.value, marshalledVal);
-            transport.writeArray(marshalledVal);
+            transport.writeArray(it.second.marshalledValue);
         }
     }
     transport.flush();
-    this->readHeaderAndValidate(transport, *params);
+    this->readHeaderAndValidate(transport, params);
     // TODO: check for error
     uint32_t xa_retcode = transport.read4ByteInt();
     return xa_retcode;
 }
 
 CommitOperation::CommitOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-        std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df) :
+        const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df) :
         RetryOnFailureOperation<uint32_t>(codec, transportFactory, cacheName, topologyId, flags, df), xid(xid), tctx(tctx) {
 
 }
 
 uint32_t CommitOperation::executeOperation(transport::Transport& transport) {
-    std::unique_ptr<HeaderParams> params(this->writeHeader(transport, COMMIT_REQUEST));
+    HeaderParams params = this->writeHeader(transport, COMMIT_REQUEST);
     writeXID(transport, this->xid);
     transport.flush();
-    this->readHeaderAndValidate(transport, *params);
+    this->readHeaderAndValidate(transport, params);
     // TODO: check for error
     uint32_t xa_retcode = transport.read4ByteInt();
     return xa_retcode;
 }
 
 RollbackOperation::RollbackOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-        std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df) :
+        const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df) :
         RetryOnFailureOperation<uint32_t>(codec, transportFactory, cacheName, topologyId, flags, df), xid(xid), tctx(tctx) {
 
 }
 
 uint32_t RollbackOperation::executeOperation(transport::Transport& transport) {
-    std::unique_ptr<HeaderParams> params(this->writeHeader(transport, ROLLBACK_REQUEST));
+    HeaderParams params = this->writeHeader(transport, ROLLBACK_REQUEST);
     writeXID(transport, this->xid);
     transport.flush();
-    this->readHeaderAndValidate(transport, *params);
+    this->readHeaderAndValidate(transport, params);
     // TODO: check for error
     transport.read4ByteInt();
     return 0;
@@ -24,19 +24,25 @@ namespace operations {
 class PrepareCommitOperation: public RetryOnFailureOperation<uint32_t> {
 public:
     PrepareCommitOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-            std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+            const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx,
+            bool onePhaseCommit, EntryMediaTypes* df);
+    PrepareCommitOperation(const Codec&, std::shared_ptr<TransportFactory>, std::vector<char>&&, Topology&, int, XID,
+            TransactionContext&, bool, EntryMediaTypes*) = delete;
     uint32_t executeOperation(transport::Transport& transport);
 
 private:
     XID xid;
     TransactionContext& tctx;
+    bool onePhaseCommit;
     friend class OperationsFactory;
 };
 
 class CommitOperation: public RetryOnFailureOperation<uint32_t> {
 public:
     CommitOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-            std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+            const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+    CommitOperation(const Codec&, std::shared_ptr<TransportFactory>, std::vector<char>&&, Topology&, int, XID,
+            TransactionContext&, EntryMediaTypes*) = delete;
     uint32_t executeOperation(transport::Transport& transport);
 
 private:
@@ -48,7 +54,9 @@ private:
 class RollbackOperation: public RetryOnFailureOperation<uint32_t> {
 public:
     RollbackOperation(const Codec &codec, std::shared_ptr<TransportFactory> transportFactory,
-            std::vector<char> cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+            const std::vector<char>& cacheName, Topology& topologyId, int flags, XID xid, TransactionContext& tctx, EntryMediaTypes* df);
+    RollbackOperation(const Codec&, std::shared_ptr<TransportFactory>, std::vector<char>&&, Topology&, int, XID,
+            TransactionContext&, EntryMediaTypes*) = delete;
     uint32_t executeOperation(transport::Transport& transport);
 
 private:
@@ -29,6 +29,13 @@ class Codec
     virtual uint8_t readHeader(
       transport::Transport& transport, HeaderParams& params) const = 0;
 
+    /** Reads the magic and the message id opening a response, to match it to its request */
+    virtual uint64_t readMessageId(transport::Transport& transport) const = 0;
+
+    /** The rest of readHeader(), once readMessageId() has been called */
+    virtual uint8_t readHeaderAfterMessageId(
+      transport::Transport& transport, HeaderParams& params, uint64_t receivedMessageId) const = 0;
+
     virtual std::vector<char> returnPossiblePrevValue(transport::Transport& t, uint8_t status, uint32_t flags) const = 0;
     virtual void writeExpirationParams(transport::Transport& t,uint64_t lifespan, uint64_t maxIdle) const = 0;
     virtual ~Codec() {}
@@ -47,7 +47,7 @@ HeaderParams& Codec20::writeHeader(
     ScopedUnlock<Mutex> ul(lock);
     transport.writeByte(protocolVersion);
     transport.writeByte(params.opCode);
-    transport.writeArray(params.cacheName);
+    transport.writeArray(*params.cacheName);
     transport.writeVInt(params.flags);
     transport.writeByte(params.clientIntel);
     transport.writeVInt(params.topologyId.getId());
@@ -86,6 +86,11 @@ EventHeaderParams Codec20::readEventHeader(Transport& transport) const
 
 uint8_t Codec20::readHeader(
     Transport& transport, HeaderParams& params) const
+{
+    return readHeaderAfterMessageId(transport, params, readMessageId(transport));
+}
+
+uint64_t Codec20::readMessageId(Transport& transport) const
 {
     uint8_t magic = transport.readByte();
     if (magic != HotRodConstants::RESPONSE_MAGIC) {
@@ -94,8 +99,12 @@ uint8_t Codec20::readHeader(
         message << "Invalid magic number. Expected 0x" << std::setw(2) << static_cast<unsigned>(HotRodConstants::RESPONSE_MAGIC) << " and received 0x" << std::setw(2) << static_cast<unsigned>(magic);
         throw InvalidResponseException(message.str());
     }
+    return transport.readVLong();
+}
 
-    uint64_t receivedMessageId = transport.readVLong();
+uint8_t Codec20::readHeaderAfterMessageId(
+    Transport& transport, HeaderParams& params, uint64_t receivedMessageId) const
+{
     // TODO: java comment, to be checked
     // If received id is 0, it could be that a failure was noted before the
     // message id was detected, so don't consider it to a message id error
@@ -180,7 +189,7 @@ void Codec20::readNewTopologyAndHash(Transport& transport, HeaderParams& params)
     int currentTopology = 0;
     try
     {
-      currentTopology = tf.getTopologyId(params.cacheName);
+      currentTopology = tf.getTopologyId(*params.cacheName);
     }
     catch (std::exception &)
     {
@@ -196,7 +205,7 @@ void Codec20::readNewTopologyAndHash(Transport& transport, HeaderParams& params)
              TRACE("Updating client hash function with %u number of segments", numSegments);
        }
        tf.updateHashFunction(segmentOwners,
-          numSegments, hashFunctionVersion, params.cacheName, params.topologyId.getId());
+          numSegments, hashFunctionVersion, *params.cacheName, params.topologyId.getId());
     } else {
        TRACE("Outdated topology received (topology id = %d, topology age = %d), so ignoring it: s",
              newTopologyId, topologyAge/*, Arrays.toString(addresses)*/);
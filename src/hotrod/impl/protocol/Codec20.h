@@ -29,6 +29,12 @@ class Codec20 : public Codec
         infinispan::hotrod::transport::Transport& transport,
         HeaderParams& params) const;
 
+    uint64_t readMessageId(infinispan::hotrod::transport::Transport& transport) const;
+
+    uint8_t readHeaderAfterMessageId(
+        infinispan::hotrod::transport::Transport& transport,
+        HeaderParams& params, uint64_t receivedMessageId) const;
+
     long getMessageId();
 
     std::vector<char> returnPossiblePrevValue(transport::Transport& t, uint8_t status, uint32_t flags) const;
@@ -62,7 +62,12 @@ std::string IdsMediaTypes::getById(int id) {
 }
 
 namespace protocol {
-HeaderParams::HeaderParams(Topology& tid):topologyId(tid) {
+HeaderParams::HeaderParams(Topology& tid):cacheName(&noCacheName()), topologyId(tid) {
+}
+
+const std::vector<char>& HeaderParams::noCacheName() {
+    static const std::vector<char> empty;
+    return empty;
 }
 
 HeaderParams& HeaderParams::setOpCode(uint8_t code) {
@@ -72,7 +77,7 @@ HeaderParams& HeaderParams::setOpCode(uint8_t code) {
 }
 
 HeaderParams& HeaderParams::setCacheName(const std::vector<char>& c) {
-    cacheName = c;
+    cacheName = &c;
     return *this;
 }
 
@@ -19,7 +19,9 @@ class HeaderParams
   public:
 	HeaderParams(Topology& topId);
     HeaderParams& setOpCode(uint8_t opCode);
+    /** The cache name bytes are not copied, they must outlive these params */
     HeaderParams& setCacheName(const std::vector<char>& cacheName);
+    HeaderParams& setCacheName(std::vector<char>&&) = delete;
     HeaderParams& setFlags(uint32_t flags);
     HeaderParams& setClientIntel(uint8_t clientIntel);
     HeaderParams& setTxMarker(uint8_t txMarker);
@@ -28,13 +30,16 @@ class HeaderParams
     HeaderParams& setTopologyAge(int topologyAge_);
     HeaderParams& setDataFormat(EntryMediaTypes* df);
 
+    /** Shared empty cache name, for operations not bound to a cache */
+    static const std::vector<char>& noCacheName();
+
 
   private:
     uint8_t toOpRespCode(uint8_t opCode);
 
     uint8_t opCode;
     uint8_t opRespCode;
-    std::vector<char> cacheName;
+    const std::vector<char>* cacheName;
     uint32_t flags;
     uint8_t clientIntel;
     uint8_t txMarker;
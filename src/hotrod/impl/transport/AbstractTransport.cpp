@@ -51,6 +51,15 @@ std::vector<char> AbstractTransport::readArray()
   return result;
 }
 
+void AbstractTransport::readArrayInto(std::vector<char>& bytes)
+{
+  uint32_t size = readVInt();
+  bytes.resize(size);
+  if (size) {
+    readBytesInto(bytes.data(), size);
+  }
+}
+
 int64_t AbstractTransport::readLong()
 {
   std::vector<char> longBytes= readBytes(8);
@@ -24,6 +24,7 @@ class AbstractTransport : public Transport
     void writeString(const std::string& str);
     void writeLong(int64_t longValue);
     std::vector<char> readArray();
+    void readArrayInto(std::vector<char>& bytes);
     int64_t readLong();
     int16_t readUnsignedShort();
     int32_t read4ByteInt();
@@ -35,6 +36,7 @@ class AbstractTransport : public Transport
     virtual void writeBytes(const std::vector<char>& bytes) = 0;
     virtual void writeBytes(const char* data, unsigned int size) = 0;
     virtual std::vector<char> readBytes(uint32_t size) = 0;
+    virtual void readBytesInto(char* data, uint32_t size) = 0;
 
   private:
     TransportFactory& transportFactory;
@@ -28,6 +28,8 @@ class Transport
     virtual uint32_t readVInt() = 0;
     virtual uint64_t readVLong() = 0;
     virtual std::vector<char> readArray() = 0;
+    // Reads an array into the caller's buffer, reusing its capacity
+    virtual void readArrayInto(std::vector<char>& bytes) = 0;
 
     virtual int64_t readLong() = 0;
     virtual int16_t readUnsignedShort() = 0;
@@ -9,6 +9,8 @@
 #include "hotrod/impl/consistenthash/ConsistentHash.h"
 #include "hotrod/sys/Log.h"
 #include <algorithm>
+#include <chrono>
+#include <random>
 
 namespace infinispan {
 namespace hotrod {
@@ -55,7 +57,9 @@ void TransportFactory::start(
     {
         balancer.reset(RoundRobinBalancingStrategy::newInstance());
     }
+    topologyInfo.updateServers(initialServers);
 
+    connectionPool.reset(new ConnectionPool(transportFactory, configuration.getConnectionPoolConfiguration()));
     createAndPreparePool();
 
     balancer->setServers(initialServers);
@@ -96,15 +100,61 @@ transport::Transport& TransportFactory::getTransport(const std::vector<char>& /*
 }
 
 transport::Transport& TransportFactory::getTransport(const std::vector<char>& key, const std::vector<char>& cacheName, const std::set<transport::InetSocketAddress>& failedServers) {
-    InetSocketAddress server;
-    {
-        server = topologyInfo.getHashAwareServer(key,cacheName);
-        if (server.isEmpty())
-        {   // Return balanced transport
-        	return getTransport(cacheName, failedServers);
+    std::shared_ptr<const RoutingTable> table = getRoutingTable(cacheName);
+    if (table) {
+        int32_t index = table->hash->getServerIndex(key);
+        if (index >= 0) {
+            PoolSlot* slot = table->slots[index].get();
+            if (slot != nullptr && slot->isValid()
+                    && (failedServers.empty() || !failedServers.count(slot->getAddress()))) {
+                return getConnectionPool()->borrowObject(*slot);
+            }
+        }
+    }
+    // Return balanced transport
+    return getTransport(cacheName, failedServers);
+}
+
+transport::Transport& TransportFactory::getReadTransport(const std::vector<char>& key, const std::vector<char>& cacheName, const std::set<transport::InetSocketAddress>& failedServers) {
+    if (readRoutingPolicy == PRIMARY_OWNER) {
+        return getTransport(key, cacheName, failedServers);
+    }
+    std::shared_ptr<const RoutingTable> table = getRoutingTable(cacheName);
+    if (table) {
+        const uint16_t* owners = nullptr;
+        uint32_t numOwners = table->hash->getOwnerIndexes(key, owners);
+        PoolSlot* chosen = chooseReadOwner(readRoutingPolicy, table->slots, owners, numOwners, failedServers);
+        if (chosen != nullptr) {
+            return getConnectionPool()->borrowObject(*chosen);
+        }
+    }
+    // Return balanced transport
+    return getTransport(cacheName, failedServers);
+}
+
+PoolSlot* TransportFactory::chooseReadOwner(ReadRoutingPolicy policy, const std::vector<PoolSlotPtr>& slots,
+        const uint16_t* owners, uint32_t numOwners, const std::set<InetSocketAddress>& failedServers) {
+    // Start from a random owner, so that ties don't always go to the same one
+    static thread_local std::minstd_rand random(std::random_device{}());
+    uint32_t start = policy != PRIMARY_OWNER && numOwners > 1 ? random() % numOwners : 0;
+    PoolSlot* chosen = nullptr;
+    size_t chosenActive = 0;
+    for (uint32_t i = 0; i < numOwners; i++) {
+        PoolSlot* slot = slots[owners[(start + i) % numOwners]].get();
+        if (slot == nullptr || !slot->isValid()
+                || (!failedServers.empty() && failedServers.count(slot->getAddress()))) {
+            continue;
+        }
+        if (policy != LEAST_OUTSTANDING_OWNER) {
+            return slot;
+        }
+        size_t active = slot->getNumActive();
+        if (chosen == nullptr || active < chosenActive) {
+            chosen = slot;
+            chosenActive = active;
         }
-        return borrowTransportFromPool(server);
     }
+    return chosen;
 }
 
 void TransportFactory::releaseTransport(Transport& transport) {
@@ -124,6 +174,16 @@ void TransportFactory::invalidateTransport(
     pool->invalidateObject(serverAddress, dynamic_cast<TcpTransport*>(transport));
 }
 
+const InetSocketAddress& TransportFactory::requestStarted(Transport& transport) {
+    const InetSocketAddress& server = dynamic_cast<TcpTransport&>(transport).getServerAddress();
+    balancer->requestStarted(server);
+    return server;
+}
+
+void TransportFactory::requestCompleted(const InetSocketAddress& server, uint64_t latencyNanos, bool failed) {
+    balancer->requestCompleted(server, latencyNanos, failed);
+}
+
 bool TransportFactory::clusterSwitch()
 {
     auto configuredServers = getNextWorkingServersConfiguration();
@@ -131,7 +191,6 @@ bool TransportFactory::clusterSwitch()
 	{
 		return false;
 	}
-	connectionPool->close();
 	ScopedLock<Mutex> l(lock);
 	topologyAge = 0;
     initialServers.clear();
@@ -226,15 +285,55 @@ const std::string& TransportFactory::getSslClientCertificateFile() {
     return configuration.getSslConfiguration().clientCertificateFile();
 }
 
+// Applies the server list to the pool, the connections to the servers that are still there are kept
 void TransportFactory::createAndPreparePool()
 {
-    connectionPool.reset(new ConnectionPool(transportFactory, configuration.getConnectionPoolConfiguration()));
     std::vector<InetSocketAddress> servers = topologyInfo.getServers();
+    warmingServers.clear();
+    connectionPool->retainServers(servers);
     for (std::vector<InetSocketAddress>::const_iterator i = servers.begin();
         i != servers.end() ; ++i)
     {
         connectionPool->preparePool(*i);
     }
+    updateRoutingTables();
+}
+
+std::shared_ptr<const TransportFactory::RoutingTable> TransportFactory::getRoutingTable(const std::vector<char>& cacheName) {
+    std::shared_ptr<const RoutingTables> tables = std::atomic_load(&routingTables);
+    auto it = tables->find(cacheName);
+    return it != tables->end() ? it->second : std::shared_ptr<const RoutingTable>();
+}
+
+void TransportFactory::updateRoutingTable(const std::vector<char>& cacheName) {
+    std::shared_ptr<RoutingTable> table;
+    std::shared_ptr<ConsistentHash> hash = topologyInfo.getConsistentHash(cacheName);
+    if (hash) {
+        table.reset(new RoutingTable());
+        table->hash = hash;
+        const std::vector<InetSocketAddress>& servers = hash->getServerList();
+        table->slots.reserve(servers.size());
+        for (const InetSocketAddress& server : servers) {
+            // No routed traffic to a server until its connections are open
+            table->slots.push_back(warmingServers.count(server) ? PoolSlotPtr() : connectionPool->resolveSlot(server));
+        }
+    }
+    ScopedLock<Mutex> l(lockRouting);
+    std::shared_ptr<RoutingTables> tables(new RoutingTables(*std::atomic_load(&routingTables)));
+    if (table) {
+        (*tables)[cacheName] = table;
+    } else {
+        tables->erase(cacheName);
+    }
+    std::atomic_store(&routingTables, std::shared_ptr<const RoutingTables>(tables));
+}
+
+// Pool slots change with the pool, so every table is resolved again
+void TransportFactory::updateRoutingTables() {
+    std::shared_ptr<const RoutingTables> tables = std::atomic_load(&routingTables);
+    for (auto& entry : *tables) {
+        updateRoutingTable(entry.first);
+    }
 }
 
 void TransportFactory::pingExternalServer(InetSocketAddress s) {
@@ -268,6 +367,15 @@ void TransportFactory::pingServers() {
 }
 
 void TransportFactory::destroy() {
+    std::vector<std::future<void> > pending;
+    {
+        ScopedLock<Mutex> l(lock);
+        pending.swap(preconnects);
+    }
+    // The preconnections take the lock when they are done
+    for (size_t i = 0; i < pending.size(); i++) {
+        pending[i].wait();
+    }
     ScopedLock<Mutex> l(lock);
     connectionPool->clear();
     connectionPool->close();
@@ -286,48 +394,78 @@ ConnectionPool* TransportFactory::getConnectionPool()
 }
 
 void TransportFactory::updateServers(std::vector<InetSocketAddress>& newServers) {
+    // Sorted copies, the caller's order is the one the balancer gets
+    std::vector<InetSocketAddress> sortedServers(newServers);
+    std::sort(sortedServers.begin(), sortedServers.end());
     ScopedLock<Mutex> l(lock);
-    std::vector<InetSocketAddress> addedServers;
-    std::vector<InetSocketAddress> topoServers=topologyInfo.getServers();
-
-    std::sort(newServers.begin(), newServers.end());
-
-    std::sort(topoServers.begin(), topoServers.end());
-
-    std::set_difference(newServers.begin(), newServers.end(), topoServers.begin(),
-    		topoServers.end(), std::inserter(addedServers, addedServers.end()));
-
-    std::vector<InetSocketAddress> failedServers;
-    std::sort(newServers.begin(), newServers.end());
+    std::vector<InetSocketAddress> topoServers = topologyInfo.getServers();
     std::sort(topoServers.begin(), topoServers.end());
 
-    std::set_difference(topoServers.begin(), topoServers.end(), newServers.begin(),
-            newServers.end(), std::inserter(failedServers, failedServers.end()));
-
-    if (failedServers.empty() && newServers.empty()) {
+    // A single merge gives both the added and the removed servers
+    std::vector<InetSocketAddress> addedServers, removedServers;
+    std::vector<InetSocketAddress>::const_iterator n = sortedServers.begin(), t = topoServers.begin();
+    while (n != sortedServers.end() || t != topoServers.end()) {
+        if (t == topoServers.end() || (n != sortedServers.end() && *n < *t)) {
+            addedServers.push_back(*n++);
+        } else if (n == sortedServers.end() || *t < *n) {
+            removedServers.push_back(*t++);
+        } else {
+            ++n;
+            ++t;
+        }
+    }
+    if (addedServers.empty() && removedServers.empty()) {
         return;
     }
 
-    //1. first add new servers. For servers that went down, the returned transport will fail for now
-    for (std::vector<InetSocketAddress>::const_iterator it =
-            addedServers.begin(); it != addedServers.end(); ++it) {
-        connectionPool->addObject(*it);
+    //1. The new servers join the pool without connections, they are opened in background. Until then
+    // the servers get no routed traffic and aren't known to the balancer
+    for (std::vector<InetSocketAddress>::const_iterator it = addedServers.begin(); it != addedServers.end(); ++it) {
+        connectionPool->addServer(*it);
+        warmingServers.insert(*it);
     }
+    topologyInfo.updateServers(newServers);
+    balancer->setServers(getActiveServers());
 
-    //2. now set the server list to the active list of servers. All the active servers (potentially together with some
-    // failed servers) are in the pool now. But after this, the pool won't be asked for connections to failed servers,
-    // as the balancer will only know about the active servers
-
-    balancer->setServers(newServers);
-
-    //3. Now just remove failed servers
-    for (std::vector<InetSocketAddress>::const_iterator it =
-            failedServers.begin(); it != failedServers.end(); ++it) {
+    //2. The removed servers are drained: the requests in flight complete, then their connections are closed
+    for (std::vector<InetSocketAddress>::const_iterator it = removedServers.begin(); it != removedServers.end(); ++it) {
+        warmingServers.erase(*it);
         connectionPool->clear(*it);
     }
+    updateRoutingTables();
+
+    if (!addedServers.empty()) {
+        // Forget the preconnections that are done
+        preconnects.erase(std::remove_if(preconnects.begin(), preconnects.end(), [](const std::future<void>& f) {
+            return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), preconnects.end());
+        preconnects.push_back(std::async(std::launch::async, [this, addedServers]() { preconnect(addedServers); }));
+    }
+}
 
-    topoServers.clear();
-    topologyInfo.updateServers(newServers);
+void TransportFactory::preconnect(const std::vector<InetSocketAddress>& servers) {
+    for (std::vector<InetSocketAddress>::const_iterator it = servers.begin(); it != servers.end(); ++it) {
+        connectionPool->preconnect(*it);
+    }
+    ScopedLock<Mutex> l(lock);
+    for (std::vector<InetSocketAddress>::const_iterator it = servers.begin(); it != servers.end(); ++it) {
+        warmingServers.erase(*it);
+    }
+    balancer->setServers(getActiveServers());
+    updateRoutingTables();
+}
+
+// Called with the lock held
+std::vector<InetSocketAddress> TransportFactory::getActiveServers() {
+    std::vector<InetSocketAddress>& servers = topologyInfo.getServers();
+    std::vector<InetSocketAddress> active;
+    for (std::vector<InetSocketAddress>::const_iterator it = servers.begin(); it != servers.end(); ++it) {
+        if (!warmingServers.count(*it)) {
+            active.push_back(*it);
+        }
+    }
+    // With no server ready the new ones are used anyway, connecting on the first borrow
+    return active.empty() ? servers : active;
 }
 
 void TransportFactory::updateHashFunction(
@@ -338,6 +476,7 @@ void TransportFactory::updateHashFunction(
     ScopedLock<Mutex> l(lock);
     TRACE("TransportFactory::updateHashFunction(): hashversion=%d, topologyId=%d",hashFunctionVersion, topologyId);
     topologyInfo.updateTopology(segmentOwners, numSegment, hashFunctionVersion, cacheName, topologyId);
+    updateRoutingTable(cacheName);
 }
 
 const std::string& TransportFactory::getSniHostName(){
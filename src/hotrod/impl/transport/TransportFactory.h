@@ -14,6 +14,8 @@
 #include "hotrod/sys/Mutex.h"
 #include "hotrod/impl/event/ClientListenerNotifier.h"
 #include "infinispan/hotrod/exceptions.h"
+#include <chrono>
+#include <future>
 #include <vector>
 #include <set>
 #include <map>
@@ -40,16 +42,24 @@ class TransportFactory
 {
 	friend class infinispan::hotrod::RemoteCacheManagerImpl;
   public:
-    TransportFactory(const Configuration& config) : topologyInfo(initialServers, config), configuration(config), maxRetries(config.getMaxRetries()) {}
+    TransportFactory(const Configuration& config) : topologyInfo(initialServers, config), configuration(config), maxRetries(config.getMaxRetries()),
+        readRoutingPolicy(config.getReadRoutingPolicy()) {}
     void start(protocol::Codec& codec, ClientListenerNotifier* );
     void destroy();
 
     transport::Transport& getTransport(const std::vector<char>& cacheName, const std::set<transport::InetSocketAddress>& failedServers);
     transport::Transport& getTransport(const std::vector<char>& key, const std::vector<char>& cacheName, const std::set<transport::InetSocketAddress>& failedServers);
+    transport::Transport& getReadTransport(const std::vector<char>& key, const std::vector<char>& cacheName, const std::set<transport::InetSocketAddress>& failedServers);
 
     void releaseTransport(Transport& transport);
     void invalidateTransport(
         const InetSocketAddress& address, Transport* transport);
+    /**
+     * Tell the balancer that a request was sent on transport, see FailOverRequestBalancingStrategy
+     * \return the target server of the request
+     */
+    const InetSocketAddress& requestStarted(Transport& transport);
+    void requestCompleted(const InetSocketAddress& server, uint64_t latencyNanos, bool failed);
     bool clusterSwitch();
     bool clusterSwitch(std::string clusterName);
     bool isTcpNoDelay();
@@ -71,7 +81,7 @@ class TransportFactory
     ~TransportFactory() { }
     const Configuration& getConfiguration() { return configuration; }
     int getTopologyId(const std::vector<char> &cacheName) {
-    	  return topologyInfo.getCacheTopologyInfo(cacheName).getTopologyId();
+    	  return topologyInfo.getTopologyId(cacheName);
     }
     int createTopologyId(std::vector<char> cacheName) {
     	return topologyInfo.createTopologyId(cacheName,-1);
@@ -86,6 +96,24 @@ class TransportFactory
     	return topologyInfo.getCacheTopologyInfo(cacheName);
     }
 
+    /**
+     * The consistent hash of a cache with the pool slots of its servers, in server index order.
+     * A null slot is a server the pool doesn't know yet.
+     */
+    struct RoutingTable {
+        std::shared_ptr<consistenthash::ConsistentHash> hash;
+        std::vector<PoolSlotPtr> slots;
+    };
+
+    /**
+     * Chooses the owner serving a read among the owners with a valid slot that didn't fail.
+     * PRIMARY_OWNER takes the first of them, so a backup only if the primary can't be used.
+     *
+     * \return the slot of the chosen owner, nullptr if none can be used
+     */
+    static PoolSlot* chooseReadOwner(ReadRoutingPolicy policy, const std::vector<PoolSlotPtr>& slots,
+            const uint16_t* owners, uint32_t numOwners, const std::set<InetSocketAddress>& failedServers);
+
     TopologyInfo& getTopologyInfo() { return topologyInfo; }
     const std::set<InetSocketAddress> &getFailedServers() {return failedServers;}
 
@@ -100,16 +128,28 @@ class TransportFactory
     std::string sniHostName;
 
   private:
-    sys::Mutex lock, lockFailedServer;
+    sys::Mutex lock, lockFailedServer, lockRouting;
+    typedef std::map<std::vector<char>, std::shared_ptr<const RoutingTable> > RoutingTables;
+    // Copied on write and swapped atomically, see TopologyInfo
+    std::shared_ptr<const RoutingTables> routingTables = std::make_shared<const RoutingTables>();
     std::vector<InetSocketAddress> initialServers;
     std::set<InetSocketAddress> failedServers;
     const Configuration& configuration;
     int maxRetries;
+    ReadRoutingPolicy readRoutingPolicy;
     std::shared_ptr<TransportObjectFactory> transportFactory;
     std::shared_ptr<ConnectionPool> connectionPool;
     std::shared_ptr<FailOverRequestBalancingStrategy> balancer;
     std::string currCluster;
+    // The servers being connected in background, see updateServers()
+    std::set<InetSocketAddress> warmingServers;
+    std::vector<std::future<void> > preconnects;
     void createAndPreparePool();
+    void preconnect(const std::vector<InetSocketAddress>& servers);
+    std::vector<InetSocketAddress> getActiveServers();
+    std::shared_ptr<const RoutingTable> getRoutingTable(const std::vector<char>& cacheName);
+    void updateRoutingTable(const std::vector<char>& cacheName);
+    void updateRoutingTables();
     void updateTransportCount();
     void pingServers();
     ConnectionPool* getConnectionPool();
@@ -119,6 +159,37 @@ class TransportFactory
     static TransportFactory* newInstance(const Configuration& config);
 };
 
+/**
+ * Measures a request from start() to stop() and reports it to the balancer. A request that is
+ * still running when the timer is destroyed is reported as failed.
+ *
+ * stop() must be called before the transport is released, the timer refers to its address.
+ */
+class RequestTimer
+{
+  public:
+    RequestTimer(TransportFactory& factory) : factory(factory), server(nullptr) {}
+    ~RequestTimer() { stop(true); }
+
+    void start(Transport& transport) {
+        server = &factory.requestStarted(transport);
+        begin = std::chrono::steady_clock::now();
+    }
+
+    void stop(bool failed) {
+        if (server != nullptr) {
+            std::chrono::nanoseconds latency = std::chrono::steady_clock::now() - begin;
+            factory.requestCompleted(*server, (uint64_t) latency.count(), failed);
+            server = nullptr;
+        }
+    }
+
+  private:
+    TransportFactory& factory;
+    const InetSocketAddress* server;
+    std::chrono::steady_clock::time_point begin;
+};
+
 }}} // namespace infinispan::hotrod::transport
 
 #endif  /* ISPN_HOTROD_TRANSPORT_TCPTRANSPORTFACTORY_H */
@@ -1,5 +1,6 @@
 #include "hotrod/impl/transport/tcp/ConnectionPool.h"
 #include <hotrod/sys/Log.h>
+#include <set>
 
 namespace infinispan {
 namespace hotrod {
@@ -8,14 +9,74 @@ namespace transport {
 void ConnectionPool::addObject(const InetSocketAddress &key) {
     sys::ScopedLock<sys::Mutex> l(lock);
 
+    if (registerServer(key)) {
+        ensureMinIdle(key);
+    }
+}
+
+void ConnectionPool::addServer(const InetSocketAddress &key) {
+    sys::ScopedLock<sys::Mutex> l(lock);
+    registerServer(key);
+}
+
+// Called with the lock held, false if the server was already there
+bool ConnectionPool::registerServer(const InetSocketAddress &key) {
     if (idle.find(key) != idle.end()) {
-        return; //key already existed.
+        return false; //key already existed.
     }
-    TransportQueuePtr idleQ(new BlockingQueue<TcpTransport*>()); // = TransportQueue(BlockingQueue<TcpTransport *>* idleQ = new BlockingQueue<TcpTransport *>();
+    TransportQueuePtr idleQ(new BlockingQueue<TcpTransport*>());
     idle.insert(std::pair<InetSocketAddress, TransportQueuePtr>(key, idleQ));
-    TransportQueuePtr busyQ(new BlockingQueue<TcpTransport*>()); // = TransportQueue(BlockingQueue<TcpTransport *>* idleQ = new BlockingQueue<TcpTransport *>();
-    busy.insert(std::pair<InetSocketAddress, TransportQueuePtr>(key, busyQ));
-    ensureMinIdle(key);
+    // A server removed and added again keeps the busy queue of the connections it's still draining
+    if (busy.find(key) == busy.end()) {
+        TransportQueuePtr busyQ(new BlockingQueue<TcpTransport*>());
+        busy.insert(std::pair<InetSocketAddress, TransportQueuePtr>(key, busyQ));
+    }
+    return true;
+}
+
+void ConnectionPool::preconnect(const InetSocketAddress &key) {
+    int grown;
+    {
+        sys::ScopedLock<sys::Mutex> l(lock);
+        if (closed || idle.find(key) == idle.end()) {
+            return;
+        }
+        grown = calculateMinIdleGrow(key);
+    }
+    std::vector<TcpTransport*> created;
+    try {
+        while ((int) created.size() < grown) {
+            created.push_back(&factory->makeObject(key));
+        }
+    } catch (const Exception& ex) {
+        WARN("Unable to connect to %s:%d in advance: %s", key.getHostname().c_str(), key.getPort(), ex.what());
+    }
+    sys::ScopedLock<sys::Mutex> l(lock);
+    std::map<InetSocketAddress, TransportQueuePtr>::iterator idleIt = idle.find(key);
+    for (size_t i = 0; i < created.size(); i++) {
+        // The server may have been removed, or other servers filled the pool, while connecting
+        if (!closed && idleIt != idle.end() && !hasReachedMaxTotal() && idleIt->second->offer(created[i])) {
+            totalIdle++;
+        } else {
+            factory->destroyObject(key, *created[i]);
+        }
+    }
+}
+
+void ConnectionPool::retainServers(const std::vector<InetSocketAddress> &servers) {
+    std::vector<InetSocketAddress> removed;
+    {
+        sys::ScopedLock<sys::Mutex> l(lock);
+        std::set<InetSocketAddress> retained(servers.begin(), servers.end());
+        for (std::map<InetSocketAddress, TransportQueuePtr>::iterator it = idle.begin(); it != idle.end(); ++it) {
+            if (!retained.count(it->first)) {
+                removed.push_back(it->first);
+            }
+        }
+    }
+    for (size_t i = 0; i < removed.size(); i++) {
+        clear(removed[i]);
+    }
 }
 
 void ConnectionPool::ensureMinIdle(const InetSocketAddress &key) {
@@ -97,9 +158,50 @@ TcpTransport& ConnectionPool::borrowObject(const InetSocketAddress &key) {
     if (!idle.count(key) || !busy.count(key)) {
         throw HotRodClientException("Pool has no idle or no busy transports.");
     }
-    TransportQueuePtr idleQ = idle[key];
-    TransportQueuePtr busyQ = busy[key];
+    return borrowObject(key, idle[key], busy[key]);
+}
+
+TcpTransport& ConnectionPool::borrowObject(PoolSlot &slot) {
+    sys::ScopedLock<sys::Mutex> l(lock);
+
+    if (closed) {
+        throw HotRodClientException("Pool is closed");
+    }
+    if (!slot.valid) {
+        if (!idle.count(slot.key) || !busy.count(slot.key)) {
+            throw HotRodClientException("Pool has no idle or no busy transports.");
+        }
+        return borrowObject(slot.key, idle[slot.key], busy[slot.key]);
+    }
+    return borrowObject(slot.key, slot.idleQ, slot.busyQ);
+}
 
+PoolSlotPtr ConnectionPool::resolveSlot(const InetSocketAddress &key) {
+    sys::ScopedLock<sys::Mutex> l(lock);
+    std::map<InetSocketAddress, PoolSlotPtr>::iterator it = slots.find(key);
+    if (it != slots.end()) {
+        return it->second;
+    }
+    std::map<InetSocketAddress, TransportQueuePtr>::iterator idleIt = idle.find(key);
+    std::map<InetSocketAddress, TransportQueuePtr>::iterator busyIt = busy.find(key);
+    if (closed || idleIt == idle.end() || busyIt == busy.end()) {
+        return PoolSlotPtr();
+    }
+    PoolSlotPtr slot(new PoolSlot(key, idleIt->second, busyIt->second));
+    slots.insert(std::make_pair(key, slot));
+    return slot;
+}
+
+void ConnectionPool::invalidateSlot(const InetSocketAddress &key) {
+    std::map<InetSocketAddress, PoolSlotPtr>::iterator it = slots.find(key);
+    if (it != slots.end()) {
+        it->second->valid = false;
+        slots.erase(it);
+    }
+}
+
+// Called with the lock held
+TcpTransport& ConnectionPool::borrowObject(const InetSocketAddress &key, TransportQueuePtr idleQ, TransportQueuePtr busyQ) {
     // See if an object is readily available
     TcpTransport *obj = NULL;
     bool ok = idleQ->poll(obj);
@@ -168,9 +270,7 @@ void ConnectionPool::invalidateObject(const InetSocketAddress &key, TcpTransport
 
         if (!busyIt->second->size()) {
             std::map<InetSocketAddress, TransportQueuePtr>::iterator idleIt = idle.find(key);
-            if (idleIt == idle.end()) {
-                throw HotRodClientException("No idle queue for address!");
-            } else {
+            if (idleIt != idle.end()) {
                 if (!idleIt->second->size()) {
                     // idleQ busyQ are empty, awake all waiting threads
                     idleIt->second->notifyAll();
@@ -185,7 +285,8 @@ void ConnectionPool::invalidateObject(const InetSocketAddress &key, TcpTransport
             totalIdle++;
         }
 
-        // Destroy object
+        // key can be the address of the object, done with it before the object is destroyed
+        releaseDrained(key);
         factory->destroyObject(key, *val);
     }
 }
@@ -214,7 +315,7 @@ void ConnectionPool::returnObject(const InetSocketAddress &key, TcpTransport &va
         //we need to allocate a new connection for other key.
         idle[keyToAllocate]->push(&factory->makeObject(keyToAllocate));
         totalIdle++;
-        if (!idle[key]->size() && !busy[key]->size()) {
+        if (idle.count(key) && !idle[key]->size() && !busy[key]->size()) {
             // idleQ busyQ are empty, awake all waiting threads
             idle[key]->notifyAll();
         }
@@ -232,14 +333,31 @@ void ConnectionPool::returnObject(const InetSocketAddress &key, TcpTransport &va
         }
     }
 
+    // key can be the address of the object, done with it before the object is destroyed
+    releaseDrained(key);
     if (!ok) {
         // The object is now useless
         factory->destroyObject(key, val);
     }
 }
 
+// Called with the lock held. Forgets a removed server once its last busy connection is gone
+void ConnectionPool::releaseDrained(const InetSocketAddress &key) {
+    if (idle.find(key) != idle.end()) {
+        return;
+    }
+    std::map<InetSocketAddress, TransportQueuePtr>::iterator busyIt = busy.find(key);
+    if (busyIt != busy.end() && busyIt->second->size() == 0) {
+        busy.erase(busyIt);
+    }
+}
+
 void ConnectionPool::clear() {
     sys::ScopedLock<sys::Mutex> l(lock);
+    for (std::map<InetSocketAddress, PoolSlotPtr>::iterator it = slots.begin(); it != slots.end(); ++it) {
+        it->second->valid = false;
+    }
+    slots.clear();
     clear(idle);
     clear(busy);
     totalIdle = 0;
@@ -255,12 +373,17 @@ void ConnectionPool::clear(std::map<InetSocketAddress, TransportQueuePtr> &queue
 
 void ConnectionPool::clear(const InetSocketAddress &key) {
     sys::ScopedLock<sys::Mutex> l(lock);
-    TransportQueuePtr idleQ = idle[key];
-    if (!idleQ)
+    invalidateSlot(key);
+    std::map<InetSocketAddress, TransportQueuePtr>::iterator idleIt = idle.find(key);
+    if (idleIt == idle.end())
         return;
+    TransportQueuePtr idleQ = idleIt->second;
+    idle.erase(idleIt);
     totalIdle -= (int) idleQ->size();
     clear(key, idleQ);
-    idle.erase(key);
+    // Threads waiting for a connection to the server try again and find it gone
+    idleQ->notifyAll();
+    releaseDrained(key);
 }
 
 void ConnectionPool::clear(const InetSocketAddress &key, TransportQueuePtr queue) {
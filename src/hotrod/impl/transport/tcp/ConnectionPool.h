@@ -2,7 +2,9 @@
 #define ISPN_HOTROD_TRANSPORT_CONNECTIONPOOL_H
 
 #include <infinispan/hotrod/InetSocketAddress.h>
+#include <atomic>
 #include <map>
+#include <vector>
 #include <iterator>
 #include <queue>
 #include "infinispan/hotrod/defs.h"
@@ -39,6 +41,31 @@ class PoolWorker: public sys::Runnable {
 
 typedef std::shared_ptr<BlockingQueue<TcpTransport *> > TransportQueuePtr;
 
+/**
+ * PoolSlot is the pool entry of a server resolved in advance, so that borrowing from it doesn't
+ * look the server up again. A slot is invalidated when its server leaves the pool, borrowing
+ * from it then goes through the lookup by address.
+ */
+class PoolSlot
+{
+  public:
+    PoolSlot(const InetSocketAddress& key_, TransportQueuePtr idleQ_, TransportQueuePtr busyQ_)
+      : key(key_), idleQ(idleQ_), busyQ(busyQ_), valid(true) {}
+
+    const InetSocketAddress& getAddress() const { return key; }
+    bool isValid() const { return valid; }
+    size_t getNumActive() const { return busyQ->size(); }
+
+  private:
+    friend class ConnectionPool;
+    InetSocketAddress key;
+    TransportQueuePtr idleQ;
+    TransportQueuePtr busyQ;
+    std::atomic<bool> valid;
+};
+
+typedef std::shared_ptr<PoolSlot> PoolSlotPtr;
+
 class ConnectionPool
 {
   public:
@@ -90,11 +117,30 @@ class ConnectionPool
     }
 
     void addObject(const InetSocketAddress& key);
+    /**
+     * Adds a server to the pool without connecting to it, see preconnect()
+     */
+    void addServer(const InetSocketAddress& key);
+    /**
+     * Opens the minIdle connections of a server added with addServer(). The pool isn't locked
+     * while connecting, connection errors are logged and left to the first borrow.
+     */
+    void preconnect(const InetSocketAddress& key);
+    /**
+     * Removes the servers not in the list, the connections to the others are kept. See clear(key)
+     */
+    void retainServers(const std::vector<InetSocketAddress>& servers);
     void returnObject(const InetSocketAddress& key, TcpTransport& val);
     TcpTransport& borrowObject(const InetSocketAddress& key);
+    TcpTransport& borrowObject(PoolSlot& slot);
+    PoolSlotPtr resolveSlot(const InetSocketAddress& key);
     bool tryRemoveIdleOrAskAllocate(const InetSocketAddress& key);
     void invalidateObject(const InetSocketAddress& key, TcpTransport* val);
     void clear();
+    /**
+     * Removes a server from the pool. Its idle connections are closed now, the busy ones when
+     * they are returned or invalidated.
+     */
     void clear(const InetSocketAddress& key);
     void preparePool(const InetSocketAddress& key);
     void close();
@@ -107,6 +153,10 @@ class ConnectionPool
   private:
     void clear(std::map<InetSocketAddress, TransportQueuePtr>& queue);
     void clear(const InetSocketAddress& key, TransportQueuePtr queue);
+    TcpTransport& borrowObject(const InetSocketAddress& key, TransportQueuePtr idleQ, TransportQueuePtr busyQ);
+    void invalidateSlot(const InetSocketAddress& key);
+    bool registerServer(const InetSocketAddress& key);
+    void releaseDrained(const InetSocketAddress& key);
     void ensureMinIdle(const InetSocketAddress& key);
     int calculateMinIdleGrow(const InetSocketAddress& key);
     bool hasReachedMaxTotal();
@@ -119,6 +169,7 @@ class ConnectionPool
     sys::Mutex lock;
     std::map<InetSocketAddress, TransportQueuePtr > busy;
     std::map<InetSocketAddress, TransportQueuePtr > idle;
+    std::map<InetSocketAddress, PoolSlotPtr > slots;
     std::queue<InetSocketAddress> allocationQueue;
     bool closed;
     int totalIdle;
@@ -0,0 +1,146 @@
+#include "infinispan/hotrod/LatencyAwareBalancingStrategy.h"
+#include "infinispan/hotrod/exceptions.h"
+#include <cmath>
+
+namespace infinispan {
+namespace hotrod {
+
+using transport::InetSocketAddress;
+
+FailOverRequestBalancingStrategy* LatencyAwareBalancingStrategy::newInstance() {
+    return new LatencyAwareBalancingStrategy();
+}
+
+LatencyAwareBalancingStrategy::LatencyAwareBalancingStrategy(double smoothing, uint64_t failurePenaltyNanos,
+        uint64_t decayNanos) : random(std::random_device{}()), smoothing(smoothing),
+        failurePenalty((double) failurePenaltyNanos), decay((double) decayNanos) {
+    if (smoothing <= 0 || smoothing > 1) {
+        throw HotRodClientException("Balancing: smoothing must be in (0, 1]");
+    }
+}
+
+void LatencyAwareBalancingStrategy::setServers(const std::vector<InetSocketAddress>& s) {
+    std::lock_guard<std::mutex> guard(lock);
+    Clock::time_point now = Clock::now();
+    // New servers start from the average of the known ones, so they don't take all the load at once
+    double sum = 0;
+    int sampled = 0;
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (stats[i].lastSample != Clock::time_point()) {
+            sum += decayedAverage(stats[i], now);
+            sampled++;
+        }
+    }
+    ServerStats initial = { sampled > 0 ? sum / sampled : 0, Clock::time_point(), 0 };
+    std::vector<ServerStats> newStats(s.size(), initial);
+    for (size_t i = 0; i < s.size(); i++) {
+        int old = indexOf(s[i]);
+        if (old >= 0) {
+            newStats[i] = stats[old];
+        }
+    }
+    servers = s;
+    stats.swap(newStats);
+}
+
+const InetSocketAddress& LatencyAwareBalancingStrategy::nextServer(const std::set<InetSocketAddress>& failedServers) {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t n = servers.size();
+    int first = -1, second = -1;
+    if (n > 0) {
+        size_t start = random() % n;
+        for (size_t i = 0; i < n && first < 0; i++) {
+            size_t candidate = (start + i) % n;
+            if (failedServers.empty() || !failedServers.count(servers[candidate])) {
+                first = (int) candidate;
+            }
+        }
+        start = random() % n;
+        for (size_t i = 0; i < n && first >= 0 && second < 0; i++) {
+            size_t candidate = (start + i) % n;
+            if ((int) candidate != first && (failedServers.empty() || !failedServers.count(servers[candidate]))) {
+                second = (int) candidate;
+            }
+        }
+    }
+    if (first < 0) {
+        throw HotRodClientException("Balancing: No more server available.");
+    }
+    if (second >= 0) {
+        Clock::time_point now = Clock::now();
+        if (cost(stats[second], now) < cost(stats[first], now)) {
+            first = second;
+        }
+    }
+    return servers[first];
+}
+
+void LatencyAwareBalancingStrategy::requestStarted(const InetSocketAddress& server) {
+    std::lock_guard<std::mutex> guard(lock);
+    int i = indexOf(server);
+    if (i >= 0) {
+        stats[i].inFlight++;
+    }
+}
+
+void LatencyAwareBalancingStrategy::requestCompleted(const InetSocketAddress& server, uint64_t latencyNanos, bool failed) {
+    std::lock_guard<std::mutex> guard(lock);
+    int i = indexOf(server);
+    if (i < 0) {
+        // Removed by setServers() while the request was in flight
+        return;
+    }
+    ServerStats& s = stats[i];
+    if (s.inFlight > 0) {
+        s.inFlight--;
+    }
+    double sample = (double) latencyNanos;
+    if (failed && sample < failurePenalty) {
+        sample = failurePenalty;
+    }
+    Clock::time_point now = Clock::now();
+    if (s.lastSample == Clock::time_point()) {
+        s.average = sample;
+    } else {
+        double previous = decayedAverage(s, now);
+        s.average = previous + smoothing * (sample - previous);
+    }
+    s.lastSample = now;
+}
+
+uint64_t LatencyAwareBalancingStrategy::getAverageLatency(const InetSocketAddress& server) {
+    std::lock_guard<std::mutex> guard(lock);
+    int i = indexOf(server);
+    return i >= 0 ? (uint64_t) decayedAverage(stats[i], Clock::now()) : 0;
+}
+
+int LatencyAwareBalancingStrategy::getInFlight(const InetSocketAddress& server) {
+    std::lock_guard<std::mutex> guard(lock);
+    int i = indexOf(server);
+    return i >= 0 ? stats[i].inFlight : 0;
+}
+
+int LatencyAwareBalancingStrategy::indexOf(const InetSocketAddress& server) const {
+    // The server list is short, a scan is cheaper than a map
+    for (size_t i = 0; i < servers.size(); i++) {
+        if (servers[i] == server) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+double LatencyAwareBalancingStrategy::decayedAverage(const ServerStats& s, Clock::time_point now) const {
+    if (s.lastSample == Clock::time_point() || now <= s.lastSample) {
+        return s.average;
+    }
+    double idle = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(now - s.lastSample).count();
+    return s.average * std::exp(-idle / decay);
+}
+
+double LatencyAwareBalancingStrategy::cost(const ServerStats& s, Clock::time_point now) const {
+    // The extra nanosecond lets the requests in flight break the tie between unknown servers
+    return (decayedAverage(s, now) + 1) * (s.inFlight + 1);
+}
+
+}} /* namespace */
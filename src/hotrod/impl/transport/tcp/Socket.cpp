@@ -51,6 +51,14 @@ void InputStream::read(char *buf, size_t size) {
             memcpy(tmp_buffer, ptr, capacity);
             tmp_buffer += capacity;
             size -= capacity;
+            capacity = 0;
+        }
+        if (size >= BufferSize) {
+            // Large reads land straight in the caller's memory
+            size_t n = socket.read(tmp_buffer, size);
+            tmp_buffer += n;
+            size -= n;
+            continue;
         }
         capacity = socket.read(&buffer[0], size < BufferSize ? size : BufferSize);
         ptr = &buffer[0];
@@ -76,17 +84,26 @@ OutputStream::OutputStream(sys::Socket& s) :
 {}
 
 void OutputStream::write(const char *p, size_t n) {
-    out.write(p,n);
+    if (n >= DirectWriteSize) {
+        // Large values are sent from the caller's memory, the buffered bytes go first
+        flush();
+        socket.write(p, n);
+        return;
+    }
+    out.insert(out.end(), p, p + n);
 }
 
 void OutputStream::write(char c) {
-    out.put(c);
+    out.push_back(c);
 }
 
 void OutputStream::flush() {
-    const std::string& outstr(out.str());
-    socket.write(outstr.data(), outstr.size());
-    out.str("");
+    if (out.empty()) {
+        return;
+    }
+    socket.write(out.data(), out.size());
+    // Keep the capacity, the next request reuses it
+    out.clear();
 }
 
 
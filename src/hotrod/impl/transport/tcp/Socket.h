@@ -3,7 +3,7 @@
 
 #include "hotrod/sys/Socket.h"
 
-#include <sstream>
+#include <vector>
 #include <memory>
 
 namespace infinispan {
@@ -34,9 +34,11 @@ class OutputStream
     void write(char c);
     void flush();
   private:
+    // Writes at least this big skip the buffer and go straight to the socket
+    static const size_t DirectWriteSize = 64 * 1024;
     OutputStream(sys::Socket& socket);
     sys::Socket& socket;
-    std::ostringstream out;
+    std::vector<char> out;
 
   friend class Socket;
 };
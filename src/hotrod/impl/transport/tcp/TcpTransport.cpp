@@ -112,6 +112,10 @@ std::vector<char> TcpTransport::readBytes(uint32_t size) {
     return std::vector<char>();
 }
 
+void TcpTransport::readBytesInto(char* data, uint32_t size) {
+    socket.getInputStream().read(data, size);
+}
+
 void TcpTransport::release() {
     try {
         socket.close();
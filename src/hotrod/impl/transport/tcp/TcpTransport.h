@@ -32,6 +32,7 @@ class TcpTransport : public AbstractTransport
     uint32_t readVInt();
     uint64_t readVLong();
     std::vector<char> readBytes(uint32_t size);
+    void readBytesInto(char* data, uint32_t size);
 
     void release();
     void destroy();
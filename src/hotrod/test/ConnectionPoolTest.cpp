@@ -1,5 +1,6 @@
 #include "hotrod/impl/transport/tcp/ConnectionPool.h"
 #include "hotrod/impl/transport/tcp/TransportObjectFactory.h"
+#include "hotrod/impl/transport/TransportFactory.h"
 #include "hotrod/sys/Log.h"
 #include "hotrod/sys/Runnable.h"
 #include "hotrod/sys/Thread.h"
@@ -653,3 +654,135 @@ HR_EXPORT void testMaxTotal4() {
     delete r1;
     delete t1;
 }
+
+HR_EXPORT void testPoolSlot() {
+    const int minIdle = 1;
+
+    std::shared_ptr<TestTransportFactory> factory = std::shared_ptr<TestTransportFactory>(new TestTransportFactory);
+    Configuration config = createConfiguration(minIdle, UNLIMITED, UNLIMITED);
+    ConnectionPool* pool = new ConnectionPool(factory, config.getConnectionPoolConfiguration());
+
+    InetSocketAddress addr("127.0.0.1", 1024);
+    InetSocketAddress unknown("127.0.0.1", 1025);
+    pool->preparePool(addr);
+
+    //a server out of the pool has no slot
+    assert(!pool->resolveSlot(unknown));
+
+    PoolSlotPtr slot = pool->resolveSlot(addr);
+    assert(slot && slot->isValid());
+    assert(slot == pool->resolveSlot(addr)); //resolved once
+
+    TcpTransport& t = pool->borrowObject(*slot);
+    assert(pool->getNumActive(addr) == 1);
+    assert(pool->getNumIdle(addr) == 0);
+    pool->returnObject(addr, t);
+    assert(pool->getNumActive(addr) == 0);
+    assert(pool->getNumIdle(addr) == minIdle);
+
+    //removing the server invalidates the slot, borrowing falls back to the lookup by address
+    pool->clear(addr);
+    assert(!slot->isValid());
+    bool thrown = false;
+    try {
+        pool->borrowObject(*slot);
+    } catch (const HotRodClientException&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    delete pool;
+}
+
+HR_EXPORT void testReadOwnerChoice() {
+    std::shared_ptr<TestTransportFactory> factory = std::shared_ptr<TestTransportFactory>(new TestTransportFactory);
+    Configuration config = createConfiguration(1, UNLIMITED, UNLIMITED);
+    ConnectionPool* pool = new ConnectionPool(factory, config.getConnectionPoolConfiguration());
+
+    InetSocketAddress primary("127.0.0.1", 1024);
+    InetSocketAddress backup("127.0.0.1", 1025);
+    pool->preparePool(primary);
+    pool->preparePool(backup);
+    std::vector<PoolSlotPtr> slots;
+    slots.push_back(pool->resolveSlot(primary));
+    slots.push_back(pool->resolveSlot(backup));
+    const uint16_t owners[] = { 0, 1 };
+    std::set<InetSocketAddress> noFailures;
+
+    assert(TransportFactory::chooseReadOwner(PRIMARY_OWNER, slots, owners, 2, noFailures) == slots[0].get());
+
+    //random reads reach both owners
+    bool seen[2] = { false, false };
+    for (int i = 0; i < 100; ++i) {
+        PoolSlot* s = TransportFactory::chooseReadOwner(RANDOM_OWNER, slots, owners, 2, noFailures);
+        seen[s == slots[0].get() ? 0 : 1] = true;
+    }
+    assert(seen[0] && seen[1]);
+
+    //the busy primary loses against the idle backup
+    TcpTransport& t = pool->borrowObject(*slots[0]);
+    for (int i = 0; i < 10; ++i) {
+        assert(TransportFactory::chooseReadOwner(LEAST_OUTSTANDING_OWNER, slots, owners, 2, noFailures) == slots[1].get());
+    }
+    pool->returnObject(primary, t);
+
+    //failed owners are skipped, with no owner left the caller falls back to the balancer
+    std::set<InetSocketAddress> failures;
+    failures.insert(backup);
+    assert(TransportFactory::chooseReadOwner(RANDOM_OWNER, slots, owners, 2, failures) == slots[0].get());
+    failures.insert(primary);
+    assert(TransportFactory::chooseReadOwner(LEAST_OUTSTANDING_OWNER, slots, owners, 2, failures) == NULL);
+
+    delete pool;
+}
+
+HR_EXPORT void testIncrementalServers() {
+    const int minIdle = 2;
+
+    std::shared_ptr<TestTransportFactory> factory = std::shared_ptr<TestTransportFactory>(new TestTransportFactory);
+    Configuration config = createConfiguration(minIdle, UNLIMITED, UNLIMITED);
+    ConnectionPool* pool = new ConnectionPool(factory, config.getConnectionPoolConfiguration());
+
+    InetSocketAddress kept("127.0.0.1", 1024);
+    InetSocketAddress removed("127.0.0.1", 1025);
+    InetSocketAddress added("127.0.0.1", 1026);
+    pool->preparePool(kept);
+    pool->preparePool(removed);
+    TcpTransport& keptIdle = pool->borrowObject(kept);
+    pool->returnObject(kept, keptIdle);
+    TcpTransport& inFlight = pool->borrowObject(removed);
+    TcpTransport& inFlight2 = pool->borrowObject(removed);
+    assert(pool->getNumActive() == 2);
+
+    //the surviving server keeps its connections, the removed one drains
+    std::vector<InetSocketAddress> servers;
+    servers.push_back(kept);
+    pool->retainServers(servers);
+    assert(pool->getNumIdle(kept) == minIdle);
+    assert(pool->getNumIdle(removed) == 0);
+    assert(pool->getNumActive(removed) == 2);
+
+    //a drained connection is closed when it comes back, or when it's invalidated
+    pool->returnObject(removed, inFlight);
+    assert(pool->getNumActive(removed) == 1);
+    assert(pool->getNumIdle(removed) == 0);
+    pool->invalidateObject(removed, &inFlight2);
+    assert(pool->getNumActive() == 0);
+
+    //an added server has no connection until it's preconnected
+    pool->addServer(added);
+    assert(pool->getNumIdle(added) == 0);
+    assert(pool->resolveSlot(added));
+    pool->preconnect(added);
+    assert(pool->getNumIdle(added) == minIdle);
+    pool->preconnect(added);
+    assert(pool->getNumIdle(added) == minIdle);
+
+    //preconnecting a server removed meanwhile opens nothing
+    pool->clear(added);
+    pool->preconnect(added);
+    assert(pool->getNumIdle(added) == 0);
+    assert(pool->getNumIdle() == minIdle);
+
+    delete pool;
+}
@@ -0,0 +1,130 @@
+#include "hotrod/impl/Topology.h"
+#include "hotrod/impl/operations/OperationsFactory.h"
+#include "hotrod/impl/operations/GetOperation.h"
+#include "hotrod/impl/operations/PutOperation.h"
+#include "hotrod/impl/protocol/CodecFactory.h"
+#include "hotrod/impl/protocol/HotRodConstants.h"
+#include "hotrod/impl/transport/tcp/TcpTransport.h"
+#include "hotrod/sys/Log.h"
+#include "infinispan/hotrod/Configuration.h"
+#include "infinispan/hotrod/Flag.h"
+#include "infinispan/hotrod/ImportExport.h"
+
+#include <memory>
+#include <vector>
+
+using namespace infinispan::hotrod;
+using namespace infinispan::hotrod::operations;
+using namespace infinispan::hotrod::protocol;
+using namespace infinispan::hotrod::transport;
+
+extern volatile int passFail;
+
+namespace infinispan {
+namespace hotrod {
+namespace operations {
+
+// Runs the operations on a given transport, skipping the retries and the transport factory
+class OperationsTest {
+public:
+    static std::vector<char> execute(GetOperation& get, Transport& transport) {
+        return get.executeOperation(transport);
+    }
+};
+
+}}} // namespace infinispan::hotrod::operations
+
+// Swallows the requests and answers each of them with the header set by answer(), without a body
+class ScriptedTransport: public TcpTransport {
+
+public:
+    ScriptedTransport() : TcpTransport(), response(), next(0) {
+    }
+
+    void answer(uint8_t opRespCode, uint8_t status) {
+        response[0] = HotRodConstants::RESPONSE_MAGIC;
+        response[1] = opRespCode;
+        response[2] = status;
+        response[3] = 0;    // no topology change
+        next = 0;
+    }
+
+    void flush() {
+    }
+
+    void writeByte(uint8_t) {
+    }
+
+    void writeVInt(uint32_t) {
+    }
+
+    void writeVLong(uint64_t) {
+    }
+
+    void writeBytes(const std::vector<char>&) {
+    }
+
+    void writeBytes(const char*, unsigned int) {
+    }
+
+    uint8_t readByte() {
+        return response[next++ % sizeof(response)];
+    }
+
+    uint32_t readVInt() {
+        return 0;
+    }
+
+    // The message id, 0 is accepted for any request
+    uint64_t readVLong() {
+        return 0;
+    }
+
+    void release() {
+    }
+
+    void invalidate() {
+    }
+
+private:
+    uint8_t response[4];
+    size_t next;
+};
+
+/*
+ * Gets and puts built by the OperationsFactory as RemoteCacheImpl does, flags included, and run
+ * on a transport that answers without a value. Once the flags of the thread are warm nothing
+ * on the way allocates
+ */
+HR_EXPORT void allocationFreeOperationTest(unsigned long (*allocationCount)()) {
+    const int iterations = 1000;
+    Codec* codec = CodecFactory::getCodec(Configuration::PROTOCOL_VERSION_28);
+    OperationsFactory factory(std::shared_ptr<TransportFactory>(), "cache", false, *codec);
+    ScriptedTransport transport;
+    std::vector<char> key(8, 'k'), value(64, 'v');
+    unsigned long before = allocationCount();
+    for (int i = 0; i <= iterations; ++i) {
+        if (i == 1) {
+            before = allocationCount();
+        }
+        transport.answer(HotRodConstants::GET_RESPONSE, HotRodConstants::KEY_DOES_NOT_EXIST_STATUS);
+        GetOperation get = factory.newGetKeyOperation(key, nullptr);
+        bool missing = OperationsTest::execute(get, transport).empty();
+        factory.addFlags(DEFAULT_LIFESPAN);
+        factory.addFlags(DEFAULT_MAXIDLE);
+        transport.answer(HotRodConstants::PUT_RESPONSE, HotRodConstants::NO_ERROR_STATUS);
+        PutOperation put = factory.newPutKeyValueOperation(key, value, 0, 0, nullptr);
+        if (!missing || !put.executeOperation(transport).empty()) {
+            passFail = 1;
+            ERROR("allocationFreeOperationTest fail, unexpected responses");
+            return;
+        }
+    }
+    unsigned long allocations = allocationCount() - before;
+    if (allocations != 0) {
+        passFail = 1;
+        ERROR("allocationFreeOperationTest fail, %lu allocations for %d gets and puts", allocations, iterations);
+        return;
+    }
+    INFO("allocationFreeOperationTest passed");
+}
@@ -14,8 +14,24 @@
 #include "hotrod/impl/protocol/Codec20.h"
 #include "infinispan/hotrod/Configuration.h"
 #include "hotrod/impl/protocol/HeaderParams.h"
-
+#include "hotrod/impl/operations/HotRodOperation.h"
+#include "hotrod/impl/QueryResultCache.h"
+#include "hotrod/impl/consistenthash/SegmentConsistentHash.h"
+#include "hotrod/impl/TopologyInfo.h"
+#include "infinispan/hotrod/LatencyAwareBalancingStrategy.h"
+#include "infinispan/hotrod/ConfigurationBuilder.h"
+#include "infinispan/hotrod/BasicMarshaller.h"
+#include "infinispan/hotrod/ProtoStreamMarshaller.h"
+#include "infinispan/hotrod/QueryResultSet.h"
+#include "infinispan/hotrod/QueryCursor.h"
+#include "infinispan/hotrod/ProjectionColumns.h"
+#include "infinispan/hotrod/Transactions.h"
+
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <iterator>
 #include <sstream>
 #include <set>
@@ -60,6 +76,15 @@ public:
         UNUSED(var);
     }
 
+    void writeBytes(const std::vector<char>& bytes) {
+        UNUSED(bytes);
+    }
+
+    void writeBytes(const char* data, unsigned int size) {
+        UNUSED(data);
+        UNUSED(size);
+    }
+
     uint8_t readByte() {
         return 0;
     }
@@ -121,6 +146,22 @@ private:
     Codec20 *testedCodec;
 };
 
+class HeaderOnlyOperation : public infinispan::hotrod::operations::HotRodOperation<uint64_t> {
+
+public:
+    HeaderOnlyOperation(const Codec& codec, const std::vector<char>& cacheName, Topology& topology, Transport& t) :
+            HotRodOperation<uint64_t>(codec, 0, cacheName, topology, nullptr), transport(t) {
+    }
+
+    uint64_t execute() {
+        HeaderParams params = writeHeader(transport, HotRodConstants::GET_REQUEST);
+        return params.getMessageId();
+    }
+
+private:
+    Transport& transport;
+};
+
 class Sleeper : public Runnable {
   public:
     Sleeper(std::string name, unsigned len, int &s) : me(name), sleepTime(len), status(s) {}
@@ -494,3 +535,707 @@ HR_EXPORT void runConcurrentCodecWritesTest() {
     testedCodec = NULL;
     INFO("runConcurrentCodecWritesTest test passed");
 }
+
+HR_EXPORT void allocationFreeHeaderTest(unsigned long (*allocationCount)()) {
+    const int iterations = 1000;
+    std::vector<char> cacheName(4, 'c');
+    Topology topology(0);
+    TestTransport transport;
+    Codec* codec = CodecFactory::getCodec(Configuration::PROTOCOL_VERSION_28);
+
+    unsigned long before = allocationCount();
+    for (int i = 0; i < iterations; ++i) {
+        HeaderOnlyOperation op(*codec, cacheName, topology, transport);
+        op.execute();
+    }
+    unsigned long allocations = allocationCount() - before;
+    if (allocations != 0) {
+        passFail = 1;
+        ERROR("allocationFreeHeaderTest fail, %lu allocations for %d operations", allocations, iterations);
+        return;
+    }
+    INFO("allocationFreeHeaderTest passed");
+}
+
+// Keeps each write it is handed, in order
+class RecordingSocket : public infinispan::hotrod::sys::Socket {
+  public:
+    void connect(const std::string&, int, int) {}
+    void close() {}
+    void setTcpNoDelay(bool) {}
+    void setTimeout(int) {}
+    size_t read(char *, size_t) { return 0; }
+    void write(const char *p, size_t n) { writes.push_back(std::vector<char>(p, p + n)); sources.push_back(p); }
+    int getSocket() { return 0; }
+    std::vector<std::vector<char> > writes;
+    std::vector<const char*> sources;
+};
+
+HR_EXPORT void outputStreamTest() {
+    const size_t directWriteSize = 64 * 1024;
+    std::vector<char> header(10, 'h');
+    for (size_t size = directWriteSize - 1; size <= directWriteSize + 1; ++size) {
+        RecordingSocket* recorder = new RecordingSocket();
+        infinispan::hotrod::transport::Socket socket(recorder);
+        OutputStream& out = socket.getOutputStream();
+        std::vector<char> value(size, 'v');
+        out.write(header.data(), header.size());
+        out.write(value.data(), value.size());
+        out.write('t');
+        bool direct = size >= directWriteSize;
+        // A direct write sends the buffered header first, then the value from the caller's memory
+        bool ok = recorder->writes.size() == (direct ? 2u : 0u);
+        out.flush();
+        out.flush();
+        std::vector<char> sent;
+        for (const std::vector<char>& w : recorder->writes) {
+            sent.insert(sent.end(), w.begin(), w.end());
+        }
+        std::vector<char> expected(header);
+        expected.insert(expected.end(), value.begin(), value.end());
+        expected.push_back('t');
+        if (direct) {
+            ok = ok && recorder->writes.size() == 3 && recorder->writes[0] == header
+                    && recorder->sources[1] == value.data() && recorder->writes[1].size() == size;
+        } else {
+            ok = ok && recorder->writes.size() == 1;
+        }
+        if (!ok || sent != expected) {
+            passFail = 1;
+            ERROR("outputStreamTest fail for a %lu bytes value, %lu socket writes", (unsigned long) size,
+                    (unsigned long) recorder->writes.size());
+            return;
+        }
+    }
+    INFO("outputStreamTest passed");
+}
+
+// A first generation marshaller, only implementing the vector based interface
+class LegacyIntMarshaller : public infinispan::hotrod::Marshaller<int> {
+  public:
+    void marshall(const int& i, std::vector<char>& b) {
+        std::ostringstream os;
+        os << i;
+        std::string str = os.str();
+        b.assign(str.begin(), str.end());
+    }
+    int* unmarshall(const std::vector<char>& b) {
+        return new int(std::atoi(std::string(b.data(), b.size()).c_str()));
+    }
+};
+
+HR_EXPORT void bufferMarshallerTest(unsigned long (*allocationCount)()) {
+    BasicMarshaller<std::string> sm;
+    std::vector<char> buf;
+    sm.marshallInto(std::string("abc"), buf);
+    sm.marshallInto(std::string("def"), buf);
+    std::string s = sm.unmarshallValue(buf.data() + 3, 3);
+    if (std::string(buf.data(), buf.size()) != "abcdef" || s != "def") {
+        passFail = 1;
+        ERROR("bufferMarshallerTest fail, string append or view decoding is wrong");
+        return;
+    }
+
+    LegacyIntMarshaller legacy;
+    BufferMarshallerAdapter<int> adapted(legacy);
+    buf.assign(1, '#');
+    adapted.marshallInto(42, buf);
+    int i = 0;
+    adapted.unmarshallInto(buf.data() + 1, buf.size() - 1, i);
+    int j = 0;
+    std::vector<char> legacyBytes(buf.begin() + 1, buf.end());
+    if (std::string(buf.data(), buf.size()) != "#42" || i != 42
+            || !unmarshallInto<int>(legacy, legacyBytes, j) || j != 42) {
+        passFail = 1;
+        ERROR("bufferMarshallerTest fail, adapted marshaller doesn't round trip");
+        return;
+    }
+
+    // Once the pool is warm, leasing and decoding into existing storage doesn't allocate
+    BasicMarshaller<long> lm;
+    long l = 0;
+    lm.marshall(7L, buf);
+    {
+        ScratchBuffer warmup;
+        lm.marshallInto(l, warmup.get());
+    }
+    unsigned long before = allocationCount();
+    for (int n = 0; n < 1000; ++n) {
+        ScratchBuffer scratch;
+        lm.marshallInto(l, scratch.get());
+        lm.unmarshallInto(buf.data(), buf.size(), l);
+    }
+    unsigned long allocations = allocationCount() - before;
+    if (allocations != 0 || l != 7L) {
+        passFail = 1;
+        ERROR("bufferMarshallerTest fail, %lu allocations with pooled buffers", allocations);
+        return;
+    }
+
+    // A view of another size can't be copied into the type
+    try {
+        lm.unmarshallInto(buf.data(), buf.size() - 1, l);
+        passFail = 1;
+        ERROR("bufferMarshallerTest fail, short data not detected");
+        return;
+    } catch (const HotRodClientException&) {
+    }
+    INFO("bufferMarshallerTest passed");
+}
+
+HR_EXPORT void protoStreamMarshallerTest() {
+    // Any message will do as payload, the envelope itself is handy
+    WrappedMessage inner;
+    inner.set_wrappedstring(std::string(1000, 'x'));
+    inner.set_wrappedint64(-1);
+
+    // Reference encoding, built the way the two-pass marshaller did it
+    WrappedMessage wm;
+    wm.set_wrappedmessagebytes(inner.SerializeAsString());
+    wm.set_wrappeddescriptorid(1000042);
+    std::string expected = wm.SerializeAsString();
+
+    ProtoStreamMarshaller<WrappedMessage> m;
+    std::vector<char> buf;
+    m.marshall(inner, buf);
+    if (std::string(buf.data(), buf.size()) != expected) {
+        passFail = 1;
+        ERROR("protoStreamMarshallerTest fail, envelope differs from the WrappedMessage encoding");
+        return;
+    }
+
+    // Field order shouldn't matter to the decoder
+    WrappedMessage reordered;
+    reordered.set_wrappeddescriptorid(1000042);
+    std::string reorderedBytes = reordered.SerializeAsString() + wm.SerializeAsString();
+    WrappedMessage decoded;
+    m.unmarshallInto(reorderedBytes.data(), reorderedBytes.size(), decoded);
+    std::unique_ptr<WrappedMessage> p(m.unmarshall(buf));
+    if (decoded.wrappedstring() != inner.wrappedstring() || decoded.wrappedint64() != -1
+            || p->wrappedstring() != inner.wrappedstring()) {
+        passFail = 1;
+        ERROR("protoStreamMarshallerTest fail, decoded message differs");
+        return;
+    }
+    INFO("protoStreamMarshallerTest passed");
+}
+
+HR_EXPORT void queryResultSetTest() {
+    using org::infinispan::query::remote::client::QueryResponse;
+    // Entities are WrappedMessages too, any message will do
+    const int rows = 100;
+    ProtoStreamMarshaller<WrappedMessage> m;
+    QueryResponse source;
+    source.set_numresults(rows);
+    source.set_projectionsize(0);
+    source.set_totalresults(rows * 2);
+    std::vector<char> buf;
+    for (int i = 0; i < rows; ++i) {
+        WrappedMessage entity;
+        entity.set_wrappedint32(i);
+        entity.set_wrappedstring(std::string(64, 'a' + i % 26));
+        m.marshall(entity, buf);
+        source.add_results()->set_wrappedbytes(buf.data(), buf.size());
+    }
+    std::string bytes = source.SerializeAsString();
+
+    QueryResultSet<WrappedMessage> results(4096);
+    QueryResponse* resp = google::protobuf::Arena::CreateMessage<QueryResponse>(&results.getArena());
+    resp->ParseFromString(bytes);
+    if (!results.unwrap(resp) || results.size() != rows || results.getTotalResults() != rows * 2) {
+        passFail = 1;
+        ERROR("queryResultSetTest fail, %d entities unwrapped", results.size());
+        return;
+    }
+    int i = 0;
+    for (const WrappedMessage& entity : results) {
+        if (entity.wrappedint32() != i || entity.wrappedstring() != std::string(64, 'a' + i % 26)
+                || entity.GetArena() != &results.getArena()) {
+            passFail = 1;
+            ERROR("queryResultSetTest fail, entity %d differs or isn't on the result set arena", i);
+            return;
+        }
+        ++i;
+    }
+
+    INFO("queryResultSetTest passed");
+}
+
+// Serves a result set of totalRows WrappedMessage entities, honouring startOffset and maxResults
+class PagingFetcher {
+  public:
+    PagingFetcher(int totalRows, std::vector<int64_t>& offsets, std::mutex& lock) :
+        totalRows(totalRows), offsets(offsets), lock(lock) {}
+
+    const org::infinispan::query::remote::client::QueryResponse* operator()(
+            const org::infinispan::query::remote::client::QueryRequest& qr, google::protobuf::Arena& arena) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            offsets.push_back(qr.startoffset());
+        }
+        org::infinispan::query::remote::client::QueryResponse* resp =
+                google::protobuf::Arena::CreateMessage<org::infinispan::query::remote::client::QueryResponse>(&arena);
+        ProtoStreamMarshaller<WrappedMessage> m;
+        std::vector<char> buf;
+        int64_t end = std::min<int64_t>(totalRows, qr.startoffset() + qr.maxresults());
+        for (int64_t i = qr.startoffset(); i < end; ++i) {
+            WrappedMessage entity;
+            entity.set_wrappedint64(i);
+            m.marshall(entity, buf);
+            resp->add_results()->set_wrappedbytes(buf.data(), buf.size());
+        }
+        resp->set_numresults(resp->results_size());
+        resp->set_projectionsize(0);
+        resp->set_totalresults(totalRows);
+        return resp;
+    }
+
+  private:
+    int totalRows;
+    std::vector<int64_t>& offsets;
+    std::mutex& lock;
+};
+
+static bool checkCursor(const char* name, int totalRows, int pageSize, int64_t startOffset, int maxResults,
+        const std::vector<int64_t>& expectedOffsets) {
+    std::vector<int64_t> offsets;
+    std::mutex lock;
+    org::infinispan::query::remote::client::QueryRequest qr;
+    qr.set_querystring("from Entity");
+    if (startOffset > 0) {
+        qr.set_startoffset(startOffset);
+    }
+    if (maxResults >= 0) {
+        qr.set_maxresults(maxResults);
+    }
+    int64_t expected = startOffset;
+    int64_t last = maxResults >= 0 ? std::min<int64_t>(totalRows, startOffset + maxResults) : totalRows;
+    {
+        QueryCursor<WrappedMessage> cursor(PagingFetcher(totalRows, offsets, lock), qr, pageSize);
+        while (cursor.hasNext()) {
+            const WrappedMessage& entity = cursor.next();
+            if (entity.wrappedint64() != expected || cursor.currentPage()->size() > pageSize) {
+                passFail = 1;
+                ERROR("queryCursorTest %s fail, got entity %lld, expected %lld", name, (long long) entity.wrappedint64(), (long long) expected);
+                return false;
+            }
+            ++expected;
+        }
+    }
+    if (expected != last || offsets != expectedOffsets) {
+        passFail = 1;
+        ERROR("queryCursorTest %s fail, iterated up to %lld with %d fetches", name, (long long) expected, (int) offsets.size());
+        return false;
+    }
+    return true;
+}
+
+// The pages are fetched on one thread, and a failed fetch is thrown by every later call
+static bool checkCursorFailure() {
+    std::vector<int64_t> offsets;
+    std::mutex lock;
+    std::set<std::thread::id> threads;
+    PagingFetcher pages(25, offsets, lock);
+    org::infinispan::query::remote::client::QueryRequest qr;
+    qr.set_querystring("from Entity");
+    int read = 0, thrown = 0;
+    {
+        QueryCursor<WrappedMessage> cursor([&](const org::infinispan::query::remote::client::QueryRequest& pageRequest,
+                google::protobuf::Arena& arena) -> const org::infinispan::query::remote::client::QueryResponse* {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                threads.insert(std::this_thread::get_id());
+            }
+            if (pageRequest.startoffset() >= 20) {
+                throw HotRodClientException("page lost");
+            }
+            return pages(pageRequest, arena);
+        }, qr, 10);
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            try {
+                while (cursor.hasNext()) {
+                    cursor.next();
+                    ++read;
+                }
+            } catch (const HotRodClientException&) {
+                ++thrown;
+            }
+        }
+    }
+    if (read != 20 || thrown != 2 || threads.size() != 1 || threads.count(std::this_thread::get_id()) != 0) {
+        passFail = 1;
+        ERROR("queryCursorTest failure fail, read %d entities, %d exceptions, %d fetch threads", read, thrown, (int) threads.size());
+        return false;
+    }
+    return true;
+}
+
+HR_EXPORT void queryCursorTest() {
+    if (!checkCursor("unbounded", 25, 10, 0, -1, {0, 10, 20})
+            || !checkCursor("exact pages", 20, 10, 0, -1, {0, 10})
+            || !checkCursor("bounded", 25, 10, 2, 15, {2, 12})
+            || !checkCursor("empty", 0, 10, 0, -1, {0})
+            || !checkCursorFailure()) {
+        return;
+    }
+    INFO("queryCursorTest passed");
+}
+
+HR_EXPORT void projectionColumnsTest() {
+    const int rows = 1000;
+    org::infinispan::query::remote::client::QueryResponse resp;
+    resp.set_numresults(rows);
+    resp.set_projectionsize(3);
+    resp.set_totalresults(rows);
+    for (int i = 0; i < rows; ++i) {
+        resp.add_results()->set_wrappedint32(i);
+        WrappedMessage* d = resp.add_results();
+        if (i % 10 != 0) {  // every tenth row is null
+            d->set_wrappeddouble(i / 2.0);
+        }
+        resp.add_results()->set_wrappedstring(std::to_string(i));
+    }
+
+    ProjectionColumns columns;
+    if (!columns.unwrap(resp) || columns.getColumnCount() != 3 || columns.getRowCount() != (size_t) rows
+            || columns.getType(0) != ProjectionColumns::INTEGER || columns.getType(1) != ProjectionColumns::FLOATING
+            || columns.getType(2) != ProjectionColumns::STRING) {
+        passFail = 1;
+        ERROR("projectionColumnsTest fail, wrong shape");
+        return;
+    }
+    const std::vector<int64_t>& ids = columns.getIntegers(0);
+    const std::vector<double>& halves = columns.getDoubles(1);
+    const StringColumn& names = columns.getStrings(2);
+    for (int i = 0; i < rows; ++i) {
+        bool null = i % 10 == 0;
+        if (ids[i] != i || columns.isNull(1, i) != null || halves[i] != (null ? 0 : i / 2.0)
+                || names.get(i) != std::to_string(i)) {
+            passFail = 1;
+            ERROR("projectionColumnsTest fail, row %d differs", i);
+            return;
+        }
+    }
+
+    resp.mutable_results(2)->set_wrappedint64(1);
+    try {
+        columns.unwrap(resp);
+        passFail = 1;
+        ERROR("projectionColumnsTest fail, mixed types not detected");
+        return;
+    } catch (const HotRodClientException&) {
+    }
+    INFO("projectionColumnsTest passed");
+}
+
+HR_EXPORT void queryResultCacheTest() {
+    QueryResultCache cache(std::chrono::milliseconds(200), 2);
+    std::vector<char> r1(10, '1'), r2(10, '2'), r3(10, '3'), out;
+    bool ok = !cache.get("q1", out);
+    cache.put("q1", r1, cache.generation());
+    ok = ok && cache.get("q1", out) && out == r1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    cache.put("q2", r2, cache.generation());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // Full, q1 is the first to expire and makes room
+    cache.put("q3", r3, cache.generation());
+    ok = ok && !cache.get("q1", out) && cache.get("q2", out) && out == r2 && cache.get("q3", out) && out == r3;
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    ok = ok && !cache.get("q3", out);
+    cache.put("q3", r3, cache.generation());
+    cache.clear();
+    ok = ok && !cache.get("q3", out);
+    // A response fetched before a clear isn't stored after it
+    uint64_t generation = cache.generation();
+    cache.clear();
+    cache.put("q1", r1, generation);
+    ok = ok && !cache.get("q1", out);
+
+    std::map<std::string, std::string> stats;
+    cache.stats(stats);
+    if (!ok || stats["queryCacheHits"] != "3" || stats["queryCacheMisses"] != "5") {
+        passFail = 1;
+        ERROR("queryResultCacheTest fail, %s hits, %s misses", stats["queryCacheHits"].c_str(), stats["queryCacheMisses"].c_str());
+        return;
+    }
+    INFO("queryResultCacheTest passed");
+}
+
+HR_EXPORT void transactionContextTest() {
+    ByteVectorHash hash;
+    std::vector<char> ab = { 'a', 'b' }, ba = { 'b', 'a' }, zero = { 'a', 'b', '\0' };
+    if (hash(ab) != hash(std::vector<char>(ab)) || hash(ab) == hash(ba) || hash(ab) == hash(zero)) {
+        passFail = 1;
+        ERROR("transactionContextTest fail, bad hash");
+        return;
+    }
+    // Keys that differ only by trailing zeros or order must be distinct entries
+    std::function<void (const void *)> deleter = [](const void* v) { delete (const int*) v; };
+    int marshallerCalls = 0;
+    std::function<void (const void *, std::vector<char>&)> marshaller = [&marshallerCalls](const void* v, std::vector<char>& b) {
+        marshallerCalls++;
+        const char* p = (const char*) v;
+        b.assign(p, p + sizeof(int));
+    };
+    TransactionContext tc;
+    std::vector<std::vector<char> > keys;
+    for (int i = 0; i < 1000; i++) {
+        std::vector<char> key(i % 7, '\0');
+        std::string n = std::to_string(i / 7);
+        key.insert(key.begin(), n.begin(), n.end());
+        keys.push_back(key);
+        MetadataValue meta;
+        if (i % 2) {
+            tc.addValue(key, new int(i), meta, deleter, marshaller);
+        } else {
+            std::vector<char> bytes((char*) &i, (char*) &i + sizeof(int));
+            tc.addValue(key, new int(i), std::move(bytes), meta, deleter, marshaller);
+        }
+    }
+    bool ok = tc.size() == 1000 && marshallerCalls == 500 && tc.isReadOnly();
+    for (int i = 0; ok && i < 1000; i++) {
+        const int* v = (const int*) tc.getValue(keys[i]);
+        ok = tc.hasValue(keys[i]) && v && *v == i
+                && tc.getEntry(keys[i]).marshalledValue == std::vector<char>((char*) &i, (char*) &i + sizeof(int));
+    }
+    tc.setValueAsDeleted(keys[3]);
+    tc.removeEntry(keys[4]);
+    ok = ok && tc.isDeleted(keys[3]) && tc.getValue(keys[3]) == nullptr && tc.getEntry(keys[3]).marshalledValue.empty()
+            && !tc.hasValue(keys[4]) && tc.size() == 999 && !tc.isReadOnly();
+    tc.clear();
+    if (!ok || tc.size() != 0) {
+        passFail = 1;
+        ERROR("transactionContextTest fail");
+        return;
+    }
+    INFO("transactionContextTest passed");
+}
+
+HR_EXPORT void segmentRoutingTest() {
+    InetSocketAddress a("a", 11222), b("b", 11222), c("c", 11222);
+    const uint32_t numSegments = 60;
+    std::vector<std::vector<InetSocketAddress> > segmentOwners(numSegments);
+    for (uint32_t s = 0; s < numSegments; s++) {
+        InetSocketAddress* owners[] = { &a, &b, &c };
+        segmentOwners[s].push_back(*owners[s % 3]);
+        segmentOwners[s].push_back(*owners[(s + 1) % 3]);
+    }
+    consistenthash::SegmentConsistentHash hash;
+    hash.init(segmentOwners, numSegments);
+    const std::vector<InetSocketAddress>& servers = hash.getServerList();
+    if (servers.size() != 3 || !(servers[0] == a) || !(servers[1] == b) || !(servers[2] == c)) {
+        passFail = 1;
+        ERROR("segmentRoutingTest fail, %d servers", (int) servers.size());
+        return;
+    }
+    uint32_t segmentSize = 0x7FFFFFFFUL / numSegments + 1;
+    std::vector<std::vector<char> > keys;
+    for (int i = 0; i < 1000; i++) {
+        std::string k = "key" + std::to_string(i);
+        std::vector<char> key(k.begin(), k.end());
+        uint32_t segment = hash.getNormalizedHash(key) / segmentSize;
+        int32_t index = hash.getServerIndex(key);
+        if (index < 0 || !(servers[index] == segmentOwners[segment][0]) || !(hash.getServer(key) == servers[index])) {
+            passFail = 1;
+            ERROR("segmentRoutingTest fail, %s routed to %d", k.c_str(), index);
+            return;
+        }
+        keys.push_back(key);
+    }
+    // A batch routes every key as getServerIndex() does
+    std::vector<const std::vector<char>*> batch;
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch.push_back(&keys[i]);
+    }
+    std::vector<int32_t> indexes(batch.size());
+    hash.getServerIndexes(batch.data(), batch.size(), indexes.data());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (indexes[i] != hash.getServerIndex(keys[i])) {
+            passFail = 1;
+            ERROR("segmentRoutingTest fail, key %d routed to %d in a batch", (int) i, indexes[i]);
+            return;
+        }
+    }
+    const uint16_t* owners = nullptr;
+    std::vector<char> someKey(3, 'k');
+    if (hash.getOwnerIndexes(someKey, owners) != 2 || owners[0] != hash.getServerIndex(someKey)
+            || !(servers[owners[1]] == segmentOwners[hash.getNormalizedHash(someKey) / segmentSize][1])) {
+        passFail = 1;
+        ERROR("segmentRoutingTest fail, wrong owners");
+        return;
+    }
+    consistenthash::ConsistentHash& ch = hash;
+    if (ch.getSegmentsByServers()[b].size() != 2 * numSegments / 3) {
+        passFail = 1;
+        ERROR("segmentRoutingTest fail, wrong segments by server");
+        return;
+    }
+    // Fewer owner lists than segments, the hash space is still split in numSegments and the
+    // keys of the segments without owners aren't routed
+    consistenthash::SegmentConsistentHash partial;
+    std::vector<std::vector<InetSocketAddress> > firstHalf(segmentOwners.begin(), segmentOwners.begin() + numSegments / 2);
+    partial.init(firstHalf, numSegments);
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint32_t segment = partial.getNormalizedHash(keys[i]) / segmentSize;
+        int32_t index = partial.getServerIndex(keys[i]);
+        bool routed = index >= 0 && partial.getServerList()[index] == segmentOwners[segment][0];
+        if (segment < numSegments / 2 ? !routed : index != -1 || partial.getOwnerIndexes(keys[i], owners) != 0) {
+            passFail = 1;
+            ERROR("segmentRoutingTest fail, key %d of segment %u routed to %d with half the owners", (int) i, segment, index);
+            return;
+        }
+    }
+    consistenthash::SegmentConsistentHash noSegments;
+    noSegments.init(std::vector<std::vector<InetSocketAddress> >(), 0);
+    InetSocketAddress none = noSegments.getServer(std::vector<char>(3, 'k'));
+    if (noSegments.getServerIndex(std::vector<char>(3, 'k')) != -1 || !none.isEmpty()) {
+        passFail = 1;
+        ERROR("segmentRoutingTest fail, a topology without segments routed a key");
+        return;
+    }
+    INFO("segmentRoutingTest passed");
+}
+
+HR_EXPORT void topologySnapshotTest() {
+    InetSocketAddress a("a", 11222), b("b", 11222);
+    std::vector<InetSocketAddress> servers;
+    servers.push_back(a);
+    servers.push_back(b);
+    Configuration conf = ConfigurationBuilder().build();
+    TopologyInfo topologyInfo(servers, conf);
+    const std::vector<char> cacheName(5, 'c');
+
+    topologyInfo.createTopologyId(cacheName, -1);
+    std::shared_ptr<const TopologyInfo::CacheTopology> before = topologyInfo.getCacheTopology(cacheName);
+    if (!before || before->topologyId != -1 || before->hash || before->segmentsByServer.size() != 2
+            || topologyInfo.getTopologyId(std::vector<char>(1, 'x')) != 0) {
+        passFail = 1;
+        ERROR("topologySnapshotTest fail, wrong initial topology");
+        return;
+    }
+
+    // Readers keep going while the topology changes under them
+    std::atomic<bool> done(false);
+    std::atomic<int> inconsistent(0);
+    std::thread reader([&]() {
+        while (!done) {
+            std::shared_ptr<const TopologyInfo::CacheTopology> t = topologyInfo.getCacheTopology(cacheName);
+            if (t->hash && t->hash->getSegmentsByServers() != t->segmentsByServer) {
+                inconsistent++;
+            }
+        }
+    });
+    uint8_t hashVersion = 3;
+    for (int id = 1; id <= 50; id++) {
+        uint32_t numSegments = 10 + id;
+        std::vector<std::vector<InetSocketAddress> > owners(numSegments);
+        for (uint32_t i = 0; i < numSegments; i++) {
+            owners[i].push_back(i % 2 ? a : b);
+        }
+        topologyInfo.updateTopology(owners, numSegments, hashVersion, cacheName, id);
+    }
+    done = true;
+    reader.join();
+
+    std::shared_ptr<const TopologyInfo::CacheTopology> after = topologyInfo.getCacheTopology(cacheName);
+    CacheTopologyInfo info = topologyInfo.getCacheTopologyInfo(cacheName);
+    if (inconsistent != 0 || before->topologyId != -1 || before->hash || after->topologyId != 50
+            || topologyInfo.getTopologyId(cacheName) != 50 || info.getNumSegment() != 60
+            || info.getSegmentPerServer()[a].size() != 30 || topologyInfo.createTopologyId(cacheName, -1) != -1
+            || topologyInfo.getTopologyId(cacheName) != 50) {
+        passFail = 1;
+        ERROR("topologySnapshotTest fail, %d inconsistent reads, topology id %d", inconsistent.load(), after->topologyId);
+        return;
+    }
+
+    // Keys are grouped by primary owner, the keys of an unknown cache all go to the last bucket
+    std::vector<std::vector<char> > keys;
+    std::vector<const std::vector<char>*> batch;
+    for (int i = 0; i < 100; i++) {
+        std::string k = "key" + std::to_string(i);
+        keys.push_back(std::vector<char>(k.begin(), k.end()));
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch.push_back(&keys[i]);
+    }
+    std::vector<std::vector<size_t> > buckets = topologyInfo.routeKeys(batch.data(), batch.size(), cacheName);
+    std::vector<std::vector<size_t> > unknown = topologyInfo.routeKeys(batch.data(), batch.size(), std::vector<char>(1, 'x'));
+    size_t routed = 0;
+    for (size_t s = 0; s + 1 < buckets.size(); s++) {
+        for (size_t i : buckets[s]) {
+            routed += after->hash->getServerList()[s] == topologyInfo.getHashAwareServer(keys[i], cacheName);
+        }
+    }
+    if (buckets.size() != 3 || routed != keys.size() || unknown.size() != 1 || unknown[0].size() != keys.size()) {
+        passFail = 1;
+        ERROR("topologySnapshotTest fail, %d keys routed in %d buckets", (int) routed, (int) buckets.size());
+        return;
+    }
+    INFO("topologySnapshotTest passed");
+}
+
+HR_EXPORT void latencyAwareBalancingTest() {
+    InetSocketAddress a("a", 11222), b("b", 11222), c("c", 11222), unknown("d", 11222);
+    std::vector<InetSocketAddress> servers;
+    servers.push_back(a);
+    servers.push_back(b);
+    servers.push_back(c);
+    LatencyAwareBalancingStrategy balancer;
+    balancer.setServers(servers);
+    std::set<InetSocketAddress> noFailures;
+
+    // a is slow: two choices among three servers always include a faster one
+    for (int i = 0; i < 10; i++) {
+        balancer.requestCompleted(a, 50000000, false);
+        balancer.requestCompleted(b, 1000000, false);
+        balancer.requestCompleted(c, 1000000, false);
+    }
+    balancer.requestCompleted(unknown, 1, false);
+    for (int i = 0; i < 1000; i++) {
+        if (balancer.nextServer(noFailures) == a) {
+            passFail = 1;
+            ERROR("latencyAwareBalancingTest fail, the slow server was chosen");
+            return;
+        }
+    }
+
+    // Requests in flight make b cost more than c
+    for (int i = 0; i < 5; i++) {
+        balancer.requestStarted(b);
+    }
+    std::set<InetSocketAddress> slow;
+    slow.insert(a);
+    int toB = 0;
+    for (int i = 0; i < 1000; i++) {
+        toB += balancer.nextServer(slow) == b;
+    }
+    if (toB != 0 || balancer.getInFlight(b) != 5) {
+        passFail = 1;
+        ERROR("latencyAwareBalancingTest fail, %d requests to the loaded server", toB);
+        return;
+    }
+
+    // Failed servers are never chosen, the stats survive setServers()
+    std::set<InetSocketAddress> failed;
+    failed.insert(b);
+    failed.insert(c);
+    uint64_t latencyOfB = balancer.getAverageLatency(b);
+    servers.pop_back();
+    balancer.setServers(servers);
+    bool failedAll = false;
+    try {
+        balancer.nextServer(failed);
+        failed.insert(a);
+        balancer.nextServer(failed);
+    } catch (const HotRodClientException&) {
+        failedAll = true;
+    }
+    if (!failedAll || !(balancer.nextServer(std::set<InetSocketAddress>()) == b)
+            || balancer.getAverageLatency(b) > latencyOfB || balancer.getAverageLatency(b) < latencyOfB / 2
+            || balancer.getInFlight(b) != 5 || balancer.getAverageLatency(c) != 0) {
+        passFail = 1;
+        ERROR("latencyAwareBalancingTest fail, wrong choice after a server change");
+        return;
+    }
+    INFO("latencyAwareBalancingTest passed");
+}
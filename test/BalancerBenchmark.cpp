@@ -0,0 +1,147 @@
+/*
+ * BalancerBenchmark.cpp
+ *
+ * Simulates closed loop clients sending requests to a cluster where one server
+ * stops for a GC pause at regular intervals, and compares the latencies seen with
+ * round robin balancing and with LatencyAwareBalancingStrategy. The servers are
+ * simulated, time is virtual. Doesn't need a server.
+ *
+ * usage: balancerBenchmark [requests]
+ */
+#include "infinispan/hotrod/LatencyAwareBalancingStrategy.h"
+#include "infinispan/hotrod/exceptions.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+using namespace infinispan::hotrod;
+using infinispan::hotrod::transport::InetSocketAddress;
+
+// The baseline: the same policy as the default strategy of the client
+class RoundRobin : public FailOverRequestBalancingStrategy {
+  public:
+    RoundRobin() : index(0) {}
+    void setServers(const std::vector<InetSocketAddress>& s) { servers = s; }
+    const InetSocketAddress& nextServer(const std::set<InetSocketAddress>&) {
+        index = (index + 1) % servers.size();
+        return servers[index];
+    }
+  private:
+    std::vector<InetSocketAddress> servers;
+    size_t index;
+};
+
+// A server with a few workers, an exponential service time and optional GC pauses
+struct FakeServer {
+    std::vector<uint64_t> workerFree;
+    uint64_t pausePeriod;
+    uint64_t pauseLength;
+
+    FakeServer(int workers, uint64_t pausePeriod, uint64_t pauseLength)
+      : workerFree(workers, 0), pausePeriod(pausePeriod), pauseLength(pauseLength) {}
+
+    uint64_t serve(uint64_t arrival, uint64_t service) {
+        std::vector<uint64_t>::iterator worker = std::min_element(workerFree.begin(), workerFree.end());
+        uint64_t start = std::max(arrival, *worker);
+        if (pausePeriod > 0 && start % pausePeriod < pauseLength) {
+            start += pauseLength - start % pausePeriod;
+        }
+        *worker = start + service;
+        return *worker;
+    }
+};
+
+struct Completion {
+    uint64_t time;
+    uint64_t sent;
+    int client;
+    int server;
+    bool operator>(const Completion& o) const { return time > o.time; }
+};
+
+static void simulate(const char* name, FailOverRequestBalancingStrategy& strategy, int requests) {
+    const int numServers = 4, clients = 32, workers = 4;
+    const uint64_t meanService = 500000;             // 0.5 ms
+    std::vector<InetSocketAddress> addresses;
+    std::vector<FakeServer> servers;
+    for (int i = 0; i < numServers; i++) {
+        addresses.push_back(InetSocketAddress("127.0.0.1", 11222 + i));
+        // Server 0 stops 50 ms every 250 ms
+        servers.push_back(FakeServer(workers, i == 0 ? 250000000 : 0, i == 0 ? 50000000 : 0));
+    }
+    strategy.setServers(addresses);
+
+    std::mt19937_64 random(42);
+    std::exponential_distribution<double> serviceTime(1.0 / meanService);
+    std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion> > events;
+    std::set<InetSocketAddress> noFailures;
+    std::vector<uint64_t> latencies;
+    std::vector<int> served(numServers, 0);
+    latencies.reserve(requests);
+
+    std::function<void(int, uint64_t)> send = [&](int client, uint64_t now) {
+        const InetSocketAddress& target = strategy.nextServer(noFailures);
+        int s = (int) (std::find(addresses.begin(), addresses.end(), target) - addresses.begin());
+        strategy.requestStarted(addresses[s]);
+        Completion c = { servers[s].serve(now, (uint64_t) serviceTime(random)), now, client, s };
+        events.push(c);
+    };
+    for (int c = 0; c < clients; c++) {
+        send(c, 0);
+    }
+    while ((int) latencies.size() < requests) {
+        Completion c = events.top();
+        events.pop();
+        uint64_t latency = c.time - c.sent;
+        strategy.requestCompleted(addresses[c.server], latency, false);
+        latencies.push_back(latency);
+        served[c.server]++;
+        send(c.client, c.time);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (size_t i = 0; i < latencies.size(); i++) {
+        sum += latencies[i];
+    }
+    std::cout << name << " mean " << sum / latencies.size() / 1000 << " us"
+              << ", p50 " << latencies[latencies.size() / 2] / 1000 << " us"
+              << ", p99 " << latencies[latencies.size() * 99 / 100] / 1000 << " us"
+              << ", p99.9 " << latencies[latencies.size() * 999 / 1000] / 1000 << " us"
+              << ", slow server share " << 100.0 * served[0] / requests << "%" << std::endl;
+}
+
+template <class F> static double nanosPerOp(int iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        f();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    int requests = argc > 1 ? atoi(argv[1]) : 200000;
+    std::cout << requests << " requests, 4 servers, one pausing 50 ms every 250 ms" << std::endl;
+
+    RoundRobin roundRobin;
+    simulate("round robin  ", roundRobin, requests);
+    LatencyAwareBalancingStrategy latencyAware;
+    simulate("latency aware", latencyAware, requests);
+
+    // The cost of a pick with its feedback, on the real clock
+    std::set<InetSocketAddress> noFailures;
+    double pick = nanosPerOp(requests, [&]() {
+        const InetSocketAddress& s = latencyAware.nextServer(noFailures);
+        latencyAware.requestStarted(s);
+        latencyAware.requestCompleted(s, 500000, false);
+    });
+    std::cout << "latency aware pick and feedback " << pick << " ns/op" << std::endl;
+    return 0;
+}
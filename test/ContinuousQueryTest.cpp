@@ -16,10 +16,13 @@
 #include "infinispan/hotrod/QueryUtils.h"
 #include "infinispan/hotrod/CacheClientListener.h"
 #include "infinispan/hotrod/ContinuousQueryListener.h"
+#include "infinispan/hotrod/ContinuousQueryView.h"
 
 #include "infinispan/hotrod/JBasicMarshaller.h"
 #include <vector>
 #include <tuple>
+#include <chrono>
+#include <thread>
 
 #define PROTOBUF_METADATA_CACHE_NAME "___protobuf_metadata"
 #define ERRORS_KEY_SUFFIX  ".errors"
@@ -127,9 +130,15 @@ int main(int argc, char** argv) {
         cql.setJoiningListener(join);
         cql.setLeavingListener(leave);
         cql.setUpdatedListener(change);
+        // Cached query results must not survive the changes seen by the listener
+        testCache.enableQueryCache(1, HOURS);
+        testCache.invalidateQueryCacheOn(cql);
         testCache.addContinuousQueryListener(cql);
         r.add([&testCache,&cql]()
-        {   testCache.removeContinuousQueryListener(cql);});
+        {   testCache.removeContinuousQueryListener(cql); testCache.disableQueryCache();});
+        QueryRequest qr;
+        qr.set_querystring("from sample_bank_account.User");
+        int before = testCache.query(qr).results_size();
         sample_bank_account::User_Address a;
         sample_bank_account::User user1;
         user1.set_id(1);
@@ -161,6 +170,11 @@ int main(int argc, char** argv) {
                     << ", " << removedCount << ")" << "  should be (2,1,1)" << std::endl;
             return -1;
         }
+        int after = testCache.query(qr).results_size();
+        if (before != 0 || after != 1) {
+            std::cout << "FAIL: query cache returned " << before << " then " << after << " results, should be 0 then 1" << std::endl;
+            return -1;
+        }
         std::cout << "End Testing query: from sample_bank_account.User" << std::endl;
     }
 
@@ -372,6 +386,47 @@ int main(int argc, char** argv) {
         std::cout << "                          from sample_bank_account.User where name='Mickey'" << std::endl;
     }
 
+    {
+        std::cout << "Testing continuous query view: from sample_bank_account.User where name='Tom'" << std::endl;
+        testCache.clear();
+        sample_bank_account::User user1;
+        user1.set_id(1);
+        user1.set_name("Tom");
+        user1.set_surname("Cat");
+        user1.set_gender(sample_bank_account::User_Gender_MALE);
+        testCache.put(1, user1);
+
+        ContinuousQueryView<int, sample_bank_account::User> view(testCache,
+                "from sample_bank_account.User where name='Tom'");
+        user1.set_id(2);
+        testCache.put(2, user1);
+        user1.set_id(3);
+        user1.set_name("Jerry");
+        testCache.put(3, user1);
+        testCache.remove(1);
+
+        // Events are asynchronous, wait for the view to settle on key 2 only
+        for (int i = 0; i < 100 && (view.size() != 1 || !view.get(2)); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        std::shared_ptr<const ContinuousQueryView<int, sample_bank_account::User>::Snapshot> s = view.snapshot();
+        if (s->size() != 1 || s->get(2) == nullptr || s->get(2)->name() != "Tom" || s->get(1) != nullptr) {
+            std::cout << "FAIL: continuous query view has " << s->size() << " entries, should have only key 2" << std::endl;
+            return -1;
+        }
+        user1.set_id(2);
+        user1.set_surname("Mouse");
+        testCache.put(2, user1);
+        for (int i = 0; i < 100 && view.size() != 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (view.size() != 0 || s->size() != 1) {
+            std::cout << "FAIL: continuous query view should be empty and its old snapshot unchanged" << std::endl;
+            return -1;
+        }
+        std::cout << "End Testing continuous query view" << std::endl;
+    }
+
     std::cout << "PASS: continuous query" << std::endl;
     return result;
 }
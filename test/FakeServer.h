@@ -0,0 +1,716 @@
+/*
+ * FakeServer.h
+ *
+ * A minimal Hot Rod server for the tests that can't count on an Infinispan
+ * server. It speaks the 2.7 and 2.8 protocol over a loopback socket, keeps
+ * caches, counters and prepared transactions in memory, and records every
+ * request so that the tests can check what the client put on the wire.
+ * Client listeners only get the custom events sent by the tests.
+ *
+ * Only the operations used by the tests are implemented, an unknown
+ * operation closes the connection.
+ */
+#ifndef ISPN_HOTROD_TEST_FAKESERVER_H
+#define ISPN_HOTROD_TEST_FAKESERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FakeServer {
+  public:
+    // Opcodes and codes of the protocol, see HotRodConstants.h
+    enum OpCode {
+        PUT = 0x01, GET = 0x03, PING = 0x17, GET_WITH_METADATA = 0x1B,
+        ADD_CLIENT_LISTENER = 0x25, REMOVE_CLIENT_LISTENER = 0x27, GET_ALL = 0x2F,
+        PREPARE = 0x3B, COMMIT = 0x3D, ROLLBACK = 0x3F,
+        COUNTER_CREATE = 0x4B, COUNTER_GET_CONFIGURATION = 0x4D, COUNTER_ADD_AND_GET = 0x52,
+        COUNTER_RESET = 0x54, COUNTER_GET = 0x56, COUNTER_CAS = 0x58, COUNTER_REMOVE = 0x5E
+    };
+    static const uint8_t ERROR_RESPONSE = 0x50;
+    static const uint8_t CACHE_ENTRY_CREATED_EVENT = 0x60;
+    static const uint8_t SERVER_ERROR_STATUS = 0x85;
+    static const int32_t XA_OK = 0;
+    static const int32_t XA_RDONLY = 3;
+
+    // What the server does instead of executing a request, see inject()
+    enum Fault { NONE, XA_CODE, SERVER_ERROR, CLOSE };
+
+    struct Request {
+        uint8_t opCode;
+        std::string cacheName;
+        uint32_t flags;
+        std::vector<char> key;      // the key, the counter name or the listener id
+        std::vector<std::vector<char> > keys;    // get all
+        int64_t delta;              // counter add, the expected value of a compare and swap
+        int64_t update;             // compare and swap
+        bool onePhase;              // prepare
+        std::vector<std::vector<char> > modifiedKeys;    // prepare
+        std::vector<std::vector<char> > writtenValues;   // prepare, the values of the modifications that aren't removals
+        bool pipelined;             // the next request was received before this one was answered
+    };
+
+    struct Counter {
+        std::vector<char> configuration;    // as sent by the client
+        int64_t value;
+    };
+
+    FakeServer() : listener(-1), stopped(false) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (bind(listener, (sockaddr*) &addr, sizeof(addr)) != 0 || listen(listener, 64) != 0
+                || getsockname(listener, (sockaddr*) &addr, &len) != 0) {
+            throw std::runtime_error("FakeServer: unable to listen");
+        }
+        port = ntohs(addr.sin_port);
+        acceptor = std::thread(&FakeServer::acceptLoop, this);
+    }
+
+    ~FakeServer() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopped = true;
+            for (size_t i = 0; i < connections.size(); i++) {
+                shutdown(connections[i], SHUT_RDWR);
+            }
+        }
+        shutdown(listener, SHUT_RDWR);
+        close(listener);
+        acceptor.join();
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+    int getPort() const { return port; }
+
+    // The requests received so far, in arrival order
+    std::vector<Request> requests() {
+        std::lock_guard<std::mutex> guard(lock);
+        return log;
+    }
+
+    size_t count(uint8_t opCode, const std::string& cacheName = std::string()) {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t n = 0;
+        for (size_t i = 0; i < log.size(); i++) {
+            if (log[i].opCode == opCode && (cacheName.empty() || log[i].cacheName == cacheName)) {
+                n++;
+            }
+        }
+        return n;
+    }
+
+    // The requests of opCode that were followed by another request before being answered
+    size_t pipelined(uint8_t opCode) {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t n = 0;
+        for (size_t i = 0; i < log.size(); i++) {
+            if (log[i].opCode == opCode && log[i].pipelined) {
+                n++;
+            }
+        }
+        return n;
+    }
+
+    void clearLog() {
+        std::lock_guard<std::mutex> guard(lock);
+        log.clear();
+    }
+
+    /*
+     * Makes every following opCode request on cacheName fail: XA_CODE answers a transaction
+     * request with code, SERVER_ERROR sends an error response, CLOSE drops the connection.
+     * NONE removes the fault.
+     */
+    void inject(uint8_t opCode, const std::string& cacheName, Fault fault, int32_t code = 0) {
+        std::lock_guard<std::mutex> guard(lock);
+        faults[std::make_pair(opCode, cacheName)] = std::make_pair(fault, code);
+    }
+
+    // The value stored in a cache, empty if missing
+    std::vector<char> stored(const std::string& cacheName, const std::vector<char>& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::map<std::vector<char>, Entry>& cache = caches[cacheName];
+        std::map<std::vector<char>, Entry>::iterator it = cache.find(key);
+        return it != cache.end() ? it->second.value : std::vector<char>();
+    }
+
+    int64_t counterValue(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock);
+        return counters[std::vector<char>(name.begin(), name.end())].value;
+    }
+
+    // The custom events sent to every listener added from now on, before the response to the add
+    void setCurrentState(const std::vector<std::vector<char> >& events) {
+        std::lock_guard<std::mutex> guard(lock);
+        currentState = events;
+    }
+
+    // The ids of the listeners added and not removed, or dropped
+    std::vector<std::vector<char> > listenerIds() {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::vector<char> > ids;
+        for (std::map<std::vector<char>, int>::iterator it = listeners.begin(); it != listeners.end(); ++it) {
+            ids.push_back(it->first);
+        }
+        return ids;
+    }
+
+    void sendCustomEvent(const std::vector<char>& listenerId, const std::vector<char>& data) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::map<std::vector<char>, int>::iterator it = listeners.find(listenerId);
+        if (it != listeners.end()) {
+            Output out;
+            customEvent(out, 0, listenerId, data);
+            send(it->second, out);
+        }
+    }
+
+    // Closes the connections of the listeners and forgets them, as a crashed server would
+    void dropListeners() {
+        std::lock_guard<std::mutex> guard(lock);
+        for (std::map<std::vector<char>, int>::iterator it = listeners.begin(); it != listeners.end(); ++it) {
+            shutdown(it->second, SHUT_RDWR);
+        }
+        listeners.clear();
+    }
+
+  private:
+    struct Entry {
+        std::vector<char> value;
+        int64_t version;
+    };
+    struct Modification {
+        std::vector<char> key;
+        bool remove;
+        std::vector<char> value;
+    };
+
+    // Reads the request of a connection, throws when the peer is gone
+    class Input {
+      public:
+        Input(int fd) : fd(fd), pos(0), end(0) {}
+
+        // Whether received bytes are waiting to be read
+        bool buffered() const {
+            return pos < end;
+        }
+
+        uint8_t byte() {
+            if (pos == end) {
+                ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    throw std::runtime_error("closed");
+                }
+                pos = 0;
+                end = (size_t) n;
+            }
+            return (uint8_t) buffer[pos++];
+        }
+        uint32_t vint() {
+            uint32_t result = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t b = byte();
+                result |= (uint32_t) (b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return result;
+                }
+            }
+        }
+        uint64_t vlong() {
+            uint64_t result = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t b = byte();
+                result |= (uint64_t) (b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return result;
+                }
+            }
+        }
+        int64_t int64() {
+            uint64_t result = 0;
+            for (int i = 0; i < 8; i++) {
+                result = (result << 8) | byte();
+            }
+            return (int64_t) result;
+        }
+        std::vector<char> array() {
+            std::vector<char> result(vint());
+            for (size_t i = 0; i < result.size(); i++) {
+                result[i] = (char) byte();
+            }
+            return result;
+        }
+        void mediaType() {
+            uint8_t kind = byte();
+            if (kind == 0) {
+                return;
+            }
+            if (kind == 1) {
+                vint();
+            } else {
+                array();
+            }
+            for (uint32_t params = vint(); params > 0; params--) {
+                array();
+                array();
+            }
+        }
+        void expiration() {
+            uint8_t units = byte();
+            if ((units >> 4) != 0x07 && (units >> 4) != 0x08) {
+                vlong();
+            }
+            if ((units & 0x0F) != 0x07 && (units & 0x0F) != 0x08) {
+                vlong();
+            }
+        }
+
+      private:
+        int fd;
+        char buffer[4096];
+        size_t pos, end;
+    };
+
+    class Output {
+      public:
+        std::vector<char> bytes;
+
+        void byte(uint8_t b) { bytes.push_back((char) b); }
+        void vint(uint64_t v) {
+            while (v >= 0x80) {
+                byte((uint8_t) (v | 0x80));
+                v >>= 7;
+            }
+            byte((uint8_t) v);
+        }
+        void int64(int64_t v) {
+            for (int i = 7; i >= 0; i--) {
+                byte((uint8_t) ((uint64_t) v >> (8 * i)));
+            }
+        }
+        void int32(int32_t v) {
+            for (int i = 3; i >= 0; i--) {
+                byte((uint8_t) ((uint32_t) v >> (8 * i)));
+            }
+        }
+        void array(const std::vector<char>& a) {
+            vint(a.size());
+            bytes.insert(bytes.end(), a.begin(), a.end());
+        }
+    };
+
+    int listener;
+    int port;
+    bool stopped;
+    std::mutex lock;
+    std::thread acceptor;
+    std::vector<std::thread> workers;
+    std::vector<int> connections;
+    std::vector<Request> log;
+    std::map<std::pair<uint8_t, std::string>, std::pair<Fault, int32_t> > faults;
+    std::map<std::string, std::map<std::vector<char>, Entry> > caches;
+    std::map<std::vector<char>, Counter> counters;
+    std::map<std::pair<std::vector<char>, std::string>, std::vector<Modification> > prepared;
+    std::map<std::vector<char>, int> listeners;     // the connection of each listener
+    std::vector<std::vector<char> > currentState;
+    int64_t nextVersion = 1;
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = accept(listener, nullptr, nullptr);
+            std::lock_guard<std::mutex> guard(lock);
+            if (fd < 0 || stopped) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return;
+            }
+            connections.push_back(fd);
+            workers.push_back(std::thread(&FakeServer::serve, this, fd));
+        }
+    }
+
+    void serve(int fd) {
+        Input in(fd);
+        try {
+            while (handle(in, fd)) {
+            }
+        } catch (const std::exception&) {
+            // The client went away
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        connections.erase(std::remove(connections.begin(), connections.end(), fd), connections.end());
+        close(fd);
+    }
+
+    static void send(int fd, const Output& out) {
+        size_t sent = 0;
+        while (sent < out.bytes.size()) {
+            ssize_t n = ::send(fd, out.bytes.data() + sent, out.bytes.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                throw std::runtime_error("closed");
+            }
+            sent += (size_t) n;
+        }
+    }
+
+    static void customEvent(Output& out, uint64_t messageId, const std::vector<char>& listenerId,
+            const std::vector<char>& data) {
+        out.byte(0xA1);
+        out.vint(messageId);
+        out.byte(CACHE_ENTRY_CREATED_EVENT);
+        out.byte(0);
+        out.byte(0);
+        out.array(listenerId);
+        out.byte(1);    // custom
+        out.byte(0);    // not retried
+        out.array(data);
+    }
+
+    static void namedFactory(Input& in) {
+        if (!in.array().empty()) {
+            for (uint8_t params = in.byte(); params > 0; params--) {
+                in.array();
+            }
+        }
+    }
+
+    static std::vector<char> readXid(Input& in) {
+        in.vint();
+        std::vector<char> xid = in.array();
+        std::vector<char> branch = in.array();
+        xid.insert(xid.end(), branch.begin(), branch.end());
+        return xid;
+    }
+
+    // Handles one request, false to close the connection
+    bool handle(Input& in, int fd) {
+        if (in.byte() != 0xA0) {
+            return false;
+        }
+        uint64_t messageId = in.vlong();
+        uint8_t version = in.byte();
+        Request r = Request();
+        r.opCode = in.byte();
+        std::vector<char> name = in.array();
+        r.cacheName.assign(name.begin(), name.end());
+        r.flags = in.vint();
+        in.byte();      // client intelligence
+        in.vint();      // topology id
+        if (version >= 28) {
+            in.mediaType();
+            in.mediaType();
+        }
+
+        // Read the body before taking the lock
+        std::vector<char> value, xid;
+        std::vector<Modification> modifications;
+        switch (r.opCode) {
+        case PUT:
+            r.key = in.array();
+            in.expiration();
+            value = in.array();
+            break;
+        case GET:
+        case GET_WITH_METADATA:
+        case COUNTER_GET_CONFIGURATION:
+        case COUNTER_GET:
+        case COUNTER_RESET:
+        case COUNTER_REMOVE:
+            r.key = in.array();
+            break;
+        case COUNTER_ADD_AND_GET:
+            r.key = in.array();
+            r.delta = in.int64();
+            break;
+        case COUNTER_CAS:
+            r.key = in.array();
+            r.delta = in.int64();
+            r.update = in.int64();
+            break;
+        case GET_ALL:
+            for (uint32_t n = in.vint(); n > 0; n--) {
+                r.keys.push_back(in.array());
+            }
+            break;
+        case COUNTER_CREATE: {
+            r.key = in.array();
+            uint8_t type = in.byte();
+            value.push_back((char) type);
+            Output config;
+            if ((type & 0x03) == 0x01) {
+                config.vint(in.vint());
+            }
+            if ((type & 0x03) == 0x02) {
+                config.int64(in.int64());
+                config.int64(in.int64());
+            }
+            int64_t initial = in.int64();
+            config.int64(initial);
+            value.insert(value.end(), config.bytes.begin(), config.bytes.end());
+            r.delta = initial;
+            break;
+        }
+        case PREPARE: {
+            xid = readXid(in);
+            r.onePhase = in.byte() != 0;
+            for (uint32_t n = in.vint(); n > 0; n--) {
+                Modification m;
+                m.key = in.array();
+                uint8_t control = in.byte();
+                if (!(control & 0x03)) {
+                    in.int64();     // the version read by the transaction
+                }
+                m.remove = (control & 0x04) != 0;
+                if (!m.remove) {
+                    in.expiration();
+                    m.value = in.array();
+                    r.writtenValues.push_back(m.value);
+                }
+                r.modifiedKeys.push_back(m.key);
+                modifications.push_back(m);
+            }
+            break;
+        }
+        case COMMIT:
+        case ROLLBACK:
+            xid = readXid(in);
+            break;
+        case ADD_CLIENT_LISTENER:
+            r.key = in.array();
+            in.byte();      // include current state
+            namedFactory(in);
+            namedFactory(in);
+            in.byte();      // raw data
+            in.vint();      // interests
+            break;
+        case REMOVE_CLIENT_LISTENER:
+            r.key = in.array();
+            break;
+        case PING:
+            break;
+        default:
+            return false;
+        }
+
+        Output out;
+        out.byte(0xA1);
+        out.vint(messageId);
+        r.pipelined = in.buffered();
+        std::lock_guard<std::mutex> guard(lock);
+        log.push_back(r);
+        std::pair<Fault, int32_t> fault(NONE, 0);
+        std::map<std::pair<uint8_t, std::string>, std::pair<Fault, int32_t> >::iterator f =
+                faults.find(std::make_pair(r.opCode, r.cacheName));
+        if (f != faults.end()) {
+            fault = f->second;
+        }
+        if (fault.first == CLOSE) {
+            return false;
+        }
+        if (fault.first == SERVER_ERROR) {
+            out.byte(ERROR_RESPONSE);
+            out.byte(SERVER_ERROR_STATUS);
+            out.byte(0);
+            std::string message("injected failure on " + r.cacheName);
+            out.array(std::vector<char>(message.begin(), message.end()));
+            send(fd, out);
+            return true;
+        }
+        out.byte(r.opCode + 1);
+        std::map<std::vector<char>, Entry>& cache = caches[r.cacheName];
+        std::map<std::vector<char>, Entry>::iterator entry = cache.find(r.key);
+        std::map<std::vector<char>, Counter>::iterator counter = counters.find(r.key);
+        switch (r.opCode) {
+        case PUT:
+            if ((r.flags & 0x01) && entry != cache.end()) {
+                out.byte(0x03);
+                out.byte(0);
+                out.array(entry->second.value);
+            } else {
+                out.byte(0);
+                out.byte(0);
+            }
+            cache[r.key].value = value;
+            cache[r.key].version = nextVersion++;
+            break;
+        case GET:
+            if (entry == cache.end()) {
+                out.byte(0x02);
+                out.byte(0);
+            } else {
+                out.byte(0);
+                out.byte(0);
+                out.array(entry->second.value);
+            }
+            break;
+        case GET_ALL: {
+            out.byte(0);
+            out.byte(0);
+            Output found;
+            uint32_t n = 0;
+            for (size_t i = 0; i < r.keys.size(); i++) {
+                std::map<std::vector<char>, Entry>::iterator e = cache.find(r.keys[i]);
+                if (e != cache.end()) {
+                    found.array(e->first);
+                    found.array(e->second.value);
+                    n++;
+                }
+            }
+            out.vint(n);
+            out.bytes.insert(out.bytes.end(), found.bytes.begin(), found.bytes.end());
+            break;
+        }
+        case GET_WITH_METADATA:
+            if (entry == cache.end()) {
+                out.byte(0x02);
+                out.byte(0);
+            } else {
+                out.byte(0);
+                out.byte(0);
+                out.byte(0x03);     // immortal
+                out.int64(entry->second.version);
+                out.array(entry->second.value);
+            }
+            break;
+        case PREPARE:
+            out.byte(0);
+            out.byte(0);
+            if (fault.first == XA_CODE) {
+                out.int32(fault.second);
+            } else if (modifications.empty()) {
+                out.int32(XA_RDONLY);
+            } else {
+                if (r.onePhase) {
+                    apply(cache, modifications);
+                } else {
+                    prepared[std::make_pair(xid, r.cacheName)] = modifications;
+                }
+                out.int32(XA_OK);
+            }
+            break;
+        case COMMIT:
+        case ROLLBACK:
+            out.byte(0);
+            out.byte(0);
+            if (fault.first == XA_CODE) {
+                out.int32(fault.second);
+            } else {
+                if (r.opCode == COMMIT) {
+                    apply(cache, prepared[std::make_pair(xid, r.cacheName)]);
+                }
+                prepared.erase(std::make_pair(xid, r.cacheName));
+                out.int32(XA_OK);
+            }
+            break;
+        case COUNTER_CREATE:
+            out.byte(counter == counters.end() ? 0x00 : 0x01);
+            out.byte(0);
+            if (counter == counters.end()) {
+                Counter c = { value, r.delta };
+                counters[r.key] = c;
+            }
+            break;
+        case COUNTER_GET_CONFIGURATION:
+            if (counter == counters.end()) {
+                out.byte(0x02);
+                out.byte(0);
+            } else {
+                out.byte(0);
+                out.byte(0);
+                out.bytes.insert(out.bytes.end(), counter->second.configuration.begin(),
+                        counter->second.configuration.end());
+            }
+            break;
+        case COUNTER_GET:
+        case COUNTER_ADD_AND_GET:
+            if (counter == counters.end()) {
+                out.byte(0x02);
+                out.byte(0);
+            } else {
+                counter->second.value += r.delta;
+                out.byte(0);
+                out.byte(0);
+                out.int64(counter->second.value);
+            }
+            break;
+        case COUNTER_CAS:
+            if (counter == counters.end()) {
+                out.byte(0x02);
+                out.byte(0);
+            } else {
+                out.byte(0);
+                out.byte(0);
+                out.int64(counter->second.value);
+                if (counter->second.value == r.delta) {
+                    counter->second.value = r.update;
+                }
+            }
+            break;
+        case COUNTER_RESET:
+            out.byte(0);
+            out.byte(0);
+            break;
+        case COUNTER_REMOVE:
+            out.byte(0);
+            out.byte(0);
+            counters.erase(r.key);
+            break;
+        case ADD_CLIENT_LISTENER: {
+            out.byte(0);
+            out.byte(0);
+            // The current state goes before the response
+            Output events;
+            for (size_t i = 0; i < currentState.size(); i++) {
+                customEvent(events, messageId, r.key, currentState[i]);
+            }
+            out.bytes.insert(out.bytes.begin(), events.bytes.begin(), events.bytes.end());
+            listeners[r.key] = fd;
+            break;
+        }
+        case REMOVE_CLIENT_LISTENER:
+            out.byte(listeners.erase(r.key) > 0 ? 0x00 : 0x02);
+            out.byte(0);
+            break;
+        case PING:
+            out.byte(0);
+            out.byte(0);
+            break;
+        }
+        send(fd, out);
+        return true;
+    }
+
+    void apply(std::map<std::vector<char>, Entry>& cache, const std::vector<Modification>& modifications) {
+        for (size_t i = 0; i < modifications.size(); i++) {
+            if (modifications[i].remove) {
+                cache.erase(modifications[i].key);
+            } else {
+                Entry& e = cache[modifications[i].key];
+                e.value = modifications[i].value;
+                e.version = nextVersion++;
+            }
+        }
+    }
+};
+
+#endif  /* ISPN_HOTROD_TEST_FAKESERVER_H */
@@ -0,0 +1,660 @@
+/*
+ * FakeServerTest.cpp
+ *
+ * Tests of the client against FakeServer, they check both the results and what
+ * was sent on the wire. They don't need an Infinispan server.
+ */
+#include "infinispan/hotrod/ConfigurationBuilder.h"
+#include "infinispan/hotrod/ContinuousQueryView.h"
+#include "infinispan/hotrod/RemoteCacheManager.h"
+#include "infinispan/hotrod/RemoteCounterManager.h"
+#include "infinispan/hotrod/TransactionManager.h"
+#include "infinispan/hotrod/Transactions.h"
+#include "infinispan/hotrod/exceptions.h"
+#include "FakeServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infinispan::hotrod;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            failures++; \
+        } \
+    } while (0)
+
+template <class F> static bool throwsClientException(F f) {
+    try {
+        f();
+    } catch (const HotRodClientException&) {
+        return true;
+    }
+    return false;
+}
+
+static Configuration fakeServerConfiguration(const FakeServer& server) {
+    ConfigurationBuilder builder;
+    builder.addServer().host("127.0.0.1").port(server.getPort());
+    builder.protocolVersion(Configuration::PROTOCOL_VERSION_27);
+    builder.balancingStrategyProducer(nullptr);
+    return builder.build();
+}
+
+static void accumulatingWeakCounterTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCounterManager& counters = manager.getCounterManager();
+    counters.defineCounter("acc", CounterConfiguration(0, 0, 0, 8, CounterType::WEAK, Storage::VOLATILE));
+    // No timer, only the threshold and the reads flush
+    std::shared_ptr<WeakCounter> counter = counters.getAccumulatingWeakCounter("acc", 0, 100);
+
+    // The updates of several threads are summed locally
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([counter] {
+            for (int i = 0; i < 24; i++) {
+                counter->increment();
+            }
+        }));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(server.count(FakeServer::COUNTER_ADD_AND_GET) == 0);
+
+    // The threshold sends all of them in a single delta
+    for (int i = 0; i < 4; i++) {
+        counter->increment();
+    }
+    CHECK(server.count(FakeServer::COUNTER_ADD_AND_GET) == 1);
+    CHECK(server.counterValue("acc") == 100);
+
+    // A read sends the pending updates first
+    counter->add(5);
+    CHECK(server.count(FakeServer::COUNTER_ADD_AND_GET) == 1);
+    CHECK(counter->getValue() == 105);
+    CHECK(server.count(FakeServer::COUNTER_ADD_AND_GET) == 2);
+
+    // One handle per counter, asking it with other settings is an error
+    CHECK(counters.getAccumulatingWeakCounter("acc", 0, 100) == counter);
+    CHECK(throwsClientException([&counters] { counters.getAccumulatingWeakCounter("acc", 0, 10); }));
+
+    // Stopping flushes, then the handle refuses to be used
+    counter->add(7);
+    manager.stop();
+    CHECK(server.counterValue("acc") == 112);
+    CHECK(throwsClientException([counter] { counter->add(1); }));
+    CHECK(throwsClientException([counter] { counter->getValue(); }));
+    for (int i = 0; i < 200; i++) {
+        try {
+            counter->increment();
+        } catch (const HotRodClientException&) {
+        }
+    }
+    CHECK(server.counterValue("acc") == 112);
+    std::cout << "accumulatingWeakCounterTest done" << std::endl;
+}
+
+static void getValuesTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCounterManager& counters = manager.getCounterManager();
+    counters.defineCounter("strong", CounterConfiguration(3, 0, 0, 0, CounterType::UNBOUNDED_STRONG, Storage::VOLATILE));
+    counters.defineCounter("weak", CounterConfiguration(5, 0, 0, 8, CounterType::WEAK, Storage::VOLATILE));
+    std::shared_ptr<WeakCounter> accumulating = counters.getAccumulatingWeakCounter("weak", 0, 100);
+    accumulating->add(2);
+    server.clearLog();
+
+    // One pipelined read per counter, no configuration is fetched, the pending updates are flushed first
+    std::set<std::string> names = { "strong", "weak" };
+    std::map<std::string, long> values = counters.getValues(names);
+    CHECK(values.size() == 2);
+    CHECK(values["strong"] == 3);
+    CHECK(values["weak"] == 7);
+    CHECK(server.count(FakeServer::COUNTER_GET) == 2);
+    CHECK(server.count(FakeServer::COUNTER_GET_CONFIGURATION) == 0);
+    CHECK(server.pipelined(FakeServer::COUNTER_GET) == 1);
+
+    // A missing counter fails the whole batch
+    names.insert("missing");
+    CHECK(throwsClientException([&counters, &names] { counters.getValues(names); }));
+    manager.stop();
+    std::cout << "getValuesTest done" << std::endl;
+}
+
+static void asyncCountersTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCounterManager& counters = manager.getCounterManager();
+    counters.defineCounter("strong", CounterConfiguration(0, 0, 0, 0, CounterType::UNBOUNDED_STRONG, Storage::VOLATILE));
+    counters.defineCounter("weak", CounterConfiguration(5, 0, 0, 8, CounterType::WEAK, Storage::VOLATILE));
+    std::shared_ptr<StrongCounter> strong = counters.getStrongCounter("strong");
+    server.clearLog();
+
+    // The operations queued while others are in flight share a round trip
+    std::vector<std::future<long> > added;
+    for (int i = 0; i < 200; i++) {
+        added.push_back(strong->addAndGetAsync(1));
+    }
+    std::set<long> values;
+    for (auto& f : added) {
+        values.insert(f.get());
+    }
+    CHECK(values.size() == 200 && *values.begin() == 1 && *values.rbegin() == 200);
+    CHECK(server.counterValue("strong") == 200);
+    CHECK(server.count(FakeServer::COUNTER_ADD_AND_GET) == 200);
+    CHECK(server.pipelined(FakeServer::COUNTER_ADD_AND_GET) > 0);
+    CHECK(strong->getValueAsync().get() == 200);
+    CHECK(strong->compareAndSwapAsync(200, 7).get() == 200);
+    CHECK(strong->compareAndSwapAsync(200, 8).get() == 7);
+    CHECK(server.counterValue("strong") == 7);
+
+    // The pending updates of an accumulating counter go before the read
+    std::shared_ptr<WeakCounter> weak = counters.getAccumulatingWeakCounter("weak", 0, 100);
+    weak->add(2);
+    CHECK(weak->getValueAsync().get() == 7);
+
+    // A failure reaches the future of its operation only
+    server.inject(FakeServer::COUNTER_GET, "", FakeServer::SERVER_ERROR);
+    std::future<long> failed = strong->getValueAsync();
+    std::future<long> next = strong->addAndGetAsync(1);
+    CHECK(throwsClientException([&failed] { failed.get(); }));
+    CHECK(next.get() == 8);
+    server.inject(FakeServer::COUNTER_GET, "", FakeServer::NONE);
+
+    // A dropped connection is replaced, the operations on it are retried
+    server.inject(FakeServer::COUNTER_ADD_AND_GET, "", FakeServer::CLOSE);
+    std::future<long> dropped = strong->addAndGetAsync(1);
+    CHECK(throwsClientException([&dropped] { dropped.get(); }));
+    server.inject(FakeServer::COUNTER_ADD_AND_GET, "", FakeServer::NONE);
+    CHECK(strong->addAndGetAsync(1).get() == 9);
+
+    // Stopping completes the queued operations, then refuses new ones
+    std::future<long> queued = strong->addAndGetAsync(1);
+    manager.stop();
+    CHECK(queued.get() == 10);
+    CHECK(throwsClientException([&strong] { strong->getValueAsync(); }));
+    std::cout << "asyncCountersTest done" << std::endl;
+}
+
+static void counterHandlesTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCounterManager& counters = manager.getCounterManager();
+    counters.defineCounter("shared", CounterConfiguration(0, 0, 0, 0, CounterType::UNBOUNDED_STRONG, Storage::VOLATILE));
+    counters.defineCounter("churn", CounterConfiguration(0, 0, 0, 0, CounterType::UNBOUNDED_STRONG, Storage::VOLATILE));
+
+    // Concurrent lookups of a counter all get the same handle
+    std::vector<std::shared_ptr<StrongCounter> > handles(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < handles.size(); t++) {
+        threads.push_back(std::thread([&counters, &handles, t] {
+            handles[t] = counters.getStrongCounter("shared");
+            handles[t]->incrementAndGet();
+        }));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    threads.clear();
+    for (size_t t = 0; t < handles.size(); t++) {
+        CHECK(handles[t] == handles[0]);
+    }
+    CHECK(server.counterValue("shared") == 8);
+    CHECK(throwsClientException([&counters] { counters.getWeakCounter("shared"); }));
+
+    // Lookups racing with removals and definitions of the same counter
+    std::atomic<bool> running(true);
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&counters, &running] {
+            while (running) {
+                try {
+                    counters.getStrongCounter("churn")->getName();
+                } catch (const HotRodClientException&) {
+                    // The counter was not defined at the time
+                }
+            }
+        }));
+    }
+    for (int i = 0; i < 100; i++) {
+        counters.remove("churn");
+        counters.defineCounter("churn", CounterConfiguration(i, 0, 0, 0, CounterType::UNBOUNDED_STRONG, Storage::VOLATILE));
+    }
+    running = false;
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::shared_ptr<StrongCounter> churn = counters.getStrongCounter("churn");
+    CHECK(churn == counters.getStrongCounter("churn"));
+    CHECK(churn->getValue() == 99);
+    manager.stop();
+    std::cout << "counterHandlesTest done" << std::endl;
+}
+
+static std::vector<char> bytes(const std::string& s) {
+    return std::vector<char>(s.begin(), s.end());
+}
+
+static Configuration transactionalConfiguration(const FakeServer& server) {
+    ConfigurationBuilder builder;
+    builder.addServer().host("127.0.0.1").port(server.getPort());
+    builder.protocolVersion(Configuration::PROTOCOL_VERSION_27);
+    builder.balancingStrategyProducer(nullptr);
+    builder.setTransactional(true);
+    return builder.build();
+}
+
+static void transactionFanOutTest() {
+    FakeServer server;
+    RemoteCacheManager manager(transactionalConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& tx1 = manager.getCache<std::string, std::string>("tx1", false);
+    RemoteCache<std::string, std::string>& tx2 = manager.getCache<std::string, std::string>("tx2", false);
+    TransactionManager& tm = manager.getTransactionManager();
+
+    // A failed prepare rolls back the caches that prepared, the others never see the transaction again
+    server.inject(FakeServer::PREPARE, "tx2", FakeServer::SERVER_ERROR);
+    tm.begin();
+    tx1.put("k", "a");
+    tx2.put("k", "b");
+    try {
+        tm.commit();
+        CHECK(false);
+    } catch (const HotRodClientRollbackException& ex) {
+        CHECK(ex.getStatus() == (unsigned int) TransactionRemoteStatus::XA_RBROLLBACK);
+    }
+    CHECK(server.count(FakeServer::PREPARE, "tx1") == 1);
+    CHECK(server.count(FakeServer::ROLLBACK, "tx1") == 1);
+    CHECK(server.count(FakeServer::ROLLBACK, "tx2") == 0);
+    CHECK(server.count(FakeServer::COMMIT) == 0);
+    CHECK(server.stored("tx1", bytes("k")).empty());
+
+    // A negative vote is reported even when another cache failed with an exception
+    server.clearLog();
+    server.inject(FakeServer::PREPARE, "tx1", FakeServer::XA_CODE, (int32_t) TransactionRemoteStatus::XA_HEURHAZ);
+    tm.begin();
+    tx1.put("k", "a");
+    tx2.put("k", "b");
+    try {
+        tm.commit();
+        CHECK(false);
+    } catch (const HotRodClientRollbackException& ex) {
+        CHECK(ex.getStatus() == (unsigned int) TransactionRemoteStatus::XA_HEURHAZ);
+    }
+    CHECK(server.count(FakeServer::ROLLBACK, "tx1") == 1);
+    server.inject(FakeServer::PREPARE, "tx1", FakeServer::NONE);
+    server.inject(FakeServer::PREPARE, "tx2", FakeServer::NONE);
+
+    // Every cache is asked to commit and to roll back even when the first one fails, and the
+    // failure rethrown is the one of the first cache in the transaction's order
+    server.clearLog();
+    server.inject(FakeServer::COMMIT, "tx2", FakeServer::SERVER_ERROR);
+    server.inject(FakeServer::ROLLBACK, "tx1", FakeServer::SERVER_ERROR);
+    server.inject(FakeServer::ROLLBACK, "tx2", FakeServer::SERVER_ERROR);
+    std::string first = (RemoteCacheBase*) &tx1 < (RemoteCacheBase*) &tx2 ? "tx1" : "tx2";
+    std::string rethrown;
+    // Own thread, the failed rollback leaves the transaction of the thread behind
+    std::thread([&] {
+        tm.begin();
+        tx1.put("k", "a");
+        tx2.put("k", "b");
+        try {
+            tm.commit();
+        } catch (const HotRodClientException& ex) {
+            rethrown = ex.what();
+        }
+    }).join();
+    CHECK(rethrown == "injected failure on " + first);
+    CHECK(server.count(FakeServer::COMMIT, "tx1") == 1);
+    CHECK(server.count(FakeServer::COMMIT, "tx2") >= 1);
+    CHECK(server.count(FakeServer::ROLLBACK, "tx1") >= 1);
+    CHECK(server.count(FakeServer::ROLLBACK, "tx2") >= 1);
+    manager.stop();
+    std::cout << "transactionFanOutTest done" << std::endl;
+}
+
+// The last opCode request received for cacheName
+static FakeServer::Request lastRequest(FakeServer& server, uint8_t opCode, const std::string& cacheName) {
+    std::vector<FakeServer::Request> log = server.requests();
+    for (size_t i = log.size(); i > 0; i--) {
+        if (log[i - 1].opCode == opCode && log[i - 1].cacheName == cacheName) {
+            return log[i - 1];
+        }
+    }
+    return FakeServer::Request();
+}
+
+static void onePhaseCommitTest() {
+    FakeServer server;
+    RemoteCacheManager manager(transactionalConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& tx1 = manager.getCache<std::string, std::string>("tx1", false);
+    RemoteCache<std::string, std::string>& tx2 = manager.getCache<std::string, std::string>("tx2", false);
+    RemoteCache<std::string, std::string>& tx3 = manager.getCache<std::string, std::string>("tx3", false);
+    TransactionManager& tm = manager.getTransactionManager();
+    tm.begin();
+    tx2.put("r", "read");
+    tm.commit();
+
+    // A single cache with changes commits in one round trip, the caches only read are left out
+    server.clearLog();
+    tm.begin();
+    tx1.put("k", "one");
+    std::unique_ptr<std::string> read(tx2.get("r"));
+    CHECK(read && *read == "read");
+    tm.commit();
+    CHECK(server.count(FakeServer::PREPARE, "tx1") == 1);
+    CHECK(lastRequest(server, FakeServer::PREPARE, "tx1").onePhase);
+    CHECK(server.count(FakeServer::PREPARE, "tx2") == 0);
+    CHECK(server.count(FakeServer::COMMIT) == 0);
+    CHECK(server.stored("tx1", bytes("k")) == bytes("one"));
+
+    // A transaction that only read has nothing to send
+    server.clearLog();
+    tm.begin();
+    read.reset(tx2.get("r"));
+    read.reset(tx1.get("k"));
+    tm.commit();
+    CHECK(server.count(FakeServer::PREPARE) == 0);
+    CHECK(server.count(FakeServer::COMMIT) == 0);
+    CHECK(server.count(FakeServer::ROLLBACK) == 0);
+
+    // Several caches with changes are prepared and committed, still without the ones only read
+    server.clearLog();
+    tm.begin();
+    tx1.put("k", "two");
+    tx3.put("k", "three");
+    read.reset(tx2.get("r"));
+    tm.commit();
+    CHECK(server.count(FakeServer::PREPARE, "tx1") == 1);
+    CHECK(server.count(FakeServer::PREPARE, "tx3") == 1);
+    CHECK(!lastRequest(server, FakeServer::PREPARE, "tx1").onePhase);
+    CHECK(!lastRequest(server, FakeServer::PREPARE, "tx3").onePhase);
+    CHECK(server.count(FakeServer::COMMIT, "tx1") == 1);
+    CHECK(server.count(FakeServer::COMMIT, "tx3") == 1);
+    CHECK(server.count(FakeServer::PREPARE, "tx2") == 0);
+    CHECK(server.count(FakeServer::COMMIT, "tx2") == 0);
+    CHECK(server.stored("tx1", bytes("k")) == bytes("two"));
+    CHECK(server.stored("tx3", bytes("k")) == bytes("three"));
+    manager.stop();
+    std::cout << "onePhaseCommitTest done" << std::endl;
+}
+
+static int prefixMarshallerCalls = 0;
+
+// Stores the values with a prefix, a value read with the wrong marshaller keeps it
+class PrefixMarshaller: public Marshaller<std::string> {
+  public:
+    void marshall(const std::string& s, std::vector<char>& b) {
+        prefixMarshallerCalls++;
+        b.assign(s.begin(), s.end());
+        b.insert(b.begin(), { 'v', ':' });
+    }
+    std::string* unmarshall(const std::vector<char>& b) {
+        return new std::string(b.begin() + 2, b.end());
+    }
+};
+
+static std::map<std::string, std::string> getAll(RemoteCache<std::string, std::string>& cache,
+        const std::set<std::string>& keys) {
+    std::map<std::string, std::string> result;
+    for (auto& entry : cache.getAll(keys)) {
+        result[*entry.first] = *entry.second;
+    }
+    return result;
+}
+
+static void transactionalGetAllTest() {
+    FakeServer server;
+    RemoteCacheManager manager(transactionalConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& cache = manager.getCache<std::string, std::string>(
+            new BasicMarshaller<std::string>(), &Marshaller<std::string>::destroy, new PrefixMarshaller(),
+            &Marshaller<std::string>::destroy, "tx1", false);
+    TransactionManager& tm = manager.getTransactionManager();
+    cache.put("a", "1");
+    cache.put("b", "2");
+    CHECK(server.stored("tx1", bytes("a")) == bytes("v:1"));
+
+    // Outside a transaction the values are read in bulk, with the value marshaller
+    server.clearLog();
+    std::map<std::string, std::string> values = getAll(cache, { "a", "b", "missing" });
+    CHECK(values.size() == 2);
+    CHECK(values["a"] == "1");
+    CHECK(values["b"] == "2");
+    CHECK(server.count(FakeServer::GET_ALL) == 1);
+
+    // In a transaction each key is read once with its version, pipelined, then the context answers
+    server.clearLog();
+    tm.begin();
+    cache.put("b", "changed");
+    values = getAll(cache, { "a", "b", "missing" });
+    CHECK(values.size() == 2);
+    CHECK(values["a"] == "1");
+    CHECK(values["b"] == "changed");
+    CHECK(server.count(FakeServer::GET_ALL) == 0);
+    CHECK(server.count(FakeServer::GET_WITH_METADATA) == 2);
+    CHECK(server.pipelined(FakeServer::GET_WITH_METADATA) == 1);
+    values = getAll(cache, { "a", "missing" });
+    CHECK(values.size() == 1);
+    CHECK(server.count(FakeServer::GET_WITH_METADATA) == 2);
+    tm.commit();
+    CHECK(server.stored("tx1", bytes("b")) == bytes("v:changed"));
+    manager.stop();
+    std::cout << "transactionalGetAllTest done" << std::endl;
+}
+
+static void prepareValuesTest() {
+    FakeServer server;
+    RemoteCacheManager manager(transactionalConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& cache = manager.getCache<std::string, std::string>(
+            new BasicMarshaller<std::string>(), &Marshaller<std::string>::destroy, new PrefixMarshaller(),
+            &Marshaller<std::string>::destroy, "tx1", false);
+    TransactionManager& tm = manager.getTransactionManager();
+    cache.put("a", "1");
+
+    // The prepare writes the bytes the context took in: as read from the server, or as marshalled
+    // once by the put. Nothing is marshalled again
+    server.clearLog();
+    prefixMarshallerCalls = 0;
+    tm.begin();
+    getAll(cache, { "a" });
+    cache.put("b", "2");
+    tm.commit();
+    CHECK(prefixMarshallerCalls == 1);
+    FakeServer::Request prepare = lastRequest(server, FakeServer::PREPARE, "tx1");
+    CHECK(prepare.modifiedKeys.size() == 2);
+    CHECK(std::count(prepare.writtenValues.begin(), prepare.writtenValues.end(), bytes("v:1")) == 1);
+    CHECK(std::count(prepare.writtenValues.begin(), prepare.writtenValues.end(), bytes("v:2")) == 1);
+    CHECK(server.stored("tx1", bytes("b")) == bytes("v:2"));
+    manager.stop();
+    std::cout << "prepareValuesTest done" << std::endl;
+}
+
+static bool forcesReturnValue(FakeServer& server, const std::string& cacheName) {
+    return (lastRequest(server, FakeServer::PUT, cacheName).flags & FORCE_RETURN_VALUE) != 0;
+}
+
+static void pendingFlagsTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& a = manager.getCache<std::string, std::string>("a", false);
+    RemoteCache<std::string, std::string>& b = manager.getCache<std::string, std::string>("b", false);
+
+    // The flags wait for the next operation on their own cache, another cache doesn't take them
+    a.withFlags(FORCE_RETURN_VALUE);
+    b.put("k", "1");
+    CHECK(!forcesReturnValue(server, "b"));
+    std::unique_ptr<std::string> previous(a.put("k", "1"));
+    CHECK(forcesReturnValue(server, "a"));
+
+    // They are used once
+    previous.reset(a.put("k", "2"));
+    CHECK(!forcesReturnValue(server, "a"));
+
+    // And they belong to the thread that asked for them
+    a.withFlags(FORCE_RETURN_VALUE);
+    std::thread([&a] { std::unique_ptr<std::string> p(a.put("k", "3")); }).join();
+    CHECK(!forcesReturnValue(server, "a"));
+    previous.reset(a.put("k", "4"));
+    CHECK(forcesReturnValue(server, "a"));
+    CHECK(previous && *previous == "3");
+    manager.stop();
+    std::cout << "pendingFlagsTest done" << std::endl;
+}
+
+// A continuous query event for a key joining the result set
+static std::vector<char> joining(const std::string& key, const std::string& value) {
+    org::infinispan::query::remote::client::ContinuousQueryResult result;
+    result.set_resulttype(org::infinispan::query::remote::client::ContinuousQueryResult_ResultType_JOINING);
+    result.set_key(key);
+    result.set_value(value);
+    org::infinispan::protostream::WrappedMessage wrapped;
+    wrapped.set_wrappedmessagebytes(result.SerializeAsString());
+    return bytes(wrapped.SerializeAsString());
+}
+
+template <class F> static bool eventually(F f) {
+    for (int i = 0; i < 100 && !f(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return f();
+}
+
+// The live threads of the process, -1 where they can't be counted
+static int threadCount() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+#endif
+    return -1;
+}
+
+static void timedFlushTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCounterManager& counters = manager.getCounterManager();
+    const int numCounters = 8;
+    for (int i = 0; i < numCounters; i++) {
+        counters.defineCounter("timed" + std::to_string(i),
+                CounterConfiguration(0, 0, 0, 8, CounterType::WEAK, Storage::VOLATILE));
+    }
+
+    // The counters share one flusher thread, each flushed on its own interval
+    int before = threadCount();
+    std::vector<std::shared_ptr<WeakCounter> > handles;
+    for (int i = 0; i < numCounters; i++) {
+        handles.push_back(counters.getAccumulatingWeakCounter("timed" + std::to_string(i), 10 + 5 * i, 1000));
+        handles.back()->add(i + 1);
+    }
+    CHECK(before < 0 || threadCount() == before + 1);
+    CHECK(eventually([&server] {
+        for (int i = 0; i < numCounters; i++) {
+            if (server.counterValue("timed" + std::to_string(i)) != i + 1) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    handles[3]->add(10);
+    CHECK(eventually([&server] { return server.counterValue("timed3") == 14; }));
+
+    // Removed counters leave the timer, stopping joins the thread
+    counters.remove("timed0");
+    manager.stop();
+    std::cout << "timedFlushTest done" << std::endl;
+}
+
+static void continuousQueryViewFailoverTest() {
+    FakeServer server;
+    RemoteCacheManager manager(fakeServerConfiguration(server), false);
+    manager.start();
+    RemoteCache<std::string, std::string>& cache = manager.getCache<std::string, std::string>("cq", false);
+    std::vector<char> current;
+    server.setCurrentState({ joining("a", "1") });
+    {
+        ContinuousQueryView<std::string, std::string> view(cache, "from Entry");
+        CHECK(view.size() == 1 && view.get("a"));
+        std::vector<std::vector<char> > failed = server.listenerIds();
+        CHECK(failed.size() == 1);
+
+        // The view is rebuilt from the state replayed to a new listener
+        server.setCurrentState({ joining("b", "2") });
+        server.dropListeners();
+        CHECK(eventually([&] { return server.listenerIds().size() == 1 && view.get("b"); }));
+        CHECK(view.getResyncCount() == 1);
+        CHECK(view.size() == 1 && !view.get("a"));
+        std::vector<std::vector<char> > ids = server.listenerIds();
+        CHECK(ids.size() == 1 && ids[0] != failed[0]);
+        current = ids.empty() ? std::vector<char>() : ids[0];
+
+        // The failed listener is removed before the new one is added
+        std::vector<FakeServer::Request> log = server.requests();
+        size_t removed = log.size(), added = log.size();
+        for (size_t i = 0; i < log.size(); i++) {
+            if (log[i].opCode == FakeServer::REMOVE_CLIENT_LISTENER && log[i].key == failed[0]) {
+                removed = i;
+            }
+            if (log[i].opCode == FakeServer::ADD_CLIENT_LISTENER && log[i].key == current) {
+                added = i;
+            }
+        }
+        CHECK(removed < added && added < log.size());
+
+        // And the events of the new listener reach the view
+        server.sendCustomEvent(current, joining("c", "3"));
+        CHECK(eventually([&] { return view.size() == 2; }));
+    }
+    // The view is gone with its current listener
+    CHECK(server.listenerIds().empty());
+    CHECK(lastRequest(server, FakeServer::REMOVE_CLIENT_LISTENER, "cq").key == current);
+    CHECK(server.count(FakeServer::ADD_CLIENT_LISTENER) == 2);
+    manager.stop();
+    std::cout << "continuousQueryViewFailoverTest done" << std::endl;
+}
+
+int main(int, char**) {
+    accumulatingWeakCounterTest();
+    timedFlushTest();
+    getValuesTest();
+    asyncCountersTest();
+    counterHandlesTest();
+    transactionFanOutTest();
+    onePhaseCommitTest();
+    transactionalGetAllTest();
+    prepareValuesTest();
+    pendingFlagsTest();
+    continuousQueryViewFailoverTest();
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
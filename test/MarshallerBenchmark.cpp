@@ -0,0 +1,97 @@
+/*
+ * MarshallerBenchmark.cpp
+ *
+ * Measures ProtoStreamMarshaller throughput on ~1KB messages against the
+ * two-pass WrappedMessage encoding it replaced. Doesn't need a server.
+ *
+ * usage: marshallerBenchmark [iterations]
+ */
+#include "bank.pb.h"
+#include "infinispan/hotrod/ProtoStreamMarshaller.h"
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace infinispan::hotrod;
+
+// The encoding used before the single pass envelope, kept as the baseline
+static void legacyMarshall(const sample_bank_account::User& obj, std::vector<char>& b) {
+    std::vector<char> msg(obj.ByteSizeLong());
+    obj.SerializeToArray(msg.data(), (int) msg.size());
+    WrappedMessage wm;
+    wm.set_wrappedmessagebytes(msg.data(), msg.size());
+    wm.set_wrappeddescriptorid(1000042);
+    b.resize(wm.ByteSizeLong());
+    wm.SerializeToArray(b.data(), (int) b.size());
+}
+
+static sample_bank_account::User* legacyUnmarshall(const std::vector<char>& b) {
+    WrappedMessage wm;
+    wm.ParseFromArray(b.data(), (int) b.size());
+    const std::string& wmb = wm.wrappedmessagebytes();
+    sample_bank_account::User* user = new sample_bank_account::User();
+    user->ParseFromArray(wmb.data(), (int) wmb.size());
+    return user;
+}
+
+static sample_bank_account::User sampleUser() {
+    sample_bank_account::User user;
+    user.set_id(42);
+    user.set_name("Tom");
+    user.set_surname("Cat");
+    user.set_gender(sample_bank_account::User_Gender_MALE);
+    user.set_notes(std::string(800, 'n'));
+    for (int i = 0; i < 8; i++) {
+        user.add_accountids(i);
+        sample_bank_account::User_Address* a = user.add_addresses();
+        a->set_street("Via Roma");
+        a->set_postcode("00100");
+        a->set_number(i);
+    }
+    return user;
+}
+
+template <class F> static double nanosPerOp(int iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        f();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    sample_bank_account::User user = sampleUser();
+    ProtoStreamMarshaller<sample_bank_account::User> marshaller;
+    std::vector<char> buf;
+    size_t checksum = 0;
+
+    marshaller.marshall(user, buf);
+    std::cout << "message size: " << buf.size() << " bytes, " << iterations << " iterations" << std::endl;
+
+    double legacyWrite = nanosPerOp(iterations, [&]() { legacyMarshall(user, buf); checksum += buf.size(); });
+    double write = nanosPerOp(iterations, [&]() { marshaller.marshall(user, buf); checksum += buf.size(); });
+    double legacyRead = nanosPerOp(iterations, [&]() {
+        std::unique_ptr<sample_bank_account::User> u(legacyUnmarshall(buf));
+        checksum += u->id();
+    });
+    double read = nanosPerOp(iterations, [&]() {
+        std::unique_ptr<sample_bank_account::User> u(marshaller.unmarshall(buf));
+        checksum += u->id();
+    });
+    sample_bank_account::User reused;
+    double readInto = nanosPerOp(iterations, [&]() {
+        marshaller.unmarshallInto(buf.data(), buf.size(), reused);
+        checksum += reused.id();
+    });
+
+    std::cout << "marshall        two-pass " << legacyWrite << " ns/op, single-pass " << write << " ns/op" << std::endl;
+    std::cout << "unmarshall      two-pass " << legacyRead << " ns/op, single-pass " << read << " ns/op" << std::endl;
+    std::cout << "unmarshallInto  single-pass " << readInto << " ns/op" << std::endl;
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}
@@ -155,6 +155,40 @@ int main(int argc, char** argv) {
                     << ",surname=" << res[i].surname() << ")" << std::endl;
         }
     }
+
+    {
+        QueryRequest qr;
+        qr.set_querystring("from sample_bank_account.User");
+        // A page size of one exercises the page prefetching
+        QueryCursor<sample_bank_account::User> cursor = testCache.queryCursor<sample_bank_account::User>(qr, 1);
+        int count = 0;
+        while (cursor.hasNext()) {
+            const sample_bank_account::User& u = cursor.next();
+            std::cout << "User(id=" << u.id() << ",name=" << u.name() << ")" << std::endl;
+            ++count;
+        }
+        if (count != 2) {
+            std::cerr << "fail: query cursor expected 2 got " << count << std::endl;
+            result = -1;
+            return result;
+        }
+    }
+
+    {
+        QueryRequest qr;
+        qr.set_querystring("from sample_bank_account.User");
+        testCache.enableQueryCache(30, SECONDS);
+        testCache.query(qr);
+        QueryResponse resp = testCache.query(qr);
+        std::map<std::string, std::string> stats = testCache.stats();
+        testCache.disableQueryCache();
+        if (resp.results_size() != 2 || stats["queryCacheHits"] != "1" || stats["queryCacheMisses"] != "1") {
+            std::cerr << "fail: query cache expected 1 hit and 1 miss, got " << stats["queryCacheHits"] << " and "
+                    << stats["queryCacheMisses"] << std::endl;
+            result = -1;
+            return result;
+        }
+    }
 #if !defined (_MSC_VER) || (_MSC_VER>=1800)
     {
         QueryRequest qr;
@@ -196,6 +230,21 @@ int main(int argc, char** argv) {
             std::cout << std::get < 0 > (prjRes[i]) << "  "
                 << std::get<1>(prjRes[i]) << "  " << std::endl;
         }
+
+        ProjectionColumns columns;
+        if (!columns.unwrap(resp) || columns.getRowCount() != prjRes.size()) {
+            std::cerr << "fail: columnar projection doesn't match" << std::endl;
+            result = -1;
+            return result;
+        }
+        for (unsigned int i = 0; i < prjRes.size(); i++) {
+            if (columns.getStrings(0).get(i) != std::get<0>(prjRes[i])
+                    || columns.getIntegers(1)[i] != std::get<1>(prjRes[i])) {
+                std::cerr << "fail: columnar projection row " << i << " doesn't match" << std::endl;
+                result = -1;
+                return result;
+            }
+        }
     }
 #endif
     {
@@ -0,0 +1,165 @@
+/*
+ * SocketBenchmark.cpp
+ *
+ * Measures the client side of large value puts and gets: the request of a put
+ * is written through the output stream of the transport, as TcpTransport does,
+ * and the response of a get is read back through the input stream. The socket
+ * copies the bytes to and from memory like the kernel would, so only the copies
+ * and the calls made by the streams are measured. Doesn't need a server.
+ *
+ * usage: socketBenchmark [megabytes per value size]
+ */
+#include "hotrod/impl/transport/tcp/Socket.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace infinispan::hotrod;
+
+// Copies the written bytes into a buffer of the size of a socket send buffer,
+// and serves reads from a response at most a receive buffer at a time
+class MemorySocket : public sys::Socket {
+  public:
+    static const size_t KernelBufferSize = 256 * 1024;
+
+    MemorySocket() : sink(KernelBufferSize), written(0), position(0) {}
+
+    void connect(const std::string&, int, int) {}
+    void close() {}
+    void setTcpNoDelay(bool) {}
+    void setTimeout(int) {}
+    int getSocket() { return -1; }
+
+    void write(const char *p, size_t n) {
+        written += n;
+        while (n > 0) {
+            size_t chunk = std::min(n, KernelBufferSize);
+            memcpy(sink.data(), p, chunk);
+            p += chunk;
+            n -= chunk;
+        }
+    }
+
+    size_t read(char *p, size_t n) {
+        if (position == response.size()) {
+            position = 0;
+        }
+        size_t chunk = std::min(std::min(n, KernelBufferSize), response.size() - position);
+        memcpy(p, response.data() + position, chunk);
+        position += chunk;
+        return chunk;
+    }
+
+    std::vector<char> sink;
+    size_t written;
+    std::vector<char> response;
+    size_t position;
+};
+
+const size_t MemorySocket::KernelBufferSize;
+
+static void writeVInt(transport::OutputStream& out, size_t value) {
+    while (value > 0x7F) {
+        out.write((char) ((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.write((char) value);
+}
+
+static size_t readVInt(transport::InputStream& in) {
+    size_t result = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = (uint8_t) in.read();
+        result |= (size_t) (b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return result;
+        }
+    }
+}
+
+// A put of protocol 2.8, byte by byte for the header as the codec writes it
+static void writePut(transport::OutputStream& out, uint64_t messageId, const std::vector<char>& cacheName,
+        const std::vector<char>& key, const std::vector<char>& value) {
+    out.write((char) 0xA0);
+    writeVInt(out, messageId);
+    out.write((char) 28);
+    out.write((char) 0x01);
+    writeVInt(out, cacheName.size());
+    out.write(cacheName.data(), cacheName.size());
+    writeVInt(out, 0);      // flags
+    out.write((char) 3);    // intelligence
+    writeVInt(out, 0);      // topology id
+    out.write((char) 0);    // key media type
+    out.write((char) 0);    // value media type
+    writeVInt(out, key.size());
+    out.write(key.data(), key.size());
+    out.write((char) 0x77); // default expiration
+    writeVInt(out, value.size());
+    out.write(value.data(), value.size());
+    out.flush();
+}
+
+// The response of a get: magic, message id, opcode, status, topology marker, then the value
+static std::vector<char> getResponse(size_t valueSize) {
+    std::vector<char> response = { (char) 0xA1, 1, 0x04, 0, 0 };
+    for (size_t value = valueSize; ; value >>= 7) {
+        if (value > 0x7F) {
+            response.push_back((char) ((value & 0x7F) | 0x80));
+        } else {
+            response.push_back((char) value);
+            break;
+        }
+    }
+    response.resize(response.size() + valueSize, 'v');
+    return response;
+}
+
+static void readGet(transport::InputStream& in, std::vector<char>& value) {
+    for (int i = 0; i < 5; i++) {
+        in.read();
+    }
+    value.resize(readVInt(in));
+    in.read(value.data(), value.size());
+}
+
+template <class F> static double gigabytesPerSecond(size_t bytes, int iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        f();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double) bytes * iterations / std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? (size_t) atoi(argv[1]) : 512;
+    std::vector<char> cacheName(8, 'c');
+    std::vector<char> key(16, 'k');
+    const size_t sizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+    std::cout << megabytes << " MB of values per size" << std::endl;
+    for (size_t size : sizes) {
+        MemorySocket* memory = new MemorySocket();
+        transport::Socket socket(memory);
+        memory->response = getResponse(size);
+        std::vector<char> value(size, 'v');
+        std::vector<char> read;
+        int iterations = (int) std::max((size_t) 1, megabytes * 1024 * 1024 / size);
+        uint64_t messageId = 0;
+
+        // Warm up the buffers of the streams
+        writePut(socket.getOutputStream(), ++messageId, cacheName, key, value);
+        readGet(socket.getInputStream(), read);
+
+        double put = gigabytesPerSecond(size, iterations, [&]() {
+            writePut(socket.getOutputStream(), ++messageId, cacheName, key, value);
+        });
+        double get = gigabytesPerSecond(size, iterations, [&]() {
+            readGet(socket.getInputStream(), read);
+        });
+        std::cout << size / 1024 << " KiB values: put " << put << " GB/s, get " << get << " GB/s" << std::endl;
+    }
+    return 0;
+}
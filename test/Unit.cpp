@@ -1,5 +1,8 @@
 #include "infinispan/hotrod/ImportExport.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
 
 /* The tests using internal classes are compiled directly into the shared library/DLL,
    this binary just runs them */
@@ -19,6 +22,52 @@ HR_EXTERN void testMaxTotal();
 HR_EXTERN void testMaxTotal2();
 HR_EXTERN void testMaxTotal3();
 HR_EXTERN void testMaxTotal4();
+HR_EXTERN void testPoolSlot();
+HR_EXTERN void testReadOwnerChoice();
+HR_EXTERN void testIncrementalServers();
+HR_EXTERN void allocationFreeHeaderTest(unsigned long (*allocationCount)());
+HR_EXTERN void allocationFreeOperationTest(unsigned long (*allocationCount)());
+HR_EXTERN void outputStreamTest();
+HR_EXTERN void bufferMarshallerTest(unsigned long (*allocationCount)());
+HR_EXTERN void protoStreamMarshallerTest();
+HR_EXTERN void queryResultSetTest();
+HR_EXTERN void queryCursorTest();
+HR_EXTERN void projectionColumnsTest();
+HR_EXTERN void queryResultCacheTest();
+HR_EXTERN void transactionContextTest();
+HR_EXTERN void segmentRoutingTest();
+HR_EXTERN void topologySnapshotTest();
+HR_EXTERN void latencyAwareBalancingTest();
+
+/* Counts the heap allocations made by the process, library included, so the tests can
+   check that the request path doesn't allocate. A Windows DLL has its own operator new,
+   there the allocations made inside the library aren't counted */
+static std::atomic<unsigned long> allocations(0);
+
+static unsigned long allocationCount() {
+    return allocations.load();
+}
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
 
 int main(int, char**) {
     runConcurrentCodecWritesTest();
@@ -36,5 +85,21 @@ int main(int, char**) {
     testMaxTotal2();
     testMaxTotal3();
     testMaxTotal4();
+    testPoolSlot();
+    testReadOwnerChoice();
+    testIncrementalServers();
+    allocationFreeHeaderTest(allocationCount);
+    allocationFreeOperationTest(allocationCount);
+    outputStreamTest();
+    bufferMarshallerTest(allocationCount);
+    protoStreamMarshallerTest();
+    queryResultSetTest();
+    queryCursorTest();
+    projectionColumnsTest();
+    queryResultCacheTest();
+    transactionContextTest();
+    segmentRoutingTest();
+    topologySnapshotTest();
+    latencyAwareBalancingTest();
     return 0;
 }
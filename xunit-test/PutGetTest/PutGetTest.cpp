@@ -50,3 +50,37 @@ TEST_F(PutGetTest, SimplePutForcedReturnReturnsPrevVal) {
     std::unique_ptr<std::string> ret(cache.put("k1","v1"));
     EXPECT_TRUE(prevVal==ret || *prevVal==*ret);
 }
+
+TEST_F(PutGetTest, GetIntoReusesCallerBuffer) {
+	PutGetTest::remoteCacheManager->start();
+    BasicMarshaller<std::string> *km = new BasicMarshaller<std::string>();
+    BasicMarshaller<std::string> *vm = new BasicMarshaller<std::string>();
+    RemoteCache<std::string, std::string> cache = PutGetTest::remoteCacheManager->getCache<std::string, std::string>(km,
+            &Marshaller<std::string>::destroy,
+            vm,
+            &Marshaller<std::string>::destroy, "default", true);
+    cache.put("k1", "v1");
+    std::vector<char> buf;
+    EXPECT_TRUE(cache.getInto("k1", buf));
+    EXPECT_EQ(std::string("v1"), std::string(buf.data(), buf.size()));
+    cache.remove("k1");
+    EXPECT_FALSE(cache.getInto("k1", buf));
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST_F(PutGetTest, GetIntoExistingStorage) {
+	PutGetTest::remoteCacheManager->start();
+    BasicMarshaller<std::string> *km = new BasicMarshaller<std::string>();
+    BasicMarshaller<std::string> *vm = new BasicMarshaller<std::string>();
+    RemoteCache<std::string, std::string> cache = PutGetTest::remoteCacheManager->getCache<std::string, std::string>(km,
+            &Marshaller<std::string>::destroy,
+            vm,
+            &Marshaller<std::string>::destroy, "default", true);
+    cache.put("k1", "v1");
+    std::string value("unchanged");
+    EXPECT_TRUE(cache.get("k1", value));
+    EXPECT_EQ("v1", value);
+    cache.remove("k1");
+    EXPECT_FALSE(cache.get("k1", value));
+    EXPECT_EQ("v1", value);
+}
@@ -274,6 +274,28 @@ TEST_F(QueryTest, getAll)
     EXPECT_EQ(3, vectorOfUsers.size());
 }
 
+TEST_F(QueryTest, getAllOnArena)
+{
+    auto *testkm = new BasicTypesProtoStreamMarshaller<int>();
+    auto *testvm = new ProtoStreamMarshaller<sample_bank_account::User>();
+    RemoteCache<int, sample_bank_account::User> userCache =
+            remoteCacheManager->getCache<int, sample_bank_account::User>(
+                    testkm, &Marshaller<int>::destroy, testvm, &Marshaller<sample_bank_account::User>::destroy,
+                    NAMED_CACHE, false);
+    QueryRequest qr;
+    qr.set_querystring("from sample_bank_account.User");
+    QueryResultSet<sample_bank_account::User> users;
+    if (!userCache.query(qr, users)) {
+        FAIL()<< "fail: found unexpected projection in resultset"
+        << std::endl;
+    }
+    EXPECT_EQ(3, users.size());
+    EXPECT_EQ(3, users.getTotalResults());
+    for (const sample_bank_account::User& user : users) {
+        EXPECT_EQ(&users.getArena(), user.GetArena());
+    }
+}
+
 TEST_F(QueryTest, Eq1Test)
 {
     auto *testkm = new BasicTypesProtoStreamMarshaller<int>();